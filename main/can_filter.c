@@ -0,0 +1,188 @@
+/*********************
+ *      INCLUDES
+ *********************/
+#include <string.h>
+#include <stdlib.h>
+
+#include "can_filter.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+#define PGN_MAX                 (0x3FFFF)
+
+// Bits No PGN Pins Down, Priority And Source Address, Plus PS For PDU1
+#define ID_ANY                  (0x1C0000FFu)
+#define ID_PDU1_DA              (0x0000FF00u)
+#define ID_MASK                 (0x1FFFFFFFu)
+
+// Dual Filters Only See ID28..ID13 Of An Extended Frame
+#define DUAL_SHIFT              (13)
+#define DUAL_MASK               (0xFFFFu)
+
+// Beyond This Many PGNs The Split Is Only Tried Between Neighbours
+#define SPLIT_EXHAUSTIVE_MAX    (12)
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/**********************
+ *      MACROS
+ **********************/
+
+/**********************
+ *     GLOBALS
+ **********************/
+
+/**********************
+ *     CONSTANTS
+ **********************/
+
+/**********************
+ *    PROTOTYPES
+ **********************/
+static uint32_t can_filter_dont_care( const uint32_t * ids, uint32_t cnt, uint32_t sel, bool want );
+static uint64_t can_filter_dual_cost( uint32_t dont_care );
+static int can_filter_id_cmp( const void * a, const void * b );
+
+void can_filter_init( can_filter_t * filter )
+{
+    memset( filter, 0, sizeof( *filter ) );
+
+    filter->accept_all  = true;
+    filter->single      = true;
+    filter->code        = 0;
+    filter->mask        = 0xFFFFFFFF;
+    filter->hw_id_cnt   = ID_MASK + 1;
+}
+
+bool can_filter_build( can_filter_t * filter, const uint32_t * pgns, uint32_t cnt )
+{
+    uint32_t                ids[CAN_FILTER_PGN_MAX];
+    uint32_t                dc;
+    uint32_t                best_sel = 0;
+    uint64_t                best;
+    uint64_t                cost;
+
+    can_filter_init( filter );
+    if( 0 == cnt ) {
+        return true;
+    }
+    if( cnt > CAN_FILTER_PGN_MAX ) {
+        return false;
+    }
+
+    for( uint32_t i = 0; i < cnt; i++ ) {
+        if( pgns[i] > PGN_MAX ) {
+            return false;
+        }
+        ids[i] = can_filter_id_pgn( pgns[i] << 8 ) << 8;
+    }
+    qsort( ids, cnt, sizeof( ids[0] ), can_filter_id_cmp );
+
+    // One Filter Over The Whole Identifier
+    dc   = can_filter_dont_care( ids, cnt, 0, false );
+    best = 1ull << __builtin_popcount( dc );
+
+    /*
+     * Two Filters, Each Taking A Group. Bit i Of sel Puts ids[i] In The Second
+     * Group, The Last One Always Goes There So Every Split Is Only Tried Once.
+     */
+    if( cnt > 1 ) {
+        uint32_t    last = 1u << ( cnt - 1 );
+        uint32_t    sel_cnt = ( cnt <= SPLIT_EXHAUSTIVE_MAX ) ? last : cnt - 1;
+
+        for( uint32_t i = 0; i < sel_cnt; i++ ) {
+            // Past The Exhaustive Range, Sorted Order Keeps Neighbours Close, Cut Once
+            uint32_t    sel = ( cnt <= SPLIT_EXHAUSTIVE_MAX ) ? ( last | i ) : ( 0xFFFFFFFFu << ( i + 1 ) ) & ( ( last << 1 ) - 1 );
+
+            cost = can_filter_dual_cost( can_filter_dont_care( ids, cnt, sel, false ) ) +
+                   can_filter_dual_cost( can_filter_dont_care( ids, cnt, sel, true ) );
+            if( cost < best ) {
+                best     = cost;
+                best_sel = sel;
+            }
+        }
+    }
+
+    filter->accept_all = false;
+    filter->hw_id_cnt  = ( best > ID_MASK + 1ull ) ? ID_MASK + 1 : (uint32_t)best;
+
+    if( 0 == best_sel ) {
+        // ID28..ID0 In Bits 31..3, RTR In Bit 2 Must Be Clear, Bits 1..0 Unused
+        filter->single = true;
+        filter->code   = ( ids[0] & ~dc ) << 3;
+        filter->mask   = ( dc << 3 ) | 0x3;
+    }
+    else {
+        uint32_t    dc_a = can_filter_dont_care( ids, cnt, best_sel, false );
+        uint32_t    dc_b = can_filter_dont_care( ids, cnt, best_sel, true );
+        uint32_t    id_a = ids[__builtin_ctz( ~best_sel )];
+        uint32_t    id_b = ids[__builtin_ctz( best_sel )];
+
+        filter->single = false;
+        filter->code   = ( ( ( id_a & ~dc_a ) >> DUAL_SHIFT ) << 16 ) | ( ( id_b & ~dc_b ) >> DUAL_SHIFT );
+        filter->mask   = ( ( ( dc_a >> DUAL_SHIFT ) & DUAL_MASK ) << 16 ) | ( ( dc_b >> DUAL_SHIFT ) & DUAL_MASK );
+    }
+
+    for( uint32_t i = 0; i < cnt; i++ ) {
+        uint32_t    idx = can_filter_map_idx( ids[i] >> 8 );
+
+        filter->map[idx >> 5] |= 1u << ( idx & 31 );
+    }
+
+    return true;
+}
+
+bool can_filter_hw_accepts( const can_filter_t * filter, uint32_t id )
+{
+    uint32_t    hi = ( id & ID_MASK ) >> DUAL_SHIFT;
+
+    if( filter->single ) {
+        return 0 == ( ( ( ( id & ID_MASK ) << 3 ) ^ filter->code ) & ~filter->mask );
+    }
+
+    return ( 0 == ( ( hi ^ ( filter->code >> 16 ) ) & ~( filter->mask >> 16 ) & DUAL_MASK ) ) ||
+           ( 0 == ( ( hi ^ filter->code ) & ~filter->mask & DUAL_MASK ) );
+}
+
+// Bits That Either Vary Across The Chosen ids Or Are Free In Any Of Them
+static uint32_t can_filter_dont_care( const uint32_t * ids, uint32_t cnt, uint32_t sel, bool want )
+{
+    uint32_t    first = 0;
+    uint32_t    diff = 0;
+    bool        any = false;
+
+    for( uint32_t i = 0; i < cnt; i++ ) {
+        if( ( 0 != ( sel & ( 1u << i ) ) ) != want ) {
+            continue;
+        }
+
+        if( !any ) {
+            first = ids[i];
+            any   = true;
+        }
+
+        diff |= ( ids[i] ^ first ) | ID_ANY;
+        if( ( ( ids[i] >> 16 ) & 0xFF ) < CAN_FILTER_PDU2_PF ) {
+            diff |= ID_PDU1_DA;
+        }
+    }
+
+    return diff;
+}
+
+// Identifiers Let Through By One Dual Filter, The Low 13 Bits Are Never Compared
+static uint64_t can_filter_dual_cost( uint32_t dont_care )
+{
+    return 1ull << ( __builtin_popcount( ( dont_care >> DUAL_SHIFT ) & DUAL_MASK ) + DUAL_SHIFT );
+}
+
+static int can_filter_id_cmp( const void * a, const void * b )
+{
+    uint32_t    ia = *(const uint32_t *)a;
+    uint32_t    ib = *(const uint32_t *)b;
+
+    return ( ia > ib ) - ( ia < ib );
+}
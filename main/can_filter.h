@@ -0,0 +1,102 @@
+#ifndef DASH_CAN_FILTER_H
+#define DASH_CAN_FILTER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdint.h>
+#include <stdbool.h>
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/*
+ * 29 bit J1939 identifier:
+ *
+ *  28..26 priority, 25 EDP, 24 DP, 23..16 PF, 15..8 PS, 7..0 source address
+ *
+ * PGN is EDP, DP, PF and PS, except below PF 240 (PDU1) where PS is the
+ * destination address and the PGN's low byte is 0.
+ */
+#define CAN_FILTER_PDU2_PF      (240)
+
+// Software Map, One Bit Per PDU1 EDP/DP/PF, Then One Per PDU2 EDP/DP/PF/PS
+#define CAN_FILTER_PDU1_CNT     ( 4 * CAN_FILTER_PDU2_PF )
+#define CAN_FILTER_MAP_BITS     ( CAN_FILTER_PDU1_CNT + 4 * ( 256 - CAN_FILTER_PDU2_PF ) * 256 )
+#define CAN_FILTER_MAP_WORDS    ( ( CAN_FILTER_MAP_BITS + 31 ) / 32 )
+
+#define CAN_FILTER_PGN_MAX      (32)
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+typedef struct
+    {
+    bool                    accept_all;     // No PGNs Given, Hardware And Map Both Open
+    bool                    single;         // One Filter On All 29 Bits, Else Two On ID28..ID13
+
+    // Laid Out As The TWAI Driver's acceptance_code / acceptance_mask, Mask Bit Set = Don't Care
+    uint32_t                code;
+    uint32_t                mask;
+    uint32_t                hw_id_cnt;      // Identifiers The Hardware Lets Through, Priority And SA Included
+
+    uint32_t                map[CAN_FILTER_MAP_WORDS];
+    } can_filter_t;
+
+/**********************
+ *      MACROS
+ **********************/
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+static inline uint32_t can_filter_id_pgn( uint32_t id )
+{
+    uint32_t    pgn = ( id >> 8 ) & 0x3FFFF;
+
+    return ( ( ( pgn >> 8 ) & 0xFF ) < CAN_FILTER_PDU2_PF ) ? ( pgn & 0x3FF00 ) : pgn;
+}
+
+static inline uint32_t can_filter_map_idx( uint32_t pgn )
+{
+    uint32_t    dp = ( pgn >> 16 ) & 0x3;
+    uint32_t    pf = ( pgn >> 8 ) & 0xFF;
+
+    if( pf < CAN_FILTER_PDU2_PF ) {
+        return dp * CAN_FILTER_PDU2_PF + pf;
+    }
+
+    return CAN_FILTER_PDU1_CNT + ( ( dp * ( 256 - CAN_FILTER_PDU2_PF ) + ( pf - CAN_FILTER_PDU2_PF ) ) << 8 ) + ( pgn & 0xFF );
+}
+
+// Second Look At What Got Past The Hardware, id Is The Full 29 Bit Identifier
+static inline bool can_filter_accepts( const can_filter_t * filter, uint32_t id )
+{
+    uint32_t    idx = can_filter_map_idx( can_filter_id_pgn( id ) );
+
+    return filter->accept_all || ( filter->map[idx >> 5] & ( 1u << ( idx & 31 ) ) );
+}
+
+/*
+ * Plain C, builds on the host. Picks whichever of one 29 bit filter or two
+ * 16 bit filters lets the fewest identifiers through while passing every PGN
+ * from any source, at any priority and, for PDU1, to any destination.
+ * cnt 0 accepts everything, more than CAN_FILTER_PGN_MAX fails.
+ */
+void can_filter_init( can_filter_t * filter );
+bool can_filter_build( can_filter_t * filter, const uint32_t * pgns, uint32_t cnt );
+
+// What The TWAI Acceptance Filter Would Do With An Extended Frame
+bool can_filter_hw_accepts( const can_filter_t * filter, uint32_t id );
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif //DASH_CAN_FILTER_H
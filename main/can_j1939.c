@@ -1,12 +1,12 @@
-
 /*********************
  *      INCLUDES
  *********************/
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <stdint.h>
 #include <stdbool.h>
-#include <time.h>
-#include <sys/time.h>
+#include <sys/param.h>
 
 #include <pubsub.h>
 #include <j1939.h>
@@ -16,10 +16,16 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/timers.h"
+#include "freertos/semphr.h"
 
 #include "driver/gpio.h"
 #include "driver/can.h"
 
+#include "console_intf.h"
+#include "timebase.h"
+#include "can_filter.h"
+#include "can_signals.h"
+#include "can_tx_queue.h"
 #include "can_j1939.h"
 
 /*********************
@@ -27,9 +33,34 @@
  *********************/
 #define TAG "CAN_J1939"
 
+// Receive Path
+#define RX_QUEUE_LEN            (128)       // ~16 ms Of A Saturated 1 Mbit/s Bus
+#define RX_BATCH_CNT            (32)        // Frames Taken Off The Driver Per Wake
+#define RX_WAIT_MS              (10)        // Longest Sleep, The Stack Still Gets To Run Its Timers
+#define RX_CLAIM_WAIT_MS        (100)       // Before The Task Runs, Address Claim Reads Directly
+#define RX_TASK_PRIORITY        (15)
+#define RX_TASK_CORE            (0)         // LVGL Has Core 1
+
+// Transmit Path, One Frame In The Controller At A Time So Priority Is Decided Here
+#define TX_WAIT_MS              (10)        // Alert Wait, Then Check The Driver Still Has The Frame
+#define TX_TASK_PRIORITY        (14)
+#define TX_TASK_CORE            (0)
+#define TX_ALERTS               ( CAN_ALERT_TX_IDLE | CAN_ALERT_TX_SUCCESS | CAN_ALERT_TX_FAILED )
+
+// Handled Inside libj1939, Let Through Whatever Else Is Asked For
+#define PGN_REQUEST             (59904)
+#define PGN_TP_DT               (60160)
+#define PGN_TP_CM               (60416)
+#define PGN_ADDRESS_CLAIMED     (60928)
+
 /**********************
  *      TYPEDEFS
  **********************/
+typedef struct
+    {
+    can_message_t           msg;
+    int64_t                 t_us;       // Taken Off The Driver Queue
+    } can_j1939_frame_t;
 
 /**********************
  *      MACROS
@@ -39,9 +70,63 @@
  *     GLOBALS
  **********************/
 
+// Frames Drained But Not Yet Handed To libj1939, Only Touched By The RX Task
+static can_j1939_frame_t    g_rx_batch[RX_BATCH_CNT];
+static uint32_t             g_rx_batch_cnt;
+static uint32_t             g_rx_batch_idx;
+static int64_t              g_rx_us;    // Last Frame Handed To libj1939
+static bool                 g_rx_task_running;
+
+// Driver Is Reinstalled To Change Its Filter, Receiving Holds The Lock So It Never Sits In A Queue Being Freed
+static SemaphoreHandle_t    g_driver_lock;
+static SemaphoreHandle_t    g_tx_lock;          // Same For The TX Task, Taken After g_driver_lock
+static bool                 g_driver_installed;
+static can_general_config_t g_driver_config;
+static can_timing_config_t  g_driver_timing;
+
+// Built By j1939_filter(), Off Lets Everything Through Both The Hardware And The Map
+static can_filter_t         g_filter;
+static bool                 g_filter_on = true;
+static uint32_t             g_rx_missed_base;   // Missed Count Of Earlier Installs, The Driver Restarts At 0
+
+// Frames Waiting For The Controller, Any Task May Queue
+static can_tx_queue_t       g_tx_queue;
+static SemaphoreHandle_t    g_tx_queue_lock;    // Also Covers The tx_ Stats
+static TaskHandle_t         g_tx_task;
+
+static can_j1939_stats_t    g_stats;
+
+static struct {
+    struct arg_int *filter;
+    struct arg_lit *signals;
+    struct arg_end *end;
+    } g_can_args;
+
+/**********************
+ *     COMMANDS
+ **********************/
+static int can_cmd(int argc, char **argv);
+
+static esp_console_cmd_t  g_commands[] =
+    {
+    /*            command              help                                     hint        function                args */
+    {   "can",          "J1939 Statistics And Filter",      NULL,       can_cmd,                &g_can_args },
+    };
+
+#define COMMANDS_CNT        ( sizeof(g_commands)/sizeof(g_commands[0]) )
+
 /**********************
  *    PROTOTYPES
  **********************/
+_Noreturn static void can_j1939_rx_task( void * params );
+static void can_j1939_rx_fill( TickType_t wait );
+_Noreturn static void can_j1939_tx_task( void * params );
+static bool can_j1939_driver_install( void );
+static void can_j1939_dispatch( uint32_t pgn, const uint8_t * data, uint32_t len, int64_t t_us );
+
+/**********************
+ *     CONSTANTS
+ **********************/
 
 void can_j1939_start( void )
 {
@@ -51,6 +136,16 @@ void can_j1939_start( void )
 
     ESP_LOGI(TAG, "can j1939 start");
 
+    g_driver_lock = xSemaphoreCreateMutex();
+    g_tx_lock = xSemaphoreCreateMutex();
+    g_tx_queue_lock = xSemaphoreCreateMutex();
+    can_tx_queue_init( &g_tx_queue );
+
+    g_can_args.filter = arg_int0("f", "filter", "<0|1>", "Acceptance filter off (everything) or on (handled PGNs)");
+    g_can_args.signals = arg_lit0("s", "signals", "List the decoded signals");
+    g_can_args.end = arg_end(2);
+    console_register_commands( g_commands, COMMANDS_CNT );
+
     ecu_name_t name = {
             .fields.arbitrary_address_capable = J1939_NO_ADDRESS_CAPABLE,
             .fields.industry_group = J1939_INDUSTRY_GROUP_INDUSTRIAL,
@@ -68,19 +163,41 @@ void can_j1939_start( void )
     ESP_LOGI(TAG, "configure CAN bus");
     can_general_config_t g_config = CAN_GENERAL_CONFIG_DEFAULT(GPIO_NUM_2, GPIO_NUM_4, CAN_MODE_NORMAL);
     can_timing_config_t t_config = CAN_TIMING_CONFIG_1MBITS();
-    can_filter_config_t f_config = CAN_FILTER_CONFIG_ACCEPT_ALL();
 
+    // Default Queue Is 5 Frames, Gone In Under A Millisecond At Full Load
+    g_config.rx_queue_len = RX_QUEUE_LEN;
+
+    // No Driver TX FIFO, It Would Send In Arrival Order, The TX Task Waits On Alerts Instead
+    g_config.tx_queue_len   = 0;
+    g_config.alerts_enabled = TX_ALERTS;
 
+    g_driver_config = g_config;
+    g_driver_timing = t_config;
 
-    /* Install CAN Driver */
+    /* Only The PGNs In The Signal Table, One Past The Filter's Limit Is Enough To Fail */
+    struct j1939_pgn_filter filters[CAN_FILTER_PGN_MAX + 1];
+    uint32_t                filter_cnt = MIN( can_signals_pgn_cnt(), CAN_FILTER_PGN_MAX + 1 );
+
+    memset( filters, 0, sizeof( filters ) );
+    for( uint32_t i = 0; i < filter_cnt; i++ ) {
+        filters[i].pgn = can_signals_pgn_at( i )->pgn;
+    }
+
+    if( 0 != j1939_filter( filters, filter_cnt ) ) {
+        ESP_LOGW(TAG, "no filter for %u PGNs, accepting everything", can_signals_pgn_cnt());
+    }
+
+    /* Install And Start CAN Driver */
     ESP_LOGI(TAG, "Install CAN driver");
-    success = (can_driver_install(&g_config, &t_config, &f_config) == ESP_OK);
+    xSemaphoreTake( g_driver_lock, portMAX_DELAY );
+    success = can_j1939_driver_install();
+    xSemaphoreGive( g_driver_lock );
     ESP_LOGI(TAG, "success: %d", success);
 
-    /* Start CAN Driver */
+    /* Start Transmitting, Address Claim Sends Through It */
     if( success ) {
-        ESP_LOGI(TAG, "Start CAN driver");
-        success = (can_start() == ESP_OK);
+        xTaskCreatePinnedToCore( can_j1939_tx_task, "can_j1939_tx_task", 2 * 1024, NULL,
+                                 TX_TASK_PRIORITY, &g_tx_task, TX_TASK_CORE );
     }
 
     /* Claim Address */
@@ -94,62 +211,446 @@ void can_j1939_start( void )
             j1939_address_claimed(src, name);
         }
     }
+
+    /* Start Receiving */
+    if( success ) {
+        xTaskCreatePinnedToCore( can_j1939_rx_task, "can_j1939_rx_task", 3 * 1024, NULL,
+                                 RX_TASK_PRIORITY, NULL, RX_TASK_CORE );
+    }
 }
 
 void can_j1939_stop( void )
 {
     bool    success;
 
+    xSemaphoreTake( g_driver_lock, portMAX_DELAY );
+    xSemaphoreTake( g_tx_lock, portMAX_DELAY );
+
     /* Stop CAN Driver */
     success = (can_stop() == ESP_OK);
 
     /* Uninstall CAN Driver */
     if( success ) {
         success = (can_driver_uninstall() == ESP_OK);
+        g_driver_installed = !success;
+    }
+
+    xSemaphoreGive( g_tx_lock );
+    xSemaphoreGive( g_driver_lock );
+}
+
+bool can_j1939_set_filter( bool on )
+{
+    bool    success;
+
+    xSemaphoreTake( g_driver_lock, portMAX_DELAY );
+
+    g_filter_on = on;
+    success = !g_driver_installed || can_j1939_driver_install();
+
+    xSemaphoreGive( g_driver_lock );
+
+    return success;
+}
+
+void can_j1939_get_stats( can_j1939_stats_t * stats )
+{
+    can_status_info_t       status;
+
+    xSemaphoreTake( g_tx_queue_lock, portMAX_DELAY );
+    *stats = g_stats;
+    stats->tx_queued        = g_tx_queue.cnt;
+    xSemaphoreGive( g_tx_queue_lock );
+
+    stats->rx_missed_cnt    = g_rx_missed_base;
+    stats->filter_on        = g_filter_on && !g_filter.accept_all;
+    stats->filter_single    = g_filter.single;
+    stats->filter_code      = g_filter.code;
+    stats->filter_mask      = g_filter.mask;
+    stats->filter_id_cnt    = stats->filter_on ? g_filter.hw_id_cnt : ( 1u << 29 );
+
+    // Driver Counts What Never Made It Into Its Queue
+    if( ESP_OK == can_get_status_info( &status ) ) {
+        stats->rx_missed_cnt   += status.rx_missed_count;
+        stats->rx_queued        = status.msgs_to_rx;
+    }
+}
+
+_Noreturn static void can_j1939_rx_task( void * params )
+{
+    uint32_t    pgn;
+    uint8_t     priority;
+    uint8_t     src;
+    uint8_t     dst;
+    uint8_t     data[8];
+    uint32_t    len;
+
+    g_rx_task_running = true;
+
+    while(true) {
+        can_j1939_rx_fill( pdMS_TO_TICKS( RX_WAIT_MS ) );
+
+        // One Frame Per Call, At Least One Call Per Wake So The Stack's Timers Run Even On A Quiet Bus
+        do {
+            len = sizeof( data );
+            if( j1939_receive( &pgn, &priority, &src, &dst, data, &len ) >= 0 ) {
+                // Multi-Frame Messages Are Stamped With Their Last Frame
+                g_stats.msg_cnt++;
+                can_j1939_dispatch( pgn, data, len, g_rx_us );
+            }
+        } while( g_rx_batch_idx < g_rx_batch_cnt );
+    }
+}
+
+static void can_j1939_rx_fill( TickType_t wait )
+{
+    can_message_t         * msg;
+    uint32_t                cnt = 0;
+    uint32_t                rx = 0;
+
+    xSemaphoreTake( g_driver_lock, portMAX_DELAY );
+
+    // Sleep For The First Frame, Then Take Whatever Else Is Already Queued
+    while( g_driver_installed && ( cnt < RX_BATCH_CNT ) && ( rx < RX_QUEUE_LEN ) &&
+           ( ESP_OK == can_receive( &g_rx_batch[cnt].msg, ( 0 == rx ) ? wait : 0 ) ) ) {
+        msg = &g_rx_batch[cnt].msg;
+        rx++;
+
+        // The Hardware Mask Only Narrows Things Down, The Map Says Exactly Which PGNs Were Asked For
+        if( !msg->extd || msg->rtr || ( g_filter_on && !can_filter_accepts( &g_filter, msg->identifier ) ) ) {
+            g_stats.sw_drop_cnt++;
+            continue;
+        }
+
+        g_rx_batch[cnt].t_us = timebase_now_us();
+        cnt++;
+    }
+
+    xSemaphoreGive( g_driver_lock );
+
+    // No Driver, Nothing Would Block, Keep The Task From Spinning
+    if( !g_driver_installed ) {
+        vTaskDelay( wait );
+    }
+
+    g_rx_batch_cnt  = cnt;
+    g_rx_batch_idx  = 0;
+
+    g_stats.rx_cnt += rx;
+    if( cnt > g_stats.rx_batch_max ) {
+        g_stats.rx_batch_max = cnt;
+    }
+}
+
+_Noreturn static void can_j1939_tx_task( void * params )
+{
+    can_tx_frame_t          frame;
+    can_message_t           msg;
+    can_status_info_t       status;
+    uint32_t                alerts;
+    esp_err_t               err;
+    bool                    pending = false;    // Popped, Not Yet Taken By The Controller
+    bool                    in_flight = false;
+
+    while(true) {
+        // Controller Busy, Sleep Until It Says The Frame Is Done
+        if( in_flight ) {
+            xSemaphoreTake( g_tx_lock, portMAX_DELAY );
+            err = g_driver_installed ? can_read_alerts( &alerts, pdMS_TO_TICKS( TX_WAIT_MS ) ) : ESP_ERR_INVALID_STATE;
+            if( ESP_ERR_TIMEOUT == err ) {
+                // No Alert, The Controller Still Holding A Frame Means No One Has Acknowledged It Yet
+                in_flight = ( ESP_OK == can_get_status_info( &status ) ) && ( status.msgs_to_tx > 0 );
+            }
+            xSemaphoreGive( g_tx_lock );
+
+            if( ESP_OK == err ) {
+                xSemaphoreTake( g_tx_queue_lock, portMAX_DELAY );
+                g_stats.tx_sent_cnt     += ( alerts & CAN_ALERT_TX_SUCCESS ) ? 1 : 0;
+                g_stats.tx_failed_cnt   += ( alerts & CAN_ALERT_TX_FAILED ) ? 1 : 0;
+                xSemaphoreGive( g_tx_queue_lock );
+
+                in_flight = !( alerts & TX_ALERTS );
+            }
+            else if( ESP_ERR_TIMEOUT != err ) {
+                // Reinstalled Or Stopped, Whatever Was In The Controller Is Gone
+                in_flight = false;
+            }
+            continue;
+        }
+
+        if( !pending ) {
+            xSemaphoreTake( g_tx_queue_lock, portMAX_DELAY );
+            pending = can_tx_queue_pop( &g_tx_queue, &frame );
+            xSemaphoreGive( g_tx_queue_lock );
+
+            // Queueing Notifies, One Given Since The Pop Returns At Once
+            if( !pending ) {
+                ulTaskNotifyTake( pdTRUE, portMAX_DELAY );
+                continue;
+            }
+        }
+
+        memset( &msg, 0, sizeof( msg ) );
+        msg.extd                = 1;
+        msg.identifier          = frame.id;
+        msg.data_length_code    = frame.len;
+        memcpy( msg.data, frame.data, frame.len );
+
+        xSemaphoreTake( g_tx_lock, portMAX_DELAY );
+        err = g_driver_installed ? can_transmit( &msg, 0 ) : ESP_ERR_INVALID_STATE;
+        xSemaphoreGive( g_tx_lock );
+
+        if( ESP_OK == err ) {
+            pending   = false;
+            in_flight = true;
+        }
+        else if( ESP_FAIL == err ) {
+            // Controller Still Busy With Something Else, Keep The Frame And Wait For It
+            in_flight = true;
+        }
+        else {
+            // Bus-Off Or No Driver, Drop It Rather Than Let The Queue Go Stale
+            pending = false;
+
+            xSemaphoreTake( g_tx_queue_lock, portMAX_DELAY );
+            g_stats.tx_failed_cnt++;
+            xSemaphoreGive( g_tx_queue_lock );
+
+            vTaskDelay( pdMS_TO_TICKS( TX_WAIT_MS ) );
+        }
     }
 }
 
+// Caller Holds g_driver_lock
+static bool can_j1939_driver_install( void )
+{
+    can_filter_config_t     f_config = CAN_FILTER_CONFIG_ACCEPT_ALL();
+    can_status_info_t       status;
+    bool                    success = false;
+
+    if( g_filter_on && !g_filter.accept_all ) {
+        f_config.acceptance_code    = g_filter.code;
+        f_config.acceptance_mask    = g_filter.mask;
+        f_config.single_filter      = g_filter.single;
+    }
+
+    xSemaphoreTake( g_tx_lock, portMAX_DELAY );
+
+    if( g_driver_installed ) {
+        if( ESP_OK == can_get_status_info( &status ) ) {
+            g_rx_missed_base += status.rx_missed_count;
+        }
+
+        // Fails When Already Stopped By Bus-Off, Uninstall Takes That Too
+        (void)can_stop();
+        if( ESP_OK == can_driver_uninstall() ) {
+            g_driver_installed = false;
+        }
+    }
+
+    if( !g_driver_installed && ( ESP_OK == can_driver_install( &g_driver_config, &g_driver_timing, &f_config ) ) ) {
+        g_driver_installed = true;
+        success = ( ESP_OK == can_start() );
+    }
+
+    xSemaphoreGive( g_tx_lock );
+
+    return success;
+}
+
+static void can_j1939_dispatch( uint32_t pgn, const uint8_t * data, uint32_t len, int64_t t_us )
+{
+    const can_signal_pgn_t    * entry;
+    int64_t                     values[CAN_SIGNALS_PER_PGN_MAX];
+    uint32_t                    valid;
+
+    entry = can_signals_find( pgn );
+    if( NULL == entry ) {
+        g_stats.unhandled_cnt++;
+        return;
+    }
+
+    // Repeats, Changes Inside The Deadband And Fresh Values Never Reach pubsub
+    valid = can_signals_update( entry, data, len, t_us, values );
+    for( uint32_t i = 0; valid; i++, valid >>= 1 ) {
+        if( valid & 1 ) {
+            timebase_publish( can_signals_at( entry->first + i )->topic, values[i], t_us );
+        }
+    }
+}
+
+static int can_cmd(int argc, char **argv)
+{
+    static int64_t          last_us;
+    static uint32_t         last_isr_cnt;
+    can_j1939_stats_t       stats;
+    can_signals_stats_t     sig_stats;
+    int64_t                 now_us;
+    uint32_t                isr_cnt;
+
+    int nerrors = arg_parse(argc, argv, (void **) &g_can_args);
+    if (nerrors != 0) {
+        arg_print_errors(stderr, g_can_args.end, argv[0]);
+        return 1;
+    }
+
+    can_j1939_get_stats( &stats );
+    now_us = timebase_now_us();
+
+    // Every Frame Past The Acceptance Filter Raises An RX Interrupt, Kept Or Missed
+    isr_cnt = stats.rx_cnt + stats.rx_missed_cnt;
+
+    printf("rx:       %u frames, %u missed by the driver, %u queued now, batch max %u of %u\n",
+           stats.rx_cnt, stats.rx_missed_cnt, stats.rx_queued, stats.rx_batch_max, RX_BATCH_CNT);
+    printf("filter:   %s, code %08x mask %08x, %u ids pass, %u dropped in software\n",
+           stats.filter_on ? ( stats.filter_single ? "single" : "dual" ) : "off",
+           stats.filter_code, stats.filter_mask, stats.filter_id_cnt, stats.sw_drop_cnt);
+    if( ( 0 != last_us ) && ( now_us > last_us ) ) {
+        printf("rx isr:   %.1f/s over the last %.1f s\n",
+               ( isr_cnt - last_isr_cnt ) * 1e6 / ( now_us - last_us ), ( now_us - last_us ) / 1e6);
+    }
+    printf("j1939:    %u messages, %u without a handler\n", stats.msg_cnt, stats.unhandled_cnt);
+    printf("tx:       %u queued, %u coalesced, %u rejected queue full, %u waiting now, max %u of %u\n",
+           stats.tx_cnt, stats.tx_coalesced_cnt, stats.tx_full_cnt, stats.tx_queued, stats.tx_queue_max, CAN_TX_QUEUE_LEN);
+    printf("          %u sent, %u failed\n", stats.tx_sent_cnt, stats.tx_failed_cnt);
+
+    can_signals_get_stats( &sig_stats );
+    printf("signals:  %u frames, %u unchanged, %u published (%u stale)\n",
+           sig_stats.frame_cnt, sig_stats.unchanged_cnt, sig_stats.publish_cnt, sig_stats.stale_cnt);
+
+    if( g_can_args.signals->count > 0 ) {
+        printf("   pgn    spn  bits   topic                     units\n");
+        for( uint32_t i = 0; i < can_signals_cnt(); i++ ) {
+            const can_signal_t    * sig = can_signals_at( i );
+
+            printf("%6u %6u  %2u+%-2u  %-24s  %s x%d, deadband %d, stale %u ms\n", sig->pgn, sig->spn,
+                   sig->start_bit, sig->bits, sig->topic, sig->units, sig->pub_scale, sig->deadband, sig->stale_ms);
+        }
+    }
+
+    // Rate Starts Over, The Next Call Reports Only The New Setting
+    if( g_can_args.filter->count > 0 ) {
+        if( !can_j1939_set_filter( 0 != g_can_args.filter->ival[0] ) ) {
+            printf("driver reinstall failed\n");
+            return 1;
+        }
+        can_j1939_get_stats( &stats );
+        isr_cnt = stats.rx_cnt + stats.rx_missed_cnt;
+        now_us  = timebase_now_us();
+    }
+
+    last_us      = now_us;
+    last_isr_cnt = isr_cnt;
+
+    return 0;
+}
 
 /********************************************
  *      LIBRARY EXTERN IMPLEMENTATIONS
  ********************************************/
 int j1939_cansend( uint32_t id, uint8_t * data, uint8_t len )
 {
-    can_message_t message;
+    can_tx_result_t         result;
+
+    if( len > sizeof( ( (can_tx_frame_t *)NULL )->data ) ) {
+        return -1;
+    }
+
+    // Never Waits On The Bus, The TX Task Sends It When Its Turn Comes
+    xSemaphoreTake( g_tx_queue_lock, portMAX_DELAY );
 
-    // Setup Message
-    message.extd = 1;
-    message.identifier = id;
-    message.data_length_code = len;
-    memcpy(message.data, data, message.data_length_code);
+    result = can_tx_queue_push( &g_tx_queue, id, data, len );
+    switch( result ) {
+        case CAN_TX_QUEUED:
+            g_stats.tx_cnt++;
+            g_stats.tx_queue_max = MAX( g_stats.tx_queue_max, g_tx_queue.cnt );
+            break;
 
-    if (can_transmit(&message, pdMS_TO_TICKS(100)) == ESP_OK) {
+        case CAN_TX_COALESCED:
+            g_stats.tx_coalesced_cnt++;
+            break;
+
+        case CAN_TX_FULL:
+        default:
+            g_stats.tx_full_cnt++;
+            break;
+    }
+
+    xSemaphoreGive( g_tx_queue_lock );
+
+    if( CAN_TX_FULL == result ) {
         return -1;
     }
-    return message.data_length_code;
+
+    if( NULL != g_tx_task ) {
+        xTaskNotifyGive( g_tx_task );
+    }
+
+    return len;
 }
 
 int j1939_canrcv( uint32_t * id, uint8_t * data )
 {
-    can_message_t message;
+    const can_j1939_frame_t * frame;
+    uint8_t                 len;
 
-    if (can_receive(&message, pdMS_TO_TICKS(100)) != ESP_OK) {
-        return - 1;
+    // Address Claim Runs Before The RX Task, It Still Has To Hear Other Claims
+    if( !g_rx_task_running && ( g_rx_batch_idx >= g_rx_batch_cnt ) ) {
+        can_j1939_rx_fill( pdMS_TO_TICKS( RX_CLAIM_WAIT_MS ) );
     }
 
-    memcpy(data, message.data, message.data_length_code);
-    *id = message.identifier;
-    return message.data_length_code;
+    // Never Blocks Once The Task Runs, The Batch Was Filled Before libj1939 Was Called
+    if( g_rx_batch_idx >= g_rx_batch_cnt ) {
+        return -1;
+    }
+
+    frame   = &g_rx_batch[g_rx_batch_idx++];
+    g_rx_us = frame->t_us;
+
+    // Non-Compliant DLCs Go Up To 15, There Are Still Only 8 Bytes
+    len = MIN( frame->msg.data_length_code, sizeof( frame->msg.data ) );
+    memcpy(data, frame->msg.data, len);
+    *id = frame->msg.identifier;
+    return len;
 }
 
 uint32_t j1939_get_time(void)
 {
-    struct timespec tv;
-    gettimeofday(&tv, NULL);
-    return tv.tv_sec * 1000 + tv.tv_nsec / 1000000;
+    // Stack Timeouts Are Differences In ms, The Wall Clock Stepping Must Not Move Them
+    return timebase_now_ms();
 }
 
 int j1939_filter(struct j1939_pgn_filter *filter, uint32_t num_filters)
 {
-    return 1;
+    static const uint32_t   stack_pgns[] = { PGN_REQUEST, PGN_TP_DT, PGN_TP_CM, PGN_ADDRESS_CLAIMED };
+    uint32_t                pgns[CAN_FILTER_PGN_MAX];
+    uint32_t                cnt = 0;
+    bool                    success;
+
+    if( num_filters > CAN_FILTER_PGN_MAX - sizeof( stack_pgns ) / sizeof( stack_pgns[0] ) ) {
+        return -1;
+    }
+
+    for( size_t i = 0; i < sizeof( stack_pgns ) / sizeof( stack_pgns[0] ); i++ ) {
+        pgns[cnt++] = stack_pgns[i];
+    }
+    for( uint32_t i = 0; i < num_filters; i++ ) {
+        pgns[cnt++] = filter[i].pgn;
+    }
+
+    xSemaphoreTake( g_driver_lock, portMAX_DELAY );
+
+    success = can_filter_build( &g_filter, pgns, cnt );
+    if( !success ) {
+        can_filter_init( &g_filter );
+    }
+
+    // Before can_j1939_start() Installs It The Driver Just Picks Up The New Filter
+    if( g_driver_installed && g_filter_on ) {
+        success = can_j1939_driver_install() && success;
+    }
+
+    xSemaphoreGive( g_driver_lock );
+
+    return success ? 0 : -1;
 }
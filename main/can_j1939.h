@@ -9,6 +9,8 @@ extern "C" {
 /*********************
  *      INCLUDES
  *********************/
+#include <stdint.h>
+#include <stdbool.h>
 
 /*********************
  *      DEFINES
@@ -17,6 +19,32 @@ extern "C" {
 /**********************
  *      TYPEDEFS
  **********************/
+typedef struct
+    {
+    uint32_t                rx_cnt;         // Frames Taken Off The Driver
+    uint32_t                rx_missed_cnt;  // Lost In The Driver, Its Queue Was Full
+    uint32_t                rx_queued;      // Waiting In The Driver Right Now
+    uint32_t                rx_batch_max;   // Most Frames Drained In One Wake
+    uint32_t                msg_cnt;        // Out Of libj1939, A Multi-Frame Message Counts Once
+    uint32_t                unhandled_cnt;  // No Handler For The PGN
+    uint32_t                sw_drop_cnt;    // Past The Hardware Filter, Not In The PGN Map
+
+    // Transmit
+    uint32_t                tx_cnt;         // Taken Into The Queue
+    uint32_t                tx_coalesced_cnt;   // Replaced The Payload Of One Still Waiting
+    uint32_t                tx_full_cnt;    // Turned Away, Queue Full
+    uint32_t                tx_queued;      // Waiting Right Now
+    uint32_t                tx_queue_max;
+    uint32_t                tx_sent_cnt;
+    uint32_t                tx_failed_cnt;  // Controller Gave Up, Or No Driver To Take It
+
+    // Acceptance Filter, As Handed To The Driver
+    bool                    filter_on;
+    bool                    filter_single;
+    uint32_t                filter_code;
+    uint32_t                filter_mask;
+    uint32_t                filter_id_cnt;  // Identifiers It Lets Through
+    } can_j1939_stats_t;
 
 /**********************
  *      MACROS
@@ -26,8 +54,18 @@ extern "C" {
  * GLOBAL PROTOTYPES
  **********************/
 
+/*
+ * Decoded signals, timebase samples published when they change, see can_signals.csv:
+ *  "can.wheel_speed"       CCVS wheel-based vehicle speed, km/h * GPS_SPEED_SCALE
+ *  "can.battery_current"   VEP1 net battery current, mA
+ *  "can.battery_voltage"   VEP1 battery potential, mV
+ */
 void can_j1939_start( void );
 void can_j1939_stop( void );
+void can_j1939_get_stats( can_j1939_stats_t * stats );
+
+// Off Opens The Hardware And Software Filters, To Compare Interrupt Rates, Reinstalls The Driver
+bool can_j1939_set_filter( bool on );
 
 #ifdef __cplusplus
 } /* extern "C" */
@@ -0,0 +1,178 @@
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdlib.h>
+#include <string.h>
+
+#include "can_signals.h"
+#include "can_signals_table.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+typedef struct
+    {
+    uint8_t                 data[8];
+    uint8_t                 len;
+    bool                    seen;
+    } can_signals_pgn_state_t;
+
+typedef struct
+    {
+    int64_t                 value;      // Last Published
+    int64_t                 latest;     // Last Decoded, May Be Inside The Deadband
+    int64_t                 pub_us;
+    bool                    published;
+    bool                    valid;      // Last Payload Held A Value
+    } can_signals_state_t;
+
+/**********************
+ *      MACROS
+ **********************/
+
+/**********************
+ *     GLOBALS
+ **********************/
+static can_signals_pgn_state_t  g_pgn_state[CAN_SIGNAL_PGNS_CNT];
+static can_signals_state_t      g_state[CAN_SIGNALS_CNT];
+static can_signals_stats_t      g_stats;
+
+/**********************
+ *     CONSTANTS
+ **********************/
+
+/**********************
+ *    PROTOTYPES
+ **********************/
+static int can_signals_pgn_cmp( const void * key, const void * elem );
+
+uint32_t can_signals_cnt( void )
+{
+    return CAN_SIGNALS_CNT;
+}
+
+const can_signal_t * can_signals_at( uint32_t idx )
+{
+    return ( idx < CAN_SIGNALS_CNT ) ? &g_can_signals[idx] : NULL;
+}
+
+uint32_t can_signals_pgn_cnt( void )
+{
+    return CAN_SIGNAL_PGNS_CNT;
+}
+
+const can_signal_pgn_t * can_signals_pgn_at( uint32_t idx )
+{
+    return ( idx < CAN_SIGNAL_PGNS_CNT ) ? &g_can_signal_pgns[idx] : NULL;
+}
+
+const can_signal_pgn_t * can_signals_find( uint32_t pgn )
+{
+    return bsearch( &pgn, g_can_signal_pgns, CAN_SIGNAL_PGNS_CNT, sizeof( g_can_signal_pgns[0] ), can_signals_pgn_cmp );
+}
+
+uint32_t can_signals_decode( const can_signal_pgn_t * entry, const uint8_t * data, uint32_t len, int64_t * values )
+{
+    const can_signal_t    * sig = &g_can_signals[entry->first];
+    uint64_t                frame = 0;
+    uint32_t                frame_bits;
+    uint32_t                valid = 0;
+
+    // Whole Frame As One Little Endian Word, Every Signal Is Then A Shift And A Mask
+    len         = ( len < sizeof( frame ) ) ? len : sizeof( frame );
+    frame_bits  = len * 8;
+    memcpy( &frame, data, len );
+
+    for( uint32_t i = 0; i < entry->cnt; i++, sig++ ) {
+        uint32_t    raw;
+
+        if( sig->start_bit + sig->bits > frame_bits ) {
+            continue;
+        }
+
+        raw = (uint32_t)( ( frame >> sig->start_bit ) & ( ( 1ull << sig->bits ) - 1 ) );
+        if( raw > sig->raw_max ) {
+            continue;
+        }
+
+        values[i] = ( (int64_t)raw * sig->num + sig->den / 2 ) / sig->den + sig->offset;
+        valid |= 1u << i;
+    }
+
+    return valid;
+}
+
+uint32_t can_signals_update( const can_signal_pgn_t * entry, const uint8_t * data, uint32_t len, int64_t t_us, int64_t * values )
+{
+    can_signals_pgn_state_t   * pgn_state = &g_pgn_state[entry - g_can_signal_pgns];
+    can_signals_state_t       * state = &g_state[entry->first];
+    const can_signal_t        * sig = &g_can_signals[entry->first];
+    uint32_t                    decoded = 0;
+    uint32_t                    publish = 0;
+
+    len = ( len < sizeof( pgn_state->data ) ) ? len : sizeof( pgn_state->data );
+    g_stats.frame_cnt++;
+
+    // Most PGNs Repeat Unchanged, Then Only Staleness Can Publish Anything
+    if( pgn_state->seen && ( len == pgn_state->len ) && ( 0 == memcmp( data, pgn_state->data, len ) ) ) {
+        g_stats.unchanged_cnt++;
+    }
+    else {
+        memcpy( pgn_state->data, data, len );
+        pgn_state->len  = (uint8_t)len;
+        pgn_state->seen = true;
+
+        decoded = can_signals_decode( entry, data, len, values );
+        for( uint32_t i = 0; i < entry->cnt; i++ ) {
+            state[i].valid = ( 0 != ( decoded & ( 1u << i ) ) );
+            if( state[i].valid ) {
+                state[i].latest = values[i];
+            }
+        }
+    }
+
+    for( uint32_t i = 0; i < entry->cnt; i++, state++, sig++ ) {
+        if( !state->valid ) {
+            continue;
+        }
+
+        if( 0 == ( decoded & ( 1u << i ) ) ) {
+            values[i] = state->latest;
+        }
+        else if( !state->published || ( llabs( values[i] - state->value ) > sig->deadband ) ) {
+            publish |= 1u << i;
+        }
+
+        if( !( publish & ( 1u << i ) ) && ( 0 != sig->stale_ms ) &&
+            ( ( t_us - state->pub_us ) >= (int64_t)sig->stale_ms * 1000 ) ) {
+            publish |= 1u << i;
+            g_stats.stale_cnt++;
+        }
+
+        if( publish & ( 1u << i ) ) {
+            state->value     = values[i];
+            state->pub_us    = t_us;
+            state->published = true;
+            g_stats.publish_cnt++;
+        }
+    }
+
+    return publish;
+}
+
+void can_signals_get_stats( can_signals_stats_t * stats )
+{
+    *stats = g_stats;
+}
+
+static int can_signals_pgn_cmp( const void * key, const void * elem )
+{
+    const uint32_t              pgn = *(const uint32_t *)key;
+    const can_signal_pgn_t    * entry = (const can_signal_pgn_t *)elem;
+
+    return ( pgn > entry->pgn ) - ( pgn < entry->pgn );
+}
@@ -0,0 +1,101 @@
+#ifndef DASH_CAN_SIGNALS_H
+#define DASH_CAN_SIGNALS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdint.h>
+#include <stdbool.h>
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/*
+ * Signal table, written into can_signals_table.h by tools/can_signals_build.py
+ * from main/can_signals.csv at build time:
+ *
+ *  g_can_signals[] holds one entry per SPN, sorted by PGN then start bit.
+ *  g_can_signal_pgns[] holds one entry per PGN, sorted, giving the run of
+ *  signals it carries. A signal is an unsigned little endian bit field of
+ *  the frame's data, published as raw * num / den + offset, rounded, which
+ *  is the value in its units times pub_scale. Raw values above raw_max are
+ *  J1939 error or not available and are not published.
+ *
+ *  A new value is only published once it moves more than deadband from the
+ *  last one published, or when that one is stale_ms old. A frame carrying
+ *  the same payload as the last of its PGN is not decoded at all.
+ */
+#define CAN_SIGNALS_PER_PGN_MAX (32)
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+typedef struct
+    {
+    uint32_t                pgn;
+    uint32_t                spn;
+    const char            * topic;
+    const char            * units;
+    uint8_t                 start_bit;
+    uint8_t                 bits;
+    uint32_t                raw_max;
+    int32_t                 num;
+    int32_t                 den;
+    int32_t                 offset;         // Published Units
+    int32_t                 pub_scale;      // Published Units Per Unit
+    int32_t                 deadband;       // Published Units
+    uint16_t                stale_ms;       // 0 Never Republishes An Unchanged Value
+    } can_signal_t;
+
+typedef struct
+    {
+    uint32_t                pgn;
+    uint16_t                first;          // Into The Signal Table
+    uint16_t                cnt;
+    } can_signal_pgn_t;
+
+typedef struct
+    {
+    uint32_t                frame_cnt;      // Into can_signals_update()
+    uint32_t                unchanged_cnt;  // Same Payload As Before, Not Decoded
+    uint32_t                publish_cnt;    // Values Handed Back To Publish
+    uint32_t                stale_cnt;      // Of Those, Only Because They Were stale_ms Old
+    } can_signals_stats_t;
+
+/**********************
+ *      MACROS
+ **********************/
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/*
+ * Plain C, builds on the host against a generated table. Nothing here knows
+ * any particular signal, new ones only need a line in can_signals.csv.
+ */
+uint32_t can_signals_cnt( void );
+const can_signal_t * can_signals_at( uint32_t idx );
+uint32_t can_signals_pgn_cnt( void );
+const can_signal_pgn_t * can_signals_pgn_at( uint32_t idx );
+
+// NULL When No Signal Comes In pgn
+const can_signal_pgn_t * can_signals_find( uint32_t pgn );
+
+// Bit n Of The Result Is Set When values[n] Holds Signal entry->first + n, Short Frames Leave The Missing Ones Out
+uint32_t can_signals_decode( const can_signal_pgn_t * entry, const uint8_t * data, uint32_t len, int64_t * values );
+
+// As can_signals_decode(), But Only Sets The Bits Of Values Worth Publishing, Keeps State, Call From One Task Only
+uint32_t can_signals_update( const can_signal_pgn_t * entry, const uint8_t * data, uint32_t len, int64_t t_us, int64_t * values );
+void can_signals_get_stats( can_signals_stats_t * stats );
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif //DASH_CAN_SIGNALS_H
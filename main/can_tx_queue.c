@@ -0,0 +1,129 @@
+/*********************
+ *      INCLUDES
+ *********************/
+#include <string.h>
+
+#include "can_tx_queue.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+#define PF_TP_DT                (0xEB)
+#define PF_TP_CM                (0xEC)
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/**********************
+ *      MACROS
+ **********************/
+#define ID_PRIORITY( _id )      ( ( (_id) >> 26 ) & 0x7 )
+#define ID_PF( _id )            ( ( (_id) >> 16 ) & 0xFF )
+
+/**********************
+ *     GLOBALS
+ **********************/
+
+/**********************
+ *     CONSTANTS
+ **********************/
+
+/**********************
+ *    PROTOTYPES
+ **********************/
+static bool can_tx_queue_before( const can_tx_frame_t * a, const can_tx_frame_t * b );
+static void can_tx_queue_swap( can_tx_frame_t * a, can_tx_frame_t * b );
+
+void can_tx_queue_init( can_tx_queue_t * queue )
+{
+    memset( queue, 0, sizeof( *queue ) );
+}
+
+can_tx_result_t can_tx_queue_push( can_tx_queue_t * queue, uint32_t id, const uint8_t * data, uint8_t len )
+{
+    can_tx_frame_t        * frame;
+    uint32_t                i;
+
+    // Periodic Messages Only Matter At Their Newest, Keep The Place In Line
+    if( ( PF_TP_DT != ID_PF( id ) ) && ( PF_TP_CM != ID_PF( id ) ) ) {
+        for( i = 0; i < queue->cnt; i++ ) {
+            frame = &queue->frames[i];
+            if( frame->id == id ) {
+                frame->len = len;
+                memcpy( frame->data, data, len );
+                return CAN_TX_COALESCED;
+            }
+        }
+    }
+
+    if( queue->cnt >= CAN_TX_QUEUE_LEN ) {
+        return CAN_TX_FULL;
+    }
+
+    i       = queue->cnt++;
+    frame   = &queue->frames[i];
+
+    frame->id   = id;
+    frame->seq  = queue->seq++;
+    frame->len  = len;
+    memcpy( frame->data, data, len );
+
+    // Sift Up
+    while( ( i > 0 ) && can_tx_queue_before( &queue->frames[i], &queue->frames[( i - 1 ) / 2] ) ) {
+        can_tx_queue_swap( &queue->frames[i], &queue->frames[( i - 1 ) / 2] );
+        i = ( i - 1 ) / 2;
+    }
+
+    return CAN_TX_QUEUED;
+}
+
+bool can_tx_queue_pop( can_tx_queue_t * queue, can_tx_frame_t * frame )
+{
+    uint32_t    i = 0;
+
+    if( 0 == queue->cnt ) {
+        return false;
+    }
+
+    *frame = queue->frames[0];
+    queue->frames[0] = queue->frames[--queue->cnt];
+
+    // Sift Down
+    while( true ) {
+        uint32_t    child = 2 * i + 1;
+
+        if( child >= queue->cnt ) {
+            break;
+        }
+        if( ( child + 1 < queue->cnt ) && can_tx_queue_before( &queue->frames[child + 1], &queue->frames[child] ) ) {
+            child++;
+        }
+        if( !can_tx_queue_before( &queue->frames[child], &queue->frames[i] ) ) {
+            break;
+        }
+
+        can_tx_queue_swap( &queue->frames[i], &queue->frames[child] );
+        i = child;
+    }
+
+    return true;
+}
+
+static bool can_tx_queue_before( const can_tx_frame_t * a, const can_tx_frame_t * b )
+{
+    if( ID_PRIORITY( a->id ) != ID_PRIORITY( b->id ) ) {
+        return ID_PRIORITY( a->id ) < ID_PRIORITY( b->id );
+    }
+
+    // Wraps Safely, Nothing Waits 2^31 Frames
+    return (int32_t)( a->seq - b->seq ) < 0;
+}
+
+static void can_tx_queue_swap( can_tx_frame_t * a, can_tx_frame_t * b )
+{
+    can_tx_frame_t  tmp = *a;
+
+    *a = *b;
+    *b = tmp;
+}
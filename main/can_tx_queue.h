@@ -0,0 +1,65 @@
+#ifndef DASH_CAN_TX_QUEUE_H
+#define DASH_CAN_TX_QUEUE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdint.h>
+#include <stdbool.h>
+
+/*********************
+ *      DEFINES
+ *********************/
+#define CAN_TX_QUEUE_LEN        (32)
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+typedef struct
+    {
+    uint32_t                id;         // 29 Bit, Priority In ID28..ID26, 0 Goes First
+    uint32_t                seq;        // Arrival Order Among Equal Priorities
+    uint8_t                 len;
+    uint8_t                 data[8];
+    } can_tx_frame_t;
+
+// Binary Heap, frames[0] Is Sent Next
+typedef struct
+    {
+    can_tx_frame_t          frames[CAN_TX_QUEUE_LEN];
+    uint32_t                cnt;
+    uint32_t                seq;
+    } can_tx_queue_t;
+
+typedef enum
+    {
+    CAN_TX_QUEUED,
+    CAN_TX_COALESCED,                   // Same Identifier Still Waiting, Its Payload Was Replaced
+    CAN_TX_FULL,
+    } can_tx_result_t;
+
+/**********************
+ *      MACROS
+ **********************/
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/*
+ * Plain C, builds on the host, no locking. Transport protocol frames (TP.CM,
+ * TP.DT) are never coalesced, every one of them carries different data.
+ */
+void can_tx_queue_init( can_tx_queue_t * queue );
+can_tx_result_t can_tx_queue_push( can_tx_queue_t * queue, uint32_t id, const uint8_t * data, uint8_t len );
+bool can_tx_queue_pop( can_tx_queue_t * queue, can_tx_frame_t * frame );
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif //DASH_CAN_TX_QUEUE_H
@@ -0,0 +1,145 @@
+/*********************
+ *      INCLUDES
+ *********************/
+#include <string.h>
+#include <time.h>
+
+#include "gps.h"
+#include "clock_fmt.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+#define SEC_PER_DAY             (86400)
+#define SEARCH_DAYS             (366)   // No Transition Within A Year Means A Zone Without DST
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/**********************
+ *      MACROS
+ **********************/
+#define put_2digits( _p, _v )   do { ( _p )[0] = (char)( '0' + ( _v ) / 10 ); ( _p )[1] = (char)( '0' + ( _v ) % 10 ); } while( 0 )
+
+/**********************
+ *     GLOBALS
+ **********************/
+
+/**********************
+ *     CONSTANTS
+ **********************/
+
+/**********************
+ *    PROTOTYPES
+ **********************/
+static void clock_fmt_rules( clock_fmt_t * fmt, int64_t utc );
+static int32_t clock_fmt_offset( int64_t utc );
+
+void clock_fmt_init( clock_fmt_t * fmt )
+{
+    memset( fmt, 0, sizeof( *fmt ) );
+
+    // Empty Range, First Update Works The Offset Out
+    fmt->valid_from     = 1;
+    fmt->valid_until    = 0;
+    fmt->hour           = -1;
+    fmt->min            = -1;
+    fmt->sec            = -1;
+
+    memcpy( fmt->text, "12:00:00 AM", CLOCK_FMT_TEXT_SZ );
+}
+
+bool clock_fmt_update( clock_fmt_t * fmt, int64_t utc )
+{
+    int32_t                 sod;
+    int8_t                  hour;
+    int8_t                  min;
+    int8_t                  sec;
+    bool                    changed = false;
+
+    if( ( utc < fmt->valid_from ) || ( utc >= fmt->valid_until ) ) {
+        clock_fmt_rules( fmt, utc );
+    }
+
+    // Seconds Into The Local Day, Kept Positive For Zones West Of UTC
+    sod = (int32_t)( ( utc + fmt->offset ) % SEC_PER_DAY );
+    if( sod < 0 ) {
+        sod += SEC_PER_DAY;
+    }
+
+    hour    = (int8_t)( sod / 3600 );
+    min     = (int8_t)( sod / 60 % 60 );
+    sec     = (int8_t)( sod % 60 );
+
+    // Most Seconds Only Touch The Last Two Digits
+    if( sec != fmt->sec ) {
+        fmt->sec = sec;
+        put_2digits( &fmt->text[6], sec );
+        changed = true;
+    }
+
+    if( min != fmt->min ) {
+        fmt->min = min;
+        put_2digits( &fmt->text[3], min );
+        changed = true;
+    }
+
+    if( hour != fmt->hour ) {
+        fmt->hour = hour;
+        put_2digits( &fmt->text[0], ( 0 == hour % 12 ) ? 12 : hour % 12 );
+        fmt->text[9] = ( hour < 12 ) ? 'A' : 'P';
+        changed = true;
+    }
+
+    return changed;
+}
+
+static void clock_fmt_rules( clock_fmt_t * fmt, int64_t utc )
+{
+    int64_t                 lo = utc;
+    int64_t                 hi;
+
+    fmt->rule_cnt++;
+    fmt->offset     = clock_fmt_offset( utc );
+    fmt->valid_from = utc;
+
+    // Day Steps Until The Offset Changes, Transitions Are Never That Close Together
+    for( hi = utc + SEC_PER_DAY; hi <= utc + (int64_t)SEARCH_DAYS * SEC_PER_DAY; hi += SEC_PER_DAY ) {
+        if( clock_fmt_offset( hi ) != fmt->offset ) {
+            break;
+        }
+        lo = hi;
+    }
+
+    if( hi > utc + (int64_t)SEARCH_DAYS * SEC_PER_DAY ) {
+        fmt->valid_until = lo;
+        return;
+    }
+
+    // Then Down To The Second The New Offset Starts
+    while( ( hi - lo ) > 1 ) {
+        int64_t     mid = lo + ( hi - lo ) / 2;
+
+        if( clock_fmt_offset( mid ) == fmt->offset ) {
+            lo = mid;
+        }
+        else {
+            hi = mid;
+        }
+    }
+
+    fmt->valid_until = hi;
+}
+
+static int32_t clock_fmt_offset( int64_t utc )
+{
+    time_t                  t = (time_t)utc;
+    struct tm               tm;
+
+    // newlib Has No tm_gmtoff, Read The Local Fields Back As If They Were UTC
+    localtime_r( &t, &tm );
+
+    return (int32_t)( (int64_t)gps_utc_to_epoch( tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday,
+                                                 tm.tm_hour, tm.tm_min, tm.tm_sec ) - utc );
+}
@@ -0,0 +1,53 @@
+#ifndef DASH_CLOCK_FMT_H
+#define DASH_CLOCK_FMT_H
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdint.h>
+#include <stdbool.h>
+
+/*********************
+ *      DEFINES
+ *********************/
+#define CLOCK_FMT_TEXT_SZ       (12)    // "hh:mm:ss AM"
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+typedef struct
+    {
+    // UTC Offset, Good From valid_from Up To (Not Including) The Next Transition
+    int32_t                 offset;
+    int64_t                 valid_from;
+    int64_t                 valid_until;
+
+    // Last Formatted Local Time, -1 Fields Force A Rewrite
+    int8_t                  hour;
+    int8_t                  min;
+    int8_t                  sec;
+    char                    text[CLOCK_FMT_TEXT_SZ];
+
+    // Statistics
+    uint32_t                rule_cnt;       // Times The TZ Rules Were Walked
+    } clock_fmt_t;
+
+/**********************
+ *      MACROS
+ **********************/
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/*
+ * 12 hour wall clock text for a UTC time, in the zone set by TZ. localtime()
+ * only runs when the cached offset runs out at the next DST transition (or
+ * the clock is stepped back past where it was worked out), otherwise the text
+ * is patched in place, only the fields that changed. Call clock_fmt_init()
+ * again after changing TZ.
+ */
+void clock_fmt_init( clock_fmt_t * fmt );
+bool clock_fmt_update( clock_fmt_t * fmt, int64_t utc );
+
+#endif //DASH_CLOCK_FMT_H
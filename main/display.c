@@ -1,10 +1,13 @@
 /*********************
  *      INCLUDES
  *********************/
+#include <stdlib.h>
 #include <string.h>
 #include <time.h>
 #include <math.h>
 
+#include <sys/param.h>
+
 #include <pubsub.h>
 #include <lvgl/lvgl.h>
 #include <lvgl_helpers.h>
@@ -17,6 +20,10 @@
 #include "freertos/timers.h"
 #include "freertos/semphr.h"
 
+#include "console_intf.h"
+#include "gps.h"
+#include "timebase.h"
+#include "clock_fmt.h"
 #include "display.h"
 
 /*********************
@@ -28,10 +35,30 @@
 #define SCREEN_WDTH         CONFIG_LVGL_DISPLAY_WIDTH       // 128
 #define SCREEN_HGHT         CONFIG_LVGL_DISPLAY_HEIGHT      // 32
 
+#define METRES_PER_MILE_X1000   (1609344ULL)
+
+// Sky Page, Horizon Circle On The Left, One Signal Bar Per gps.sats Slot To Its Right
+#define SKY_R               ( SCREEN_HGHT / 2 - 1 )
+#define SKY_CX              ( SCREEN_HGHT / 2 )
+#define SKY_CY              ( SCREEN_HGHT / 2 )
+#define SNR_BAR_X0          ( SCREEN_HGHT )
+#define SNR_BAR_W           (2)
+#define SNR_BAR_PITCH       ( ( SCREEN_WDTH - SNR_BAR_X0 ) / GPS_SATS_CNT )
+#define SNR_FULL_SCALE      (50)        // dB-Hz, A Strong Signal Fills The Bar
+
 /**********************
  *      TYPEDEFS
  **********************/
 
+// What One Satellite Slot Shows Right Now, size 0 / bar 0 Is Hidden
+typedef struct
+    {
+    lv_coord_t              x;
+    lv_coord_t              y;
+    lv_coord_t              size;
+    lv_coord_t              bar;
+    } display_sky_slot_t;
+
 /**********************
  *      MACROS
  **********************/
@@ -58,6 +85,9 @@ static esp_timer_handle_t   g_display_periodic_timer;
  *      - Voltage
  *      - Current
  *      - Range
+ *  Sky
+ *      - Satellites By Azimuth/Elevation
+ *      - Signal Per Satellite
  */
 static lv_obj_t           * g_time_label;
 static lv_obj_t           * g_range_label;
@@ -65,6 +95,39 @@ static lv_obj_t           * g_odometer_label;
 static lv_obj_t           * g_voltage_label;
 static lv_obj_t           * g_current_label;
 
+static unsigned             g_odometer_mi;
+static int32_t              g_speed_limit;
+static bool                 g_overspeed;
+
+static clock_fmt_t          g_clock_fmt;
+
+// Sky Page, Built The First Time It Is Shown
+static lv_obj_t           * g_main_scr;
+static lv_obj_t           * g_sky_scr;
+static lv_obj_t           * g_sky_dots[GPS_SATS_CNT];
+static lv_obj_t           * g_sky_bars[GPS_SATS_CNT];
+static display_sky_slot_t   g_sky_drawn[GPS_SATS_CNT];
+static lv_style_t           g_sky_fill_style;
+static lv_style_t           g_sky_ring_style;
+
+static struct {
+    struct arg_int *page;
+    struct arg_end *end;
+    } g_page_args;
+
+/**********************
+ *     COMMANDS
+ **********************/
+static int page_cmd(int argc, char **argv);
+
+static esp_console_cmd_t  g_commands[] =
+    {
+    /*            command              help                                     hint        function                args */
+    {   "page",         "Show Display Page (0 Main, 1 Sky)", NULL,      page_cmd,               &g_page_args },
+    };
+
+#define COMMANDS_CNT        ( sizeof(g_commands)/sizeof(g_commands[0]) )
+
 /**********************
  *     CONSTANTS
  **********************/
@@ -75,6 +138,11 @@ static lv_obj_t           * g_current_label;
 static void display_tick_timer( void * params );
 _Noreturn static void display_task( void * params );
 _Noreturn static void display_msg_task( void * params );
+static void display_odometer_update( void );
+static void display_power_update( lv_obj_t * label, const ps_msg_t * msg, const char * units );
+static void display_page_show( ps_subscriber_t * s, display_page_t page );
+static void display_sky_create( void );
+static void display_sky_update( const gps_sats_t * sats );
 
 
 void log_callback(lv_log_level_t level, const char * file, uint32_t line, const char * description, const char * message)
@@ -87,6 +155,7 @@ void display_start( void )
 {
     g_display_size_in_px = CONFIG_LVGL_DISPLAY_WIDTH*CONFIG_LVGL_DISPLAY_HEIGHT;
     g_display_lock = xSemaphoreCreateMutex();
+    clock_fmt_init( &g_clock_fmt );
 
     // Initialize LVGL
     lv_init();
@@ -116,19 +185,33 @@ void display_start( void )
     lv_obj_set_auto_realign( g_time_label, true);
     lv_label_set_text( g_time_label, "TIME" );
 
+    // Create Odometer Label
+    g_odometer_label = lv_label_create( lv_scr_act(), NULL );
+    lv_label_set_align( g_odometer_label, LV_LABEL_ALIGN_CENTER );
+    lv_obj_align(g_odometer_label, NULL, LV_ALIGN_IN_BOTTOM_MID, 0, 0);
+    lv_obj_set_auto_realign( g_odometer_label, true);
+    lv_label_set_text( g_odometer_label, "" );
+
     // Create Voltage Label
     g_voltage_label = lv_label_create( lv_scr_act(), NULL );
     lv_label_set_align( g_voltage_label, LV_LABEL_ALIGN_CENTER );
     lv_obj_align(g_voltage_label, NULL, LV_ALIGN_IN_BOTTOM_LEFT, 0, 0);
     lv_obj_set_auto_realign( g_voltage_label, true);
-    lv_label_set_text( g_voltage_label, "44 V" );
+    lv_label_set_text( g_voltage_label, "-- V" );
 
     // Create Current Label
     g_current_label = lv_label_create( lv_scr_act(), NULL );
     lv_label_set_align( g_current_label, LV_LABEL_ALIGN_CENTER );
     lv_obj_align(g_current_label, NULL, LV_ALIGN_IN_BOTTOM_RIGHT, 0, 0);
     lv_obj_set_auto_realign( g_current_label, true);
-    lv_label_set_text( g_current_label, "0 A" );
+    lv_label_set_text( g_current_label, "-- A" );
+
+    g_main_scr = lv_scr_act();
+
+    // Register Commands
+    g_page_args.page = arg_int1(NULL, NULL, "<int>", "page");
+    g_page_args.end = arg_end(2);
+    console_register_commands( g_commands, COMMANDS_CNT );
 
     // Setup GUI Tick Timer
     const esp_timer_create_args_t lvgl_tick_timer_args =
@@ -151,6 +234,23 @@ void display_stop( void )
 {
 }
 
+void display_set_page( display_page_t page )
+{
+    // Message Task Owns The Subscriptions, It Does The Switch
+    PUB_INT_FL("display.page", page, FL_STICKY);
+}
+
+bool display_bus_try_lock( void )
+{
+    // LVGL Holds The Lock For Its Whole Refresh, Flushes Included
+    return ( NULL != g_display_lock ) && ( xSemaphoreTake(g_display_lock, 0) == pdTRUE );
+}
+
+void display_bus_unlock( void )
+{
+    xSemaphoreGive(g_display_lock);
+}
+
 static void display_tick_timer( void * params )
 {
     (void) params;
@@ -175,28 +275,230 @@ _Noreturn static void display_task( void * params )
 
 _Noreturn static void display_msg_task( void * params )
 {
-    ps_subscriber_t *s = ps_new_subscriber(10, STRLIST( "gps.time",  "gps.speed" ));
+    ps_subscriber_t *s = ps_new_subscriber(10, STRLIST( "rtc.tick",  "gps.speed", "odometer.distance",
+                                                      "geo.speed_limit", "speedometer.overspeed", "display.page",
+                                                      "can.battery_voltage", "can.battery_current" ));
 
     ps_msg_t *msg = NULL;
 
     while(true) {
         msg = ps_get(s, 5000);
         if (msg != NULL) {
-            if( 0 == strcmp("gps.time", msg->topic ) ) {
-                if (xSemaphoreTake(g_display_lock, (TickType_t)10) == pdTRUE) {
-                    struct tm ts;
-                    char time_buf[80];
-                    ts = *localtime((time_t *) &msg->int_val );
-                    strftime( time_buf, sizeof( time_buf ), "%I:%M:%S %p", &ts );
-
-                    lv_label_set_text_fmt( g_time_label, "%s", time_buf );
+            if( 0 == strcmp("rtc.tick", msg->topic ) ) {
+                // Tick Lands On The Second Boundary, Only Once The Clock Has Been Set
+                if( clock_fmt_update( &g_clock_fmt, msg->int_val ) &&
+                    ( xSemaphoreTake(g_display_lock, (TickType_t)10) == pdTRUE ) ) {
+                    lv_label_set_text( g_time_label, g_clock_fmt.text );
 
                     xSemaphoreGive(g_display_lock);
                 }
             }
+            else if( 0 == strcmp("odometer.distance", msg->topic ) ) {
+                // Metres To Whole Miles
+                g_odometer_mi = (unsigned)( (uint64_t)msg->int_val * 1000 / METRES_PER_MILE_X1000 );
+                display_odometer_update();
+            }
+            else if( 0 == strcmp("geo.speed_limit", msg->topic ) ) {
+                g_speed_limit = msg->int_val;
+                display_odometer_update();
+            }
+            else if( 0 == strcmp("speedometer.overspeed", msg->topic ) ) {
+                g_overspeed = msg->int_val;
+                display_odometer_update();
+            }
+            else if( 0 == strcmp("can.battery_voltage", msg->topic ) ) {
+                display_power_update( g_voltage_label, msg, "V" );
+            }
+            else if( 0 == strcmp("can.battery_current", msg->topic ) ) {
+                display_power_update( g_current_label, msg, "A" );
+            }
+            else if( 0 == strcmp("display.page", msg->topic ) ) {
+                display_page_show( s, (display_page_t)msg->int_val );
+            }
+            else if( ( 0 == strcmp("gps.sats", msg->topic ) ) && ( sizeof( gps_sats_t ) == msg->buf_val.sz ) ) {
+                display_sky_update( (const gps_sats_t *)msg->buf_val.ptr );
+            }
 
             ps_unref_msg(msg);
         }
     }
     ps_free_subscriber(s);
 }
+
+static void display_odometer_update( void )
+{
+    if (xSemaphoreTake(g_display_lock, (TickType_t)10) == pdTRUE) {
+        // Overspeed Marker Takes The Odometer's Place Until Back Under The Limit
+        if( g_overspeed && ( g_speed_limit > 0 ) ) {
+            lv_label_set_text_fmt( g_odometer_label, "LIMIT %u", (unsigned)( ( (uint64_t)g_speed_limit * 10000 + METRES_PER_MILE_X1000 / 2 ) / METRES_PER_MILE_X1000 ) );
+        }
+        else {
+            lv_label_set_text_fmt( g_odometer_label, "%u mi", g_odometer_mi );
+        }
+
+        xSemaphoreGive(g_display_lock);
+    }
+}
+
+static void display_power_update( lv_obj_t * label, const ps_msg_t * msg, const char * units )
+{
+    timebase_sample_t       sample;
+    int32_t                 tenths;
+
+    if( !timebase_sample( msg, &sample ) ) {
+        return;
+    }
+
+    // Thousandths To Tenths, Rounded Away From Zero
+    tenths = (int32_t)( ( sample.value + ( ( sample.value < 0 ) ? -50 : 50 ) ) / 100 );
+
+    if (xSemaphoreTake(g_display_lock, (TickType_t)10) == pdTRUE) {
+        lv_label_set_text_fmt( label, "%s%d.%d %s", ( tenths < 0 ) ? "-" : "", abs( tenths ) / 10, abs( tenths ) % 10, units );
+
+        xSemaphoreGive(g_display_lock);
+    }
+}
+
+static void display_page_show( ps_subscriber_t * s, display_page_t page )
+{
+    if (xSemaphoreTake(g_display_lock, portMAX_DELAY) != pdTRUE) {
+        return;
+    }
+
+    if( DISPLAY_PAGE_SKY == page ) {
+        if( NULL == g_sky_scr ) {
+            display_sky_create();
+        }
+        lv_scr_load( g_sky_scr );
+    }
+    else {
+        lv_scr_load( g_main_scr );
+    }
+
+    xSemaphoreGive(g_display_lock);
+
+    // GSV Is Only Parsed While Someone Listens, Which Is Only While The Page Is Up
+    if( DISPLAY_PAGE_SKY == page ) {
+        ps_subscribe( s, "gps.sats" );
+    }
+    else {
+        ps_unsubscribe( s, "gps.sats" );
+    }
+}
+
+static void display_sky_create( void )
+{
+    // Same Colour As The Text, Whatever The Panel Makes Of It
+    lv_color_t      color = lv_obj_get_style_text_color( g_time_label, LV_LABEL_PART_MAIN );
+    lv_obj_t      * ring;
+
+    lv_style_init( &g_sky_fill_style );
+    lv_style_set_bg_color( &g_sky_fill_style, LV_STATE_DEFAULT, color );
+    lv_style_set_bg_opa( &g_sky_fill_style, LV_STATE_DEFAULT, LV_OPA_COVER );
+    lv_style_set_border_width( &g_sky_fill_style, LV_STATE_DEFAULT, 0 );
+    lv_style_set_radius( &g_sky_fill_style, LV_STATE_DEFAULT, 0 );
+
+    lv_style_init( &g_sky_ring_style );
+    lv_style_set_bg_opa( &g_sky_ring_style, LV_STATE_DEFAULT, LV_OPA_TRANSP );
+    lv_style_set_border_color( &g_sky_ring_style, LV_STATE_DEFAULT, color );
+    lv_style_set_border_width( &g_sky_ring_style, LV_STATE_DEFAULT, 1 );
+    lv_style_set_radius( &g_sky_ring_style, LV_STATE_DEFAULT, LV_RADIUS_CIRCLE );
+
+    g_sky_scr = lv_obj_create( NULL, NULL );
+
+    // Horizon
+    ring = lv_obj_create( g_sky_scr, NULL );
+    lv_obj_add_style( ring, LV_OBJ_PART_MAIN, &g_sky_ring_style );
+    lv_obj_set_pos( ring, SKY_CX - SKY_R, SKY_CY - SKY_R );
+    lv_obj_set_size( ring, 2 * SKY_R + 1, 2 * SKY_R + 1 );
+
+    // Every Slot Gets Its Objects Up Front, Updates Only Ever Move Or Hide Them
+    for( int i = 0; i < GPS_SATS_CNT; i++ ) {
+        g_sky_dots[i] = lv_obj_create( g_sky_scr, NULL );
+        lv_obj_add_style( g_sky_dots[i], LV_OBJ_PART_MAIN, &g_sky_fill_style );
+        lv_obj_set_hidden( g_sky_dots[i], true );
+
+        g_sky_bars[i] = lv_obj_create( g_sky_scr, NULL );
+        lv_obj_add_style( g_sky_bars[i], LV_OBJ_PART_MAIN, &g_sky_fill_style );
+        lv_obj_set_width( g_sky_bars[i], SNR_BAR_W );
+        lv_obj_set_x( g_sky_bars[i], SNR_BAR_X0 + i * SNR_BAR_PITCH );
+        lv_obj_set_hidden( g_sky_bars[i], true );
+
+        memset( &g_sky_drawn[i], 0, sizeof( g_sky_drawn[i] ) );
+    }
+}
+
+static void display_sky_update( const gps_sats_t * sats )
+{
+    display_sky_slot_t      want;
+
+    if( NULL == g_sky_scr ) {
+        return;
+    }
+
+    if (xSemaphoreTake(g_display_lock, (TickType_t)10) != pdTRUE) {
+        // Nothing Drawn, Next Group Is Compared Against What Is Really On Screen
+        return;
+    }
+
+    for( int i = 0; i < GPS_SATS_CNT; i++ ) {
+        const gps_sat_t       * sat = &sats->sats[i];
+        display_sky_slot_t    * drawn = &g_sky_drawn[i];
+
+        memset( &want, 0, sizeof( want ) );
+        if( 0 != sat->prn ) {
+            // Not Tracked Still Shows A Stub, So In View Is Told Apart From Empty
+            want.bar = 1 + MIN( sat->snr, SNR_FULL_SCALE ) * ( SCREEN_HGHT - 1 ) / SNR_FULL_SCALE;
+
+            // Zenith In The Middle, North Up, Horizon On The Ring
+            if( ( 0 != sat->elevation ) || ( 0 != sat->azimuth ) ) {
+                float   r = SKY_R * ( 90 - sat->elevation ) / 90.0f;
+                float   az = sat->azimuth * (float)M_PI / 180.0f;
+
+                want.size   = ( 0 != sat->snr ) ? 3 : 1;
+                want.x      = SKY_CX + (lv_coord_t)lroundf( r * sinf( az ) ) - want.size / 2;
+                want.y      = SKY_CY - (lv_coord_t)lroundf( r * cosf( az ) ) - want.size / 2;
+            }
+        }
+
+        // Only What Moved Gets Touched, LVGL Then Only Redraws Those Areas
+        if( ( want.x != drawn->x ) || ( want.y != drawn->y ) || ( want.size != drawn->size ) ) {
+            if( 0 != want.size ) {
+                lv_obj_set_size( g_sky_dots[i], want.size, want.size );
+                lv_obj_set_pos( g_sky_dots[i], want.x, want.y );
+            }
+            lv_obj_set_hidden( g_sky_dots[i], 0 == want.size );
+        }
+
+        if( want.bar != drawn->bar ) {
+            if( 0 != want.bar ) {
+                lv_obj_set_height( g_sky_bars[i], want.bar );
+                lv_obj_set_y( g_sky_bars[i], SCREEN_HGHT - want.bar );
+            }
+            lv_obj_set_hidden( g_sky_bars[i], 0 == want.bar );
+        }
+
+        *drawn = want;
+    }
+
+    xSemaphoreGive(g_display_lock);
+}
+
+static int page_cmd(int argc, char **argv)
+{
+    int nerrors = arg_parse(argc, argv, (void **) &g_page_args);
+    if (nerrors != 0) {
+        arg_print_errors(stderr, g_page_args.end, argv[0]);
+        return 1;
+    }
+
+    // arg_int1() Only Makes Sure There Is One, The Range Is Ours To Check
+    int page = g_page_args.page->ival[0];
+    if( ( page < 0 ) || ( page >= DISPLAY_PAGE_CNT ) ) {
+        printf("page must be 0 to %d\n", DISPLAY_PAGE_CNT - 1);
+        return 1;
+    }
+
+    display_set_page( (display_page_t)page );
+    return 0;
+}
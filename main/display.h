@@ -5,6 +5,7 @@
 /*********************
  *      INCLUDES
  *********************/
+#include <stdbool.h>
 
 /*********************
  *      DEFINES
@@ -13,6 +14,13 @@
 /**********************
  *      TYPEDEFS
  **********************/
+typedef enum
+    {
+    DISPLAY_PAGE_MAIN,
+    DISPLAY_PAGE_SKY,       // GSV Sky Plot And Signal Bars
+
+    DISPLAY_PAGE_CNT
+    } display_page_t;
 
 /**********************
  *      MACROS
@@ -24,6 +32,11 @@
 
 void display_start( void );
 void display_stop( void );
+void display_set_page( display_page_t page );
+
+// Other Devices On The Display's I2C Bus Go Between Flushes, Never Waiting On The Lock
+bool display_bus_try_lock( void );
+void display_bus_unlock( void );
 
 
 #endif //DASH_DISPLAY_H
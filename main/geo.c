@@ -0,0 +1,181 @@
+/*********************
+ *      INCLUDES
+ *********************/
+#include <string.h>
+
+#include <pubsub.h>
+
+#include "esp_system.h"
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "esp32/rom/crc.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "timebase.h"
+#include "gps.h"
+#include "geo_index.h"
+#include "geo.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+#define TAG                     "GEO"
+
+#define PARTITION_LABEL         "geo"
+#define PARTITION_SUBTYPE       ( (esp_partition_subtype_t)0x42 )
+
+// No Position For This Long Means The Limit Is No Longer Known
+#define POSITION_TIMEOUT_MS     (2000)
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+typedef struct
+    {
+    spi_flash_mmap_handle_t mmap;
+    geo_index_t             idx;
+
+    // Last Published
+    uint16_t                speed_limit;
+    uint32_t                fence_id;
+
+    // Statistics
+    uint32_t                lookup_cnt;
+    uint32_t                lookup_max_us;
+    } geo_priv_t;
+
+/**********************
+ *      MACROS
+ **********************/
+
+/**********************
+ *     GLOBALS
+ **********************/
+static geo_priv_t           g_priv;
+
+/**********************
+ *     CONSTANTS
+ **********************/
+
+/**********************
+ *    PROTOTYPES
+ **********************/
+static bool geo_map( geo_priv_t * priv );
+_Noreturn static void geo_task( void * params );
+static void geo_publish( geo_priv_t * priv, uint16_t speed_limit, uint32_t fence_id );
+
+void geo_start( void )
+{
+    ESP_LOGI(TAG, "Start");
+
+    PUB_INT_FL("geo.speed_limit", 0, FL_STICKY);
+    PUB_INT_FL("geo.fence", 0, FL_STICKY);
+
+    if( !geo_map( &g_priv ) ) {
+        return;
+    }
+
+    ESP_LOGI(TAG, "%u road segments, %u fences, %ux%u cells",
+             g_priv.idx.hdr->seg_cnt, g_priv.idx.hdr->fence_cnt, g_priv.idx.hdr->rows, g_priv.idx.hdr->cols);
+
+    xTaskCreate( geo_task, "geo_task", 3 * 1024, &g_priv, 5, NULL );
+}
+
+void geo_stop( void )
+{
+}
+
+static bool geo_map( geo_priv_t * priv )
+{
+    const esp_partition_t * part;
+    const void            * image;
+    geo_index_hdr_t         hdr;
+    uint32_t                crc;
+    esp_err_t               err;
+
+    part = esp_partition_find_first( ESP_PARTITION_TYPE_DATA, PARTITION_SUBTYPE, PARTITION_LABEL );
+    if( NULL == part ) {
+        ESP_LOGE(TAG, "No '%s' Partition", PARTITION_LABEL);
+        return false;
+    }
+
+    // Lookups Read Straight Out Of The Flash Cache, Nothing Is Copied To RAM
+    err = esp_partition_mmap( part, 0, part->size, SPI_FLASH_MMAP_DATA, &image, &priv->mmap );
+    if( ESP_OK != err ) {
+        ESP_LOGE(TAG, "mmap failed (%s)", esp_err_to_name( err ));
+        return false;
+    }
+
+    if( !geo_index_open( &priv->idx, image, part->size ) ) {
+        ESP_LOGW(TAG, "no valid index, flash one made by tools/geo_build.py");
+        spi_flash_munmap( priv->mmap );
+        return false;
+    }
+
+    // Image Is Checked Once Here, Lookups Trust It
+    memcpy( &hdr, priv->idx.hdr, sizeof( hdr ) );
+    hdr.crc = 0;
+    crc = crc32_le( 0, (const uint8_t *)&hdr, sizeof( hdr ) );
+    crc = crc32_le( crc, (const uint8_t *)image + sizeof( hdr ), hdr.size - sizeof( hdr ) );
+    if( crc != priv->idx.hdr->crc ) {
+        ESP_LOGE(TAG, "index crc mismatch");
+        spi_flash_munmap( priv->mmap );
+        memset( &priv->idx, 0, sizeof( priv->idx ) );
+        return false;
+    }
+
+    return true;
+}
+
+_Noreturn static void geo_task( void * params )
+{
+    geo_priv_t            * priv = (geo_priv_t *)params;
+    ps_subscriber_t       * s = ps_new_subscriber( 4, STRLIST( "gps.position" ) );
+    ps_msg_t              * msg;
+    const gps_fix_t       * fix;
+    geo_result_t            result;
+    int64_t                 start_us;
+    uint32_t                elapsed_us;
+
+    for(;;) {
+        msg = ps_get( s, POSITION_TIMEOUT_MS );
+        if( NULL == msg ) {
+            geo_publish( priv, 0, 0 );
+            continue;
+        }
+
+        if( ( 0 == strcmp( "gps.position", msg->topic ) ) && ( sizeof( gps_fix_t ) == msg->buf_val.sz ) ) {
+            fix = (const gps_fix_t *)msg->buf_val.ptr;
+
+            start_us = timebase_now_us();
+            geo_index_lookup( &priv->idx, fix->lat, fix->lon, &result );
+            elapsed_us = (uint32_t)( timebase_now_us() - start_us );
+
+            priv->lookup_cnt++;
+            if( elapsed_us > priv->lookup_max_us ) {
+                priv->lookup_max_us = elapsed_us;
+                ESP_LOGD(TAG, "slowest lookup so far: %u us", elapsed_us);
+            }
+
+            geo_publish( priv, result.speed_limit, result.fence_id );
+        }
+
+        ps_unref_msg( msg );
+    }
+}
+
+static void geo_publish( geo_priv_t * priv, uint16_t speed_limit, uint32_t fence_id )
+{
+    if( speed_limit != priv->speed_limit ) {
+        priv->speed_limit = speed_limit;
+        PUB_INT_FL("geo.speed_limit", speed_limit, FL_STICKY);
+    }
+
+    if( fence_id != priv->fence_id ) {
+        ESP_LOGI(TAG, "fence %u -> %u", priv->fence_id, fence_id);
+        priv->fence_id = fence_id;
+        PUB_INT_FL("geo.fence", fence_id, FL_STICKY);
+    }
+}
@@ -0,0 +1,32 @@
+#ifndef DASH_GEO_H
+#define DASH_GEO_H
+
+/*********************
+ *      INCLUDES
+ *********************/
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/**********************
+ *      MACROS
+ **********************/
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/*
+ * Looks every "gps.position" up in the "geo" data partition (see geo_index.h)
+ * and publishes "geo.speed_limit" (km/h * GPS_SPEED_SCALE, 0 = unknown) and
+ * "geo.fence" (fence id, 0 = none), both sticky and only when they change.
+ */
+void geo_start( void );
+void geo_stop( void );
+
+#endif //DASH_GEO_H
@@ -0,0 +1,200 @@
+/*********************
+ *      INCLUDES
+ *********************/
+#include <string.h>
+#include <math.h>
+
+#include "geo_index.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+
+// Metres Per 1e-7 deg Along A Meridian, Spherical Earth Is Plenty Within One Cell
+#define M_PER_UNIT              (0.011131949f)
+#define RAD_PER_UNIT            ( (float)M_PI / 180e7f )
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/**********************
+ *      MACROS
+ **********************/
+
+/**********************
+ *     GLOBALS
+ **********************/
+
+/**********************
+ *     CONSTANTS
+ **********************/
+
+/**********************
+ *    PROTOTYPES
+ **********************/
+static bool geo_index_array_ok( const geo_index_hdr_t * hdr, uint32_t off, uint32_t cnt, size_t elem_sz );
+static float geo_seg_dist2( const geo_seg_t * seg, int32_t lat, int32_t lon, float m_per_lon );
+static bool geo_fence_holds( const geo_index_t * idx, const geo_fence_t * fence, int32_t lat, int32_t lon );
+
+bool geo_index_open( geo_index_t * idx, const void * image, size_t image_sz )
+{
+    const geo_index_hdr_t * hdr = (const geo_index_hdr_t *)image;
+    const uint8_t         * base = (const uint8_t *)image;
+    uint32_t                cell_cnt;
+
+    memset( idx, 0, sizeof( *idx ) );
+
+    if( ( image_sz < sizeof( *hdr ) ) || ( GEO_INDEX_MAGIC != hdr->magic ) ||
+        ( GEO_INDEX_VERSION != hdr->version ) || ( sizeof( *hdr ) != hdr->hdr_sz ) ||
+        ( hdr->size > image_sz ) || ( hdr->cell_sz <= 0 ) ) {
+        return false;
+    }
+
+    // Everything Is Read In Place, So Every Array Has To Sit Inside The Image
+    cell_cnt = (uint32_t)hdr->rows * hdr->cols + 1;
+    if( !geo_index_array_ok( hdr, hdr->cells_off, cell_cnt, sizeof( uint32_t ) ) ||
+        !geo_index_array_ok( hdr, hdr->refs_off, hdr->ref_cnt, sizeof( uint32_t ) ) ||
+        !geo_index_array_ok( hdr, hdr->segs_off, hdr->seg_cnt, sizeof( geo_seg_t ) ) ||
+        !geo_index_array_ok( hdr, hdr->fences_off, hdr->fence_cnt, sizeof( geo_fence_t ) ) ||
+        !geo_index_array_ok( hdr, hdr->verts_off, hdr->vert_cnt, sizeof( geo_vert_t ) ) ) {
+        return false;
+    }
+
+    idx->cells  = (const uint32_t *)( base + hdr->cells_off );
+    idx->refs   = (const uint32_t *)( base + hdr->refs_off );
+    idx->segs   = (const geo_seg_t *)( base + hdr->segs_off );
+    idx->fences = (const geo_fence_t *)( base + hdr->fences_off );
+    idx->verts  = (const geo_vert_t *)( base + hdr->verts_off );
+
+    // Cell Starts Only Ever Grow, The Last One Closes The Reference List
+    if( idx->cells[cell_cnt - 1] != hdr->ref_cnt ) {
+        return false;
+    }
+
+    for( uint32_t i = 0; i < hdr->fence_cnt; i++ ) {
+        if( ( idx->fences[i].vert_idx > hdr->vert_cnt ) ||
+            ( idx->fences[i].vert_cnt > ( hdr->vert_cnt - idx->fences[i].vert_idx ) ) ) {
+            return false;
+        }
+    }
+
+    idx->hdr = hdr;
+
+    return true;
+}
+
+void geo_index_lookup( const geo_index_t * idx, int32_t lat, int32_t lon, geo_result_t * result )
+{
+    const geo_index_hdr_t * hdr = idx->hdr;
+    int64_t                 row;
+    int64_t                 col;
+    uint32_t                cell;
+    uint32_t                end;
+    float                   m_per_lon;
+    float                   best;
+
+    result->speed_limit = 0;
+    result->seg         = -1;
+    result->dist_m      = 0;
+    result->fence_id    = 0;
+
+    if( NULL == hdr ) {
+        return;
+    }
+
+    row = ( (int64_t)lat - hdr->lat0 ) / hdr->cell_sz;
+    col = ( (int64_t)lon - hdr->lon0 ) / hdr->cell_sz;
+    if( ( lat < hdr->lat0 ) || ( lon < hdr->lon0 ) || ( row >= hdr->rows ) || ( col >= hdr->cols ) ) {
+        return;
+    }
+
+    cell        = (uint32_t)( row * hdr->cols + col );
+    end         = idx->cells[cell + 1];
+    m_per_lon   = M_PER_UNIT * cosf( lat * RAD_PER_UNIT );
+    best        = (float)hdr->match_m * hdr->match_m;
+
+    for( uint32_t i = idx->cells[cell]; ( i < end ) && ( i < hdr->ref_cnt ); i++ ) {
+        uint32_t    ref = idx->refs[i];
+
+        if( ref & GEO_REF_FENCE ) {
+            // Smallest Fence Comes First, The First Hit Is The Most Specific
+            ref &= ~GEO_REF_FENCE;
+            if( ( 0 == result->fence_id ) && ( ref < hdr->fence_cnt ) &&
+                geo_fence_holds( idx, &idx->fences[ref], lat, lon ) ) {
+                result->fence_id = idx->fences[ref].id;
+            }
+        }
+        else if( ref < hdr->seg_cnt ) {
+            float   dist2 = geo_seg_dist2( &idx->segs[ref], lat, lon, m_per_lon );
+
+            if( dist2 < best ) {
+                best        = dist2;
+                result->seg = (int32_t)ref;
+            }
+        }
+    }
+
+    if( result->seg >= 0 ) {
+        result->speed_limit = idx->segs[result->seg].speed_limit;
+        result->dist_m      = (uint32_t)sqrtf( best );
+    }
+}
+
+static bool geo_index_array_ok( const geo_index_hdr_t * hdr, uint32_t off, uint32_t cnt, size_t elem_sz )
+{
+    return ( 0 == ( off & 3 ) ) && ( off >= sizeof( *hdr ) ) && ( off <= hdr->size ) &&
+           ( (uint64_t)cnt * elem_sz <= ( hdr->size - off ) );
+}
+
+static float geo_seg_dist2( const geo_seg_t * seg, int32_t lat, int32_t lon, float m_per_lon )
+{
+    // Flat Metres, Position At The Origin
+    const float             ax = (float)( (int64_t)seg->end[0].lon - lon ) * m_per_lon;
+    const float             ay = (float)( (int64_t)seg->end[0].lat - lat ) * M_PER_UNIT;
+    const float             dx = (float)( (int64_t)seg->end[1].lon - seg->end[0].lon ) * m_per_lon;
+    const float             dy = (float)( (int64_t)seg->end[1].lat - seg->end[0].lat ) * M_PER_UNIT;
+    const float             len2 = dx * dx + dy * dy;
+    float                   t = 0.0f;
+    float                   px;
+    float                   py;
+
+    // Closest Point Along The Segment, Clamped To Its Ends
+    if( len2 > 0.0f ) {
+        t = -( ax * dx + ay * dy ) / len2;
+        t = ( t < 0.0f ) ? 0.0f : ( ( t > 1.0f ) ? 1.0f : t );
+    }
+
+    px = ax + t * dx;
+    py = ay + t * dy;
+
+    return px * px + py * py;
+}
+
+static bool geo_fence_holds( const geo_index_t * idx, const geo_fence_t * fence, int32_t lat, int32_t lon )
+{
+    const geo_vert_t      * verts = &idx->verts[fence->vert_idx];
+    bool                    inside = false;
+
+    if( ( lat < fence->lat_min ) || ( lat > fence->lat_max ) ||
+        ( lon < fence->lon_min ) || ( lon > fence->lon_max ) ) {
+        return false;
+    }
+
+    // Even-Odd Ray Cast Towards +lon, Exact In 64 Bit
+    for( uint32_t i = 0, j = fence->vert_cnt - 1; i < fence->vert_cnt; j = i++ ) {
+        const geo_vert_t  * vi = &verts[i];
+        const geo_vert_t  * vj = &verts[j];
+
+        if( ( vi->lat > lat ) != ( vj->lat > lat ) ) {
+            int64_t     lhs = ( (int64_t)lon - vj->lon ) * ( (int64_t)vi->lat - vj->lat );
+            int64_t     rhs = ( (int64_t)lat - vj->lat ) * ( (int64_t)vi->lon - vj->lon );
+
+            if( ( vi->lat > vj->lat ) ? ( lhs < rhs ) : ( lhs > rhs ) ) {
+                inside = !inside;
+            }
+        }
+    }
+
+    return inside;
+}
@@ -0,0 +1,136 @@
+#ifndef DASH_GEO_INDEX_H
+#define DASH_GEO_INDEX_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/*
+ * Image layout, written by tools/geo_build.py:
+ *
+ *  A geo_index_hdr_t, then five arrays at the offsets it gives, all little
+ *  endian and 4 byte aligned so they are used in place from flash. The area
+ *  is cut into a grid of rows * cols square cells, cell_sz apart, starting at
+ *  the south-west corner (lat0, lon0). cells[] has rows * cols + 1 entries,
+ *  the references of cell n are refs[cells[n]] up to refs[cells[n + 1]]. A
+ *  reference is a segment index, or a fence index with GEO_REF_FENCE set.
+ *  The builder puts a segment in every cell within match_m of it and a fence
+ *  in every cell its bounding box touches, so a lookup only ever reads the
+ *  one cell the position falls in. Fences are sorted smallest first.
+ *
+ *  crc is crc32 (zlib) over all size bytes, taken with crc itself zeroed.
+ */
+#define GEO_INDEX_MAGIC         (0x314F4547)    // "GEO1"
+#define GEO_INDEX_VERSION       (1)
+
+#define GEO_REF_FENCE           (0x80000000u)
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+typedef struct
+    {
+    uint32_t                magic;
+    uint16_t                version;
+    uint16_t                hdr_sz;
+    uint32_t                size;           // Whole Image, Header Included
+    uint32_t                crc;
+
+    // Grid
+    int32_t                 lat0;           // 1e-7 deg
+    int32_t                 lon0;           // 1e-7 deg
+    int32_t                 cell_sz;        // 1e-7 deg
+    uint16_t                rows;
+    uint16_t                cols;
+    uint16_t                match_m;        // Furthest A Position May Be From Its Road
+    uint16_t                reserved;
+
+    // Arrays, Offsets From The Start Of The Image
+    uint32_t                cells_off;
+    uint32_t                refs_off;
+    uint32_t                ref_cnt;
+    uint32_t                segs_off;
+    uint32_t                seg_cnt;
+    uint32_t                fences_off;
+    uint32_t                fence_cnt;
+    uint32_t                verts_off;
+    uint32_t                vert_cnt;
+    } geo_index_hdr_t;
+
+// Point, 1e-7 deg
+typedef struct
+    {
+    int32_t                 lat;
+    int32_t                 lon;
+    } geo_vert_t;
+
+// Straight Piece Of Road
+typedef struct
+    {
+    geo_vert_t              end[2];
+    uint16_t                speed_limit;    // km/h * GPS_SPEED_SCALE, 0 = Unknown
+    uint16_t                flags;
+    } geo_seg_t;
+
+// Closed Polygon, Last Vertex Joins The First
+typedef struct
+    {
+    uint32_t                id;
+    uint32_t                vert_idx;
+    uint16_t                vert_cnt;
+    uint16_t                flags;
+    int32_t                 lat_min;        // Bounding Box
+    int32_t                 lat_max;
+    int32_t                 lon_min;
+    int32_t                 lon_max;
+    } geo_fence_t;
+
+typedef struct
+    {
+    const geo_index_hdr_t * hdr;
+    const uint32_t        * cells;
+    const uint32_t        * refs;
+    const geo_seg_t       * segs;
+    const geo_fence_t     * fences;
+    const geo_vert_t      * verts;
+    } geo_index_t;
+
+typedef struct
+    {
+    uint16_t                speed_limit;    // Of The Nearest Road, 0 = None Or Unknown
+    int32_t                 seg;            // Nearest Road, -1 = None Within match_m
+    uint32_t                dist_m;
+    uint32_t                fence_id;       // Smallest Fence Holding The Position, 0 = None
+    } geo_result_t;
+
+/**********************
+ *      MACROS
+ **********************/
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/*
+ * Plain C, no ESP-IDF, so it also builds on the host against an image made
+ * by tools/geo_build.py. The image is not copied, it must stay mapped.
+ */
+bool geo_index_open( geo_index_t * idx, const void * image, size_t image_sz );
+void geo_index_lookup( const geo_index_t * idx, int32_t lat, int32_t lon, geo_result_t * result );
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif //DASH_GEO_INDEX_H
@@ -1,9 +1,13 @@
 /*
  * Includes
  */
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#include <stdatomic.h>
+#include <sys/param.h>
 
-#include <minmea/minmea.h>
 #include <pubsub.h>
 
 #include "esp_system.h"
@@ -11,10 +15,19 @@
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "freertos/semphr.h"
+#include "freertos/queue.h"
 
 #include "driver/uart.h"
 
+#include "xtensa/hal.h"
+
+#include "nmea_framer.h"
+#include "gps_nmea.h"
+#include "ubx.h"
+#include "track_log.h"
+#include "gps_aid.h"
+#include "gps_stats.h"
+#include "timebase.h"
 #include "gps.h"
 
 
@@ -23,12 +36,58 @@
  */
 #define TAG                 "GPS"
 
-#define RX_BUF_SZ           (256)
+#define RX_BUF_SZ           (1024)
 #define GPS_SENTENCE_MAX_SZ (128)
+#define RX_CHUNK_SZ         (128)
+
+#define UART_EVT_QUEUE_SZ   (20)
+#define UART_PATTERN_CHR    ('\n')
+#define UART_PATTERN_Q_SZ   (16)
+
+#define SENTENCE_SLOT_CNT   (8)     // Must be a power of 2
+#define SENTENCE_SLOT_MASK  ( SENTENCE_SLOT_CNT - 1 )
+
+// Read task looks for a protocol switch at least this often, even with the UART quiet
+#define PROTOCOL_POLL_MS    (100)
+
+// Startup Negotiation
+#define BAUD_TARGET         (115200)
+#define RATE_TARGET_MS      (100)       // 10 Hz
+#define DETECT_TIMEOUT_MS   (1500)      // Receivers talk at least once a second
+
+// Warm Start
+#define AID_POS_ACC_CM      (1000000)   // 10 km, Covers Being Towed Or Moved While Off
+#define AID_TIME_ACC_S      (2)
+#define AID_FIRST_SAVE_US   ( 2 * 60 * 1000000LL )  // Give The Receiver Time To Collect Ephemeris
+#define AID_SAVE_PERIOD_US  ( 30 * 60 * 1000000LL )
+#define AID_DBD_QUIET_US    ( 1000000LL )           // Dump Is Over Once MGA-DBD Stops Arriving
+
+// NVS Work Handed To The Parse Task, Flash Commits Stall Whoever Makes Them
+#define AID_PEND_TTFF       (0x01)
+#define AID_PEND_POS        (0x02)
+#define AID_PEND_DBD        (0x04)
+
+#define SUBS_REFRESH_MS     (1000)
+#define TOPIC_MAX_SZ        (32)
 
 /*
  * Types
  */
+typedef struct
+    {
+    size_t                  len;
+    int64_t                 t_us;       // Read Off The UART
+    char                    data[GPS_SENTENCE_MAX_SZ + 1];
+    } gps_sentence_slot_t;
+
+typedef struct
+    {
+    uint32_t                code;
+    uint8_t                 pmtk314_field;  // Field of PMTK314 (MTK)
+    uint8_t                 ubx_msg_id;     // ID in UBX_CLASS_NMEA (u-blox)
+    uint8_t                 divider;        // Once every this many fixes, when it has a handler
+    } gps_nmea_output_t;
+
 typedef struct
     {
     // UART Data
@@ -38,14 +97,52 @@ typedef struct
     int                     cts_pin;
     int                     rts_pin;
 
+    QueueHandle_t           uart_queue;
+    gps_protocol_t          protocol;
+    atomic_int              protocol_req;   // gps_protocol_t, Set By Any Task
+    uint32_t                baud;
+    uint32_t                rate_ms;
+
     // Task Data
     TaskHandle_t            gps_read_task;
     TaskHandle_t            gps_parse_task;
 
-    // GPS Data
-    char                    gps_sentence[GPS_SENTENCE_MAX_SZ + 1];
-    SemaphoreHandle_t       gps_sentence_lock;
-    SemaphoreHandle_t       gps_sentence_trigger;
+    // GPS Data, Single Producer (Read Task) / Single Consumer (Parse Task)
+    nmea_framer_t           gps_framer;
+    gps_sentence_slot_t     gps_sentence_slots[SENTENCE_SLOT_CNT];
+    char                    gps_sentence_scratch[GPS_SENTENCE_MAX_SZ + 1];
+    atomic_uint             gps_sentence_head;
+    atomic_uint             gps_sentence_tail;
+
+    // UBX Data, Decoded In The Read Task
+    ubx_parser_t            ubx_parser;
+    int64_t                 rx_us;          // Chunk Being Framed Or Parsed Was Read At
+    gps_fix_t               ubx_fix;
+    gps_fix_t               nmea_fix;
+    atomic_bool             track_log;
+
+    // Warm Start, Touched Only By Whichever Task Decodes Fixes
+    int64_t                 start_us;
+    bool                    aided;
+    bool                    ttff_done;
+    int64_t                 aid_save_us;
+    uint8_t               * dbd_buf;        // MGA-DBD Dump Being Collected
+    size_t                  dbd_len;
+    int64_t                 dbd_us;
+
+    // Saves Waiting On The Parse Task, Fields Below Owned By It While Their Bit Is Set
+    atomic_uint             aid_pend;
+    uint32_t                aid_ttff_ms;
+    gps_aid_pos_t           aid_pos;
+    uint8_t               * aid_dbd_buf;
+    size_t                  aid_dbd_len;
+
+    // Sentence Types With Subscribers, Bit Per gps_nmea_type_t
+    uint32_t                gps_sentence_wanted;
+    TickType_t              gps_sentence_wanted_tick;
+
+    // Statistics, Each Field Written By One Task Only
+    gps_stats_t             stats;
     } gps_intf_priv_t;
 
 /*
@@ -58,6 +155,58 @@ static gps_intf_priv_t      g_priv; //This should only be temporary, eventually
  */
 _Noreturn static void gps_read_task( void * params );
 _Noreturn static void gps_parse_task( void * params );
+static void gps_handle_event( gps_intf_priv_t * priv, const uart_event_t * event );
+static void gps_negotiate( gps_intf_priv_t * priv );
+static bool gps_detect_baud( gps_intf_priv_t * priv );
+static void gps_upgrade_link( gps_intf_priv_t * priv );
+static bool gps_wait_traffic( gps_intf_priv_t * priv, uint32_t timeout_ms );
+static void gps_set_baud( gps_intf_priv_t * priv, uint32_t baud );
+static void gps_rx_restart( gps_intf_priv_t * priv );
+static void gps_configure_outputs( gps_intf_priv_t * priv );
+static void gps_send_pmtk( gps_intf_priv_t * priv, const char * body );
+static void gps_send_ubx( gps_intf_priv_t * priv, uint8_t cls, uint8_t id, const uint8_t * payload, uint16_t len );
+static void gps_read_chunk( gps_intf_priv_t * priv, int len );
+static void gps_read_ubx( gps_intf_priv_t * priv, int len );
+static void gps_read_detect( gps_intf_priv_t * priv );
+static void gps_apply_protocol( gps_intf_priv_t * priv );
+static void gps_ubx_frame( void * ctx, uint8_t cls, uint8_t id, const uint8_t * payload, uint16_t len );
+static char * gps_sentence_emit( void * ctx, char * sentence, size_t len );
+static void gps_sentence_refresh_wanted( gps_intf_priv_t * priv );
+static bool gps_topic_has_subs( const char * topic );
+static void gps_track_fix( gps_intf_priv_t * priv, const gps_fix_t * fix );
+static void gps_publish_position( const gps_fix_t * fix );
+static void gps_aid_inject( gps_intf_priv_t * priv );
+static bool gps_aid_fix( gps_intf_priv_t * priv, const gps_fix_t * fix );
+static void gps_aid_dbd_poll( gps_intf_priv_t * priv );
+static void gps_aid_dbd_frame( gps_intf_priv_t * priv, const uint8_t * payload, uint16_t len );
+static void gps_aid_dbd_check( gps_intf_priv_t * priv );
+static void gps_aid_defer( gps_intf_priv_t * priv, unsigned int pend );
+static void gps_aid_commit( gps_intf_priv_t * priv );
+static void gps_format_deg( char * buf, size_t buf_sz, int32_t deg );
+
+/*
+ * Constants
+ */
+// Standard Sentences, Anything Without A Handler Gets Switched Off
+static const gps_nmea_output_t g_nmea_outputs[] =
+    {
+    /*  code                            pmtk314 ubx     divider */
+    {   NMEA_CODE( 'G', 'L', 'L' ),     0,      0x01,   1 },
+    {   NMEA_CODE( 'R', 'M', 'C' ),     1,      0x04,   1 },
+    {   NMEA_CODE( 'V', 'T', 'G' ),     2,      0x05,   1 },
+    {   NMEA_CODE( 'G', 'G', 'A' ),     3,      0x00,   1 },
+    {   NMEA_CODE( 'G', 'S', 'A' ),     4,      0x02,   1 },
+    {   NMEA_CODE( 'G', 'S', 'V' ),     5,      0x03,   5 },    // Several Sentences Per System, Sky Moves Slowly
+    {   NMEA_CODE( 'Z', 'D', 'A' ),     17,     0x08,   1 },
+    };
+
+#define NMEA_OUTPUTS_CNT        ( sizeof(g_nmea_outputs)/sizeof(g_nmea_outputs[0]) )
+#define PMTK314_FIELD_CNT       (19)
+
+// Autodetect order: factory default, then what a previous boot may have left behind
+static const uint32_t       g_baud_rates[] = { 9600, BAUD_TARGET, 38400, 57600 };
+
+#define BAUD_RATES_CNT          ( sizeof(g_baud_rates)/sizeof(g_baud_rates[0]) )
 
 void gps_start( void )
 {
@@ -79,167 +228,799 @@ void gps_start( void )
     g_priv.rx_pin               = 15;
     g_priv.cts_pin              = UART_PIN_NO_CHANGE;
     g_priv.rts_pin              = UART_PIN_NO_CHANGE;
+    g_priv.protocol             = GPS_PROTOCOL_NMEA;
+    atomic_init( &g_priv.protocol_req, GPS_PROTOCOL_NMEA );
+    g_priv.baud                 = uart_config.baud_rate;
+    g_priv.rate_ms              = 1000;
 
-    g_priv.gps_sentence_lock    = xSemaphoreCreateMutex();
-    g_priv.gps_sentence_trigger = xSemaphoreCreateBinary();
+    atomic_init( &g_priv.gps_sentence_head, 0 );
+    atomic_init( &g_priv.gps_sentence_tail, 0 );
+    atomic_init( &g_priv.track_log, false );
+    atomic_init( &g_priv.aid_pend, 0 );
+
+    //TTFF counts from here, the receiver powers up with us
+    g_priv.start_us             = timebase_now_us();
+    gps_aid_init();
+
+    //Parse times run from about 1k cycles, latencies from tens of us
+    for( int i = 0; i < GPS_STATS_PARSE_CNT; i++ ) {
+        gps_hist_init( &g_priv.stats.parse_cycles[i], 10 );
+    }
+    gps_hist_init( &g_priv.stats.latency_us, 4 );
+
+#if CONFIG_DASH_TRACK_LOG
+    //Track log stays idle until gps_set_track_log()
+    track_log_init();
+#endif
+
+    //Frame straight into the first slot of the sentence ring
+    nmea_framer_init( &g_priv.gps_framer, g_priv.gps_sentence_slots[0].data,
+                      sizeof( g_priv.gps_sentence_slots[0].data ), gps_sentence_emit, &g_priv );
+    ubx_parser_init( &g_priv.ubx_parser, gps_ubx_frame, &g_priv );
 
     //Install UART driver, and get the queue.
-    uart_driver_install( g_priv.uart_port, 2 * RX_BUF_SZ, 0, 0, NULL, 0);
+    uart_driver_install( g_priv.uart_port, 2 * RX_BUF_SZ, 0, UART_EVT_QUEUE_SZ, &g_priv.uart_queue, 0);
     uart_param_config(g_priv.uart_port, &uart_config);
 
+    //Raise a pattern event on every line feed, so each sentence is read in one go
+    uart_enable_pattern_det_baud_intr( g_priv.uart_port, UART_PATTERN_CHR, 1, 9, 0, 0 );
+    uart_pattern_queue_reset( g_priv.uart_port, UART_PATTERN_Q_SZ );
+
     //Set UART log level
     esp_log_level_set(TAG, ESP_LOG_INFO);
 
     //Set UART pins (using UART0 default pins ie no changes.)
     uart_set_pin(g_priv.uart_port, g_priv.tx_pin, g_priv.rx_pin, g_priv.rts_pin, g_priv.cts_pin);
 
-    //Create a task to handler UART event from ISR
-    xTaskCreate( gps_read_task, "gps_read_task", 2048, &g_priv, 12, NULL );
+    //Parse task goes first, the read task notifies it by handle
+    xTaskCreate( gps_parse_task, "gps_parse_task", 4 * 1024, &g_priv, 12, &g_priv.gps_parse_task );
+
+    //Create a task to handler UART event from ISR, UBX decodes and publishes fixes here too
+    xTaskCreate( gps_read_task, "gps_read_task", 4 * 1024, &g_priv, 12, &g_priv.gps_read_task );
 
-    xTaskCreate( gps_parse_task, "gps_parse_task", 4 * 1024, &g_priv, 12, NULL );
+    gps_stats_start();
 }
 
 void gps_stop( void )
 {
 }
 
-//We should change this back into using a queue, and that queued data goes into a stream buffer
-// We then have a task that wakes on stream buffer and processes the GPS data.
+void gps_set_protocol( gps_protocol_t protocol )
+{
+    // Read Task Owns The UART, Let It Do The Switch Between Reads. Not Queued
+    // With The UART Events, Overflow Handling Empties That Queue
+    atomic_store( &g_priv.protocol_req, protocol );
+}
+
+void gps_set_track_log( bool enable )
+{
+    atomic_store( &g_priv.track_log, enable );
+
+    if( !enable ) {
+        track_log_flush();
+    }
+}
+
+void gps_get_stats( gps_stats_t * stats )
+{
+    const gps_intf_priv_t * priv = &g_priv;
+
+    // Counters Are Single Words, A Snapshot Can Only Be Off By Whatever Lands Meanwhile
+    *stats                      = priv->stats;
+    stats->t_us                 = timebase_now_us();
+    stats->baud                 = priv->baud;
+    stats->sentence_cnt         = priv->gps_framer.sentence_cnt;
+    stats->cksum_err_cnt        = priv->gps_framer.cksum_err_cnt;
+    stats->overflow_cnt         = priv->gps_framer.overflow_cnt;
+    stats->resync_cnt           = priv->gps_framer.resync_cnt;
+    stats->ubx_frame_cnt        = priv->ubx_parser.frame_cnt;
+    stats->ubx_cksum_err_cnt    = priv->ubx_parser.cksum_err_cnt;
+    stats->ubx_oversize_cnt     = priv->ubx_parser.oversize_cnt;
+    stats->read_stack_free      = uxTaskGetStackHighWaterMark( priv->gps_read_task );
+    stats->parse_stack_free     = uxTaskGetStackHighWaterMark( priv->gps_parse_task );
+}
 
 _Noreturn static void gps_read_task( void *params )
 {
     gps_intf_priv_t       * priv = (gps_intf_priv_t *)params;
-    char                    gps_sentence[GPS_SENTENCE_MAX_SZ + 1];
-    char                    ch;
+    uart_event_t            event;
+
+    // Find The Receiver And Bring It Up To Speed
+    gps_negotiate( priv );
 
     for(;;)
     {
-        // Local Variables
-        int             gps_sentence_idx;
-        bool            trigger;
-
-        // Initialize
-        trigger         = false;
-        gps_sentence_idx= 0;
-
-        // If Sentence Buffer Index Is At 0, Read Byte By Byte Until You Find A '$'
-        while( 1 == uart_read_bytes( priv->uart_port, (uint8_t *) &ch, 1, 200 / portTICK_RATE_MS ))
-        {
-            if( '$' == gps_sentence[0] )
-            {
-                gps_sentence[gps_sentence_idx] = ch;
-                gps_sentence_idx++;
-                break;
-            }
+        // Wait For UART Event
+        if( pdTRUE == xQueueReceive( priv->uart_queue, &event, pdMS_TO_TICKS( PROTOCOL_POLL_MS ) ) ) {
+            gps_handle_event( priv, &event );
         }
 
-        // Continue Reading Data To GPS Sentence Until '<CR> <LF>'
-        while( 1 == uart_read_bytes( priv->uart_port, (uint8_t *) &ch, 1, portMAX_DELAY ))
-        {
-            // Add Data To Sentence
-            if( gps_sentence_idx < GPS_SENTENCE_MAX_SZ)
-            {
-                gps_sentence[gps_sentence_idx] = ch;
-                gps_sentence_idx++;
+        gps_apply_protocol( priv );
+    }
+
+    vTaskDelete(NULL);
+}
+
+static void gps_handle_event( gps_intf_priv_t * priv, const uart_event_t * event )
+{
+    switch( event->type ) {
+        case UART_DATA:
+            // NMEA Waits For The Line Feed Pattern, UBX Takes Whatever Arrived
+            if( GPS_PROTOCOL_UBX == priv->protocol ) {
+                gps_read_ubx( priv, event->size );
             }
+        break;
 
-            // Detect Line Feed
-            if( '\n' == ch )
-            {
-                // Null Terminate GPS Sentence
-                gps_sentence[gps_sentence_idx] = '\0';
+        case UART_PATTERN_DET: {
+            // Position Of The Line Feed Within The RX Buffer
+            int pos = uart_pattern_pop_pos( priv->uart_port );
 
-                trigger = true;
-                break;
+            if( pos < 0 ) {
+                // Pattern Queue Overflowed, Line Boundaries Are Lost
+                ESP_LOGW(TAG, "pattern queue overflow");
+                priv->stats.pattern_ovf_cnt++;
+                uart_flush_input( priv->uart_port );
+                xQueueReset( priv->uart_queue );
+                nmea_framer_reset( &priv->gps_framer );
+            }
+            else {
+                gps_read_chunk( priv, pos + 1 );
             }
         }
+        break;
 
-        // Trigger
-        if( trigger )
-        {
-            // Lock Mutex
-            xSemaphoreTake( priv->gps_sentence_lock, portMAX_DELAY );
+        case UART_FIFO_OVF:
+        case UART_BUFFER_FULL:
+            ESP_LOGW(TAG, "rx overflow (%d)", event->type);
+            priv->stats.uart_ovf_cnt++;
+            uart_flush_input( priv->uart_port );
+            xQueueReset( priv->uart_queue );
+            nmea_framer_reset( &priv->gps_framer );
+            ubx_parser_reset( &priv->ubx_parser );
+        break;
 
-            // Copy Data
-            strncpy( priv->gps_sentence, (const char *)gps_sentence, sizeof(priv->gps_sentence) );
+        default:
+        break;
+    }
+}
+
+static void gps_negotiate( gps_intf_priv_t * priv )
+{
+    if( gps_detect_baud( priv ) ) {
+        gps_upgrade_link( priv );
+        gps_aid_inject( priv );
+    }
+    else {
+        ESP_LOGW(TAG, "no receiver found, staying at %u baud", priv->baud);
+    }
+
+    ESP_LOGI(TAG, "receiver at %u baud, %u ms", priv->baud, priv->rate_ms);
+
+    PUB_INT_FL("gps.config.baud", priv->baud, FL_STICKY);
+    PUB_INT_FL("gps.config.rate", 1000 / priv->rate_ms, FL_STICKY);
+}
+
+static void gps_upgrade_link( gps_intf_priv_t * priv )
+{
+    const uint32_t          detected_baud = priv->baud;
+
+    // Ask For The Faster Link, Then Check The Receiver Followed
+    if( detected_baud != BAUD_TARGET ) {
+        char        pmtk[24];
+        uint8_t     cfg_prt[20] = {
+            0x01, 0x00, 0x00, 0x00,                                 // UART1, txReady Off
+            0xD0, 0x08, 0x00, 0x00,                                 // 8N1
+            (uint8_t)( BAUD_TARGET ), (uint8_t)( BAUD_TARGET >> 8 ),
+            (uint8_t)( BAUD_TARGET >> 16 ), (uint8_t)( BAUD_TARGET >> 24 ),
+            0x03, 0x00,                                             // In: UBX + NMEA
+            0x03, 0x00,                                             // Out: UBX + NMEA
+            0x00, 0x00, 0x00, 0x00
+            };
 
-            // Unlock Mutex
-            xSemaphoreGive( priv->gps_sentence_lock );
+        // Each Receiver Family Ignores The Other's Commands
+        snprintf( pmtk, sizeof( pmtk ), "PMTK251,%u", BAUD_TARGET );
+        gps_send_pmtk( priv, pmtk );
+        gps_send_ubx( priv, UBX_CLASS_CFG, UBX_CFG_PRT, cfg_prt, sizeof( cfg_prt ) );
+        uart_wait_tx_done( priv->uart_port, pdMS_TO_TICKS( 100 ) );
 
-            // Trigger Processing
-            xSemaphoreGive( priv->gps_sentence_trigger );
+        gps_set_baud( priv, BAUD_TARGET );
+        if( !gps_wait_traffic( priv, DETECT_TIMEOUT_MS ) ) {
+            ESP_LOGW(TAG, "receiver did not follow to %u baud", BAUD_TARGET);
+            gps_set_baud( priv, detected_baud );
         }
     }
 
-    vTaskDelete(NULL);
+    // Only Raise The Fix Rate Once The Link Can Carry It
+    gps_configure_outputs( priv );
+    if( BAUD_TARGET == priv->baud ) {
+        uint8_t     cfg_rate[6] = {
+            (uint8_t)( RATE_TARGET_MS ), (uint8_t)( RATE_TARGET_MS >> 8 ),  // Measurement Rate
+            0x01, 0x00,                                                     // Every Measurement
+            0x00, 0x00                                                      // UTC Aligned
+            };
+        char        pmtk[24];
+
+        snprintf( pmtk, sizeof( pmtk ), "PMTK220,%u", RATE_TARGET_MS );
+        gps_send_pmtk( priv, pmtk );
+        gps_send_ubx( priv, UBX_CLASS_CFG, UBX_CFG_RATE, cfg_rate, sizeof( cfg_rate ) );
+        priv->rate_ms = RATE_TARGET_MS;
+    }
 }
 
-_Noreturn static void gps_parse_task( void * params )
+static bool gps_detect_baud( gps_intf_priv_t * priv )
 {
-    gps_intf_priv_t       * priv = (gps_intf_priv_t *)params;
-    char                    gps_sentence[GPS_SENTENCE_MAX_SZ + 1];
-    enum minmea_sentence_id id;
+    for( size_t i = 0; i < BAUD_RATES_CNT; i++ ) {
+        gps_set_baud( priv, g_baud_rates[i] );
 
-    for(;;) {
-        // Wait For Data
-        xSemaphoreTake( priv->gps_sentence_trigger, portMAX_DELAY );
-
-        // Get Data
-        xSemaphoreTake( priv->gps_sentence_lock, portMAX_DELAY );
-        memcpy( gps_sentence, priv->gps_sentence, sizeof(gps_sentence) );
-        xSemaphoreGive( priv->gps_sentence_lock );
-
-        id = minmea_sentence_id((const char *)gps_sentence, false);
-        switch( id ) {
-            case MINMEA_SENTENCE_RMC: {
-                struct minmea_sentence_rmc frame;
-
-                if( minmea_parse_rmc( &frame, (const char *)gps_sentence ) ) {
-                    struct timespec ts;
-
-                    // Update Time
-                    if( 0 == minmea_gettime(&ts, &frame.date, &frame.time) ) {
-//                        ESP_LOGI(TAG, "Time: %ld", ts.tv_sec);
-                        PUB_INT("gps.time", ts.tv_sec);
-                    }
-                }
-            }
+        if( gps_wait_traffic( priv, DETECT_TIMEOUT_MS ) ) {
+            ESP_LOGI(TAG, "receiver found at %u baud", priv->baud);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static bool gps_wait_traffic( gps_intf_priv_t * priv, uint32_t timeout_ms )
+{
+    const TickType_t        start = xTaskGetTickCount();
+    const uint32_t          frame_cnt = priv->gps_framer.sentence_cnt + priv->ubx_parser.frame_cnt;
+    uart_event_t            event;
+
+    // Only Checksum-Valid Frames Count, Garbage At The Wrong Baud Never Does
+    while( ( xTaskGetTickCount() - start ) < pdMS_TO_TICKS( timeout_ms ) ) {
+        if( pdTRUE != xQueueReceive( priv->uart_queue, &event, pdMS_TO_TICKS( 100 ) ) ) {
+            continue;
+        }
+
+        // Receiver May Talk Either Protocol, Or Only UBX With No Line Feeds At All
+        if( ( UART_DATA == event.type ) || ( UART_PATTERN_DET == event.type ) ) {
+            gps_read_detect( priv );
+        }
+        else {
+            gps_handle_event( priv, &event );
+        }
+
+        if( ( priv->gps_framer.sentence_cnt + priv->ubx_parser.frame_cnt ) != frame_cnt ) {
+            // Pattern Reads Take Over From Here, Start Them On A Line Boundary
+            gps_rx_restart( priv );
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void gps_set_baud( gps_intf_priv_t * priv, uint32_t baud )
+{
+    uart_set_baudrate( priv->uart_port, baud );
+    gps_rx_restart( priv );
+
+    priv->baud = baud;
+}
+
+static void gps_rx_restart( gps_intf_priv_t * priv )
+{
+    uart_flush_input( priv->uart_port );
+    xQueueReset( priv->uart_queue );
+    uart_pattern_queue_reset( priv->uart_port, UART_PATTERN_Q_SZ );
+    nmea_framer_reset( &priv->gps_framer );
+    ubx_parser_reset( &priv->ubx_parser );
+}
+
+static void gps_configure_outputs( gps_intf_priv_t * priv )
+{
+    uint8_t                 pmtk314[PMTK314_FIELD_CNT] = { 0 };
+    char                    pmtk[8 + 2 * PMTK314_FIELD_CNT];
+    int                     len;
+
+    for( size_t i = 0; i < NMEA_OUTPUTS_CNT; i++ ) {
+        const gps_nmea_output_t   * output = &g_nmea_outputs[i];
+        uint8_t                     cfg_msg[3];
+
+        cfg_msg[0] = UBX_CLASS_NMEA;
+        cfg_msg[1] = output->ubx_msg_id;
+        cfg_msg[2] = ( gps_nmea_type_from_code( output->code ) >= 0 ) ? output->divider : 0;
+
+        pmtk314[output->pmtk314_field] = cfg_msg[2];
+        gps_send_ubx( priv, UBX_CLASS_CFG, UBX_CFG_MSG, cfg_msg, sizeof( cfg_msg ) );
+    }
+
+    len = snprintf( pmtk, sizeof( pmtk ), "PMTK314" );
+    for( int i = 0; i < PMTK314_FIELD_CNT; i++ ) {
+        len += snprintf( &pmtk[len], sizeof( pmtk ) - len, ",%u", pmtk314[i] );
+    }
+    gps_send_pmtk( priv, pmtk );
+}
+
+static void gps_send_pmtk( gps_intf_priv_t * priv, const char * body )
+{
+    char                    sentence[GPS_SENTENCE_MAX_SZ];
+    uint8_t                 cksum = 0;
+    int                     len;
+
+    for( const char * ch = body; '\0' != *ch; ch++ ) {
+        cksum ^= (uint8_t)*ch;
+    }
+
+    len = snprintf( sentence, sizeof( sentence ), "$%s*%02X\r\n", body, cksum );
+    uart_write_bytes( priv->uart_port, sentence, len );
+}
+
+static void gps_send_ubx( gps_intf_priv_t * priv, uint8_t cls, uint8_t id, const uint8_t * payload, uint16_t len )
+{
+    uint8_t                 frame[UBX_HDR_SZ + 32 + UBX_CKSUM_SZ];
+    size_t                  frame_len;
+
+    frame_len = ubx_frame_build( frame, sizeof( frame ), cls, id, payload, len );
+    if( frame_len > 0 ) {
+        uart_write_bytes( priv->uart_port, frame, frame_len );
+    }
+}
+
+static void gps_read_chunk( gps_intf_priv_t * priv, int len )
+{
+    uint8_t                 chunk[RX_CHUNK_SZ];
+    int                     rd_len;
+
+    // Read Up To And Including '<LF>', Framer Picks Out Sentences
+    while( len > 0 ) {
+        rd_len = uart_read_bytes( priv->uart_port, chunk, MIN( len, RX_CHUNK_SZ ), 100 / portTICK_RATE_MS );
+        if( rd_len <= 0 ) {
             break;
+        }
 
-            case MINMEA_SENTENCE_VTG: {
-                struct minmea_sentence_vtg frame;
+        priv->rx_us = timebase_now_us();
+        priv->stats.uart_bytes += rd_len;
+        nmea_framer_feed( &priv->gps_framer, chunk, rd_len );
+        len -= rd_len;
+    }
+}
 
-                if( minmea_parse_vtg( &frame, (const char *)gps_sentence ) )
-                {
-//                    ESP_LOGI(TAG, "Speed (KPH): %f", minmea_tofloat( &frame.speed_kph ));
-                    PUB_DBL("gps.speed", minmea_tofloat( &frame.speed_kph ));
-                }
-            }
+static void gps_read_ubx( gps_intf_priv_t * priv, int len )
+{
+    uint8_t                 chunk[RX_CHUNK_SZ];
+    int                     rd_len;
+
+    while( len > 0 ) {
+        rd_len = uart_read_bytes( priv->uart_port, chunk, MIN( len, RX_CHUNK_SZ ), 0 );
+        if( rd_len <= 0 ) {
             break;
+        }
+
+        priv->rx_us = timebase_now_us();
+        priv->stats.uart_bytes += rd_len;
+        ubx_parser_feed( &priv->ubx_parser, chunk, rd_len );
+        len -= rd_len;
+    }
+}
 
-            case MINMEA_SENTENCE_GGA: {
-                struct minmea_sentence_gga frame;
+static void gps_read_detect( gps_intf_priv_t * priv )
+{
+    uint8_t                 chunk[RX_CHUNK_SZ];
+    size_t                  len = 0;
+    int                     rd_len;
 
-                if( minmea_parse_gga( &frame, (const char *)gps_sentence )) {
-//                    ESP_LOGI(TAG, "fix_quality: %d  sat_tracked: %d", frame.fix_quality, frame.satellites_tracked);
-                }
-            }
+    // Everything Buffered Goes To Both, Whichever Frames First Wins
+    uart_get_buffered_data_len( priv->uart_port, &len );
+    while( len > 0 ) {
+        rd_len = uart_read_bytes( priv->uart_port, chunk, MIN( len, RX_CHUNK_SZ ), 0 );
+        if( rd_len <= 0 ) {
             break;
+        }
+
+        priv->rx_us = timebase_now_us();
+        priv->stats.uart_bytes += rd_len;
+        nmea_framer_feed( &priv->gps_framer, chunk, rd_len );
+        ubx_parser_feed( &priv->ubx_parser, chunk, rd_len );
+        len -= rd_len;
+    }
+
+    // Queued Line Feed Positions Point Into Bytes Already Consumed
+    uart_pattern_queue_reset( priv->uart_port, UART_PATTERN_Q_SZ );
+}
+
+static void gps_apply_protocol( gps_intf_priv_t * priv )
+{
+    gps_protocol_t          req = (gps_protocol_t)atomic_load( &priv->protocol_req );
+
+    if( req == priv->protocol ) {
+        return;
+    }
+
+    priv->protocol = req;
+
+    // Line Feed Pattern Only Means Something In NMEA, In Binary It Is Just Noise
+    if( GPS_PROTOCOL_UBX == priv->protocol ) {
+        const uint8_t   cfg_msg[3] = { UBX_CLASS_NAV, UBX_NAV_PVT, 1 };
+
+        uart_disable_pattern_det_intr( priv->uart_port );
+        gps_send_ubx( priv, UBX_CLASS_CFG, UBX_CFG_MSG, cfg_msg, sizeof( cfg_msg ) );
+    }
+    else {
+        uart_enable_pattern_det_baud_intr( priv->uart_port, UART_PATTERN_CHR, 1, 9, 0, 0 );
+    }
+
+    uart_pattern_queue_reset( priv->uart_port, UART_PATTERN_Q_SZ );
+    uart_flush_input( priv->uart_port );
+    nmea_framer_reset( &priv->gps_framer );
+    ubx_parser_reset( &priv->ubx_parser );
 
-            case MINMEA_SENTENCE_GSA: {
-                struct minmea_sentence_gsa frame;
+    ESP_LOGI(TAG, "protocol: %s", ( GPS_PROTOCOL_UBX == priv->protocol ) ? "UBX" : "NMEA" );
+}
+
+static void gps_ubx_frame( void * ctx, uint8_t cls, uint8_t id, const uint8_t * payload, uint16_t len )
+{
+    gps_intf_priv_t       * priv = (gps_intf_priv_t *)ctx;
+    gps_fix_t             * fix = &priv->ubx_fix;
+    gps_fix_status_t        status;
+    uint32_t                start_ccount;
+
+    if( ( UBX_CLASS_MGA == cls ) && ( UBX_MGA_DBD == id ) ) {
+        gps_aid_dbd_frame( priv, payload, len );
+        return;
+    }
+
+    if( ( UBX_CLASS_NAV != cls ) || ( UBX_NAV_PVT != id ) ) {
+        return;
+    }
+
+    start_ccount = xthal_get_ccount();
+    if( !ubx_nav_pvt_decode( payload, len, fix ) ) {
+        return;
+    }
+    fix->t_us = priv->rx_us;
+
+    if( fix->flags & GPS_FIX_FLAG_TIME_VALID ) {
+        timebase_publish( "gps.time", fix->time, fix->t_us );
+    }
+
+    ubx_fix_status( fix, &status );
+    gps_nmea_publish_fix( &status );
+
+    gps_track_fix( priv, fix );
+    gps_publish_position( fix );
+
+    // Every Position Save Is Followed By A Fresh Navigation Database
+    if( gps_aid_fix( priv, fix ) ) {
+        gps_aid_dbd_poll( priv );
+    }
+    gps_aid_dbd_check( priv );
+
+    if( fix->flags & GPS_FIX_FLAG_FIX_OK ) {
+        // mm/s To km/h * 100, Rounded
+        timebase_publish( "gps.speed", ( fix->speed * 36 + 50 ) / 100, fix->t_us );
+    }
+
+    gps_hist_add( &priv->stats.parse_cycles[GPS_STATS_PARSE_PVT], xthal_get_ccount() - start_ccount );
+    gps_hist_add( &priv->stats.latency_us, (uint32_t)( timebase_now_us() - fix->t_us ) );
+}
+
+static char * gps_sentence_emit( void * ctx, char * sentence, size_t len )
+{
+    gps_intf_priv_t       * priv = (gps_intf_priv_t *)ctx;
+    unsigned int            head;
+
+    head = atomic_load_explicit( &priv->gps_sentence_head, memory_order_relaxed );
+
+    if( sentence == priv->gps_sentence_scratch ) {
+        // Ring Was Full When This Sentence Started
+        priv->stats.drop_cnt++;
+    }
+    else {
+        // Publish Slot To Parser
+        priv->gps_sentence_slots[head & SENTENCE_SLOT_MASK].len     = len;
+        priv->gps_sentence_slots[head & SENTENCE_SLOT_MASK].t_us    = priv->rx_us;
+        head++;
+        atomic_store_explicit( &priv->gps_sentence_head, head, memory_order_release );
+        xTaskNotifyGive( priv->gps_parse_task );
+    }
+
+    // Parser Still Owns Every Slot, Next Sentence Goes Nowhere
+    if( ( head - atomic_load_explicit( &priv->gps_sentence_tail, memory_order_acquire ) ) >= SENTENCE_SLOT_CNT ) {
+        return priv->gps_sentence_scratch;
+    }
+
+    return priv->gps_sentence_slots[head & SENTENCE_SLOT_MASK].data;
+}
+
+_Noreturn static void gps_parse_task( void * params )
+{
+    gps_intf_priv_t       * priv = (gps_intf_priv_t *)params;
+    gps_sentence_slot_t   * slot;
+    unsigned int            tail;
+    int                     type;
+    uint32_t                start_ccount;
+    bool                    has_fix;
+
+    gps_sentence_refresh_wanted( priv );
+
+    for(;;) {
+        // Wait For Data, One Notification Per Queued Sentence Or Deferred Save
+        ulTaskNotifyTake( pdFALSE, portMAX_DELAY );
+
+        gps_aid_commit( priv );
 
-                if( minmea_parse_gsa( &frame, gps_sentence ) ) {
-//                    ESP_LOGI(TAG, "sats: %d %d %d %d %d %d %d %d %d %d %d %d", frame.sats[0], frame.sats[1], frame.sats[2], frame.sats[3], frame.sats[4], frame.sats[5], frame.sats[6], frame.sats[7], frame.sats[8], frame.sats[9], frame.sats[10], frame.sats[11]);
-                }
+        tail = atomic_load_explicit( &priv->gps_sentence_tail, memory_order_relaxed );
+        if( tail == atomic_load_explicit( &priv->gps_sentence_head, memory_order_acquire ) ) {
+            continue;
+        }
+
+        // Subscribers Come And Go, Recheck Who Wants What Now And Then
+        if( ( xTaskGetTickCount() - priv->gps_sentence_wanted_tick ) >= pdMS_TO_TICKS( SUBS_REFRESH_MS ) ) {
+            gps_sentence_refresh_wanted( priv );
+        }
+
+        // Parse In Place, Slot Stays Ours Until Tail Moves On
+        slot = &priv->gps_sentence_slots[tail & SENTENCE_SLOT_MASK];
+
+        // Framer Already Verified The Checksum, Only Parse What Someone Listens To
+        type = gps_nmea_type( slot->data, slot->len );
+        if( ( type >= 0 ) && ( priv->gps_sentence_wanted & ( 1u << type ) ) ) {
+            // Cycles Include Any Preemption, The Histogram Tail Shows It
+            start_ccount = xthal_get_ccount();
+            has_fix = gps_nmea_parse( type, slot->data, slot->t_us, &priv->nmea_fix );
+            gps_hist_add( &priv->stats.parse_cycles[type], xthal_get_ccount() - start_ccount );
 
+            if( has_fix ) {
+                gps_track_fix( priv, &priv->nmea_fix );
+                gps_publish_position( &priv->nmea_fix );
+                gps_aid_fix( priv, &priv->nmea_fix );
             }
-            break;
 
-            default:
-            break;
+            gps_hist_add( &priv->stats.latency_us, (uint32_t)( timebase_now_us() - slot->t_us ) );
         }
+
+        // Hand Slot Back To Reader
+        atomic_store_explicit( &priv->gps_sentence_tail, tail + 1, memory_order_release );
     }
 
     vTaskDelete(NULL);
-}
\ No newline at end of file
+}
+
+static void gps_sentence_refresh_wanted( gps_intf_priv_t * priv )
+{
+    uint32_t                wanted = 0;
+
+    for( int i = 0; i < GPS_NMEA_CNT; i++ ) {
+        if( gps_topic_has_subs( gps_nmea_topic( i ) ) ) {
+            wanted |= ( 1u << i );
+        }
+    }
+
+    // Track Log And Warm Start Need The Position Out Of RMC Whether Or Not Anyone Wants The Time
+    wanted |= ( 1u << GPS_NMEA_RMC );
+
+    priv->gps_sentence_wanted       = wanted;
+    priv->gps_sentence_wanted_tick  = xTaskGetTickCount();
+}
+
+static void gps_track_fix( gps_intf_priv_t * priv, const gps_fix_t * fix )
+{
+    const uint8_t           needed = GPS_FIX_FLAG_FIX_OK | GPS_FIX_FLAG_TIME_VALID;
+
+    if( atomic_load( &priv->track_log ) && ( needed == ( fix->flags & needed ) ) ) {
+        track_log_append( fix );
+    }
+}
+
+static void gps_publish_position( const gps_fix_t * fix )
+{
+    gps_fix_t             * copy;
+
+    if( !( fix->flags & GPS_FIX_FLAG_FIX_OK ) || !gps_topic_has_subs( "gps.position" ) ) {
+        return;
+    }
+
+    copy = malloc( sizeof( *copy ) );
+    if( NULL != copy ) {
+        memcpy( copy, fix, sizeof( *copy ) );
+        PUB_BUF("gps.position", copy, sizeof( *copy ), free);
+    }
+}
+
+static void gps_aid_inject( gps_intf_priv_t * priv )
+{
+    const time_t            now = time( NULL );
+    gps_aid_pos_t           pos;
+    uint8_t                 ini_pos[UBX_MGA_INI_POS_LLH_SZ];
+    uint8_t               * dbd;
+    size_t                  dbd_len = 0;
+    bool                    time_ok;
+
+    if( !gps_aid_load_pos( &pos ) ) {
+        ESP_LOGI(TAG, "no warm start data, cold start");
+        return;
+    }
+
+    // A Clock Behind The Last Fix Has Not Been Set This Boot
+    time_ok = ( now >= (time_t)pos.time );
+
+    // u-blox Wants Time, Then Position, Then The Navigation Database
+    if( time_ok ) {
+        uint8_t     ini_time[UBX_MGA_INI_TIME_UTC_SZ];
+
+        ubx_mga_ini_time_utc( ini_time, (uint32_t)now, AID_TIME_ACC_S );
+        gps_send_ubx( priv, UBX_CLASS_MGA, UBX_MGA_INI, ini_time, sizeof( ini_time ) );
+    }
+
+    ubx_mga_ini_pos_llh( ini_pos, pos.lat, pos.lon, pos.alt, AID_POS_ACC_CM );
+    gps_send_ubx( priv, UBX_CLASS_MGA, UBX_MGA_INI, ini_pos, sizeof( ini_pos ) );
+
+    dbd = malloc( GPS_AID_DBD_MAX_SZ );
+    if( NULL != dbd ) {
+        dbd_len = gps_aid_load_dbd( dbd, GPS_AID_DBD_MAX_SZ );
+        if( dbd_len > 0 ) {
+            uart_write_bytes( priv->uart_port, dbd, dbd_len );
+        }
+        free( dbd );
+    }
+
+    // MTK Takes Position And Time Together Or Not At All
+    if( time_ok ) {
+        struct tm   tm;
+        char        lat[16];
+        char        lon[16];
+        char        pmtk[80];
+
+        gmtime_r( &now, &tm );
+        gps_format_deg( lat, sizeof( lat ), pos.lat );
+        gps_format_deg( lon, sizeof( lon ), pos.lon );
+        snprintf( pmtk, sizeof( pmtk ), "PMTK741,%s,%s,%d,%04d,%02d,%02d,%02d,%02d,%02d",
+                  lat, lon, pos.alt / 1000, tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday,
+                  tm.tm_hour, tm.tm_min, tm.tm_sec );
+        gps_send_pmtk( priv, pmtk );
+    }
+
+    priv->aided = true;
+
+    ESP_LOGI(TAG, "warm start: position from %u, time %s, %u bytes of navigation database",
+             pos.time, time_ok ? "injected" : "unknown", (unsigned)dbd_len);
+}
+
+static bool gps_aid_fix( gps_intf_priv_t * priv, const gps_fix_t * fix )
+{
+    const uint8_t           needed = GPS_FIX_FLAG_FIX_OK | GPS_FIX_FLAG_TIME_VALID;
+    const int64_t           now_us = timebase_now_us();
+
+    if( !( fix->flags & GPS_FIX_FLAG_FIX_OK ) ) {
+        return false;
+    }
+
+    if( !priv->ttff_done ) {
+        priv->ttff_done     = true;
+        priv->aid_save_us   = now_us + AID_FIRST_SAVE_US;
+        priv->aid_ttff_ms   = (uint32_t)( ( now_us - priv->start_us ) / 1000 );
+        gps_aid_defer( priv, AID_PEND_TTFF );
+    }
+
+    if( ( needed != ( fix->flags & needed ) ) || ( now_us < priv->aid_save_us ) ) {
+        return false;
+    }
+
+    priv->aid_save_us = now_us + AID_SAVE_PERIOD_US;
+
+    // Half An Hour Apart, The Last One Is Long Written
+    if( atomic_load_explicit( &priv->aid_pend, memory_order_acquire ) & AID_PEND_POS ) {
+        return false;
+    }
+
+    priv->aid_pos.time  = fix->time;
+    priv->aid_pos.lat   = fix->lat;
+    priv->aid_pos.lon   = fix->lon;
+    priv->aid_pos.alt   = fix->alt;
+    gps_aid_defer( priv, AID_PEND_POS );
+
+    return true;
+}
+
+static void gps_aid_dbd_poll( gps_intf_priv_t * priv )
+{
+    if( NULL != priv->dbd_buf ) {
+        return;
+    }
+
+    priv->dbd_buf = malloc( GPS_AID_DBD_MAX_SZ );
+    if( NULL == priv->dbd_buf ) {
+        return;
+    }
+
+    priv->dbd_len   = 0;
+    priv->dbd_us    = timebase_now_us();
+    gps_send_ubx( priv, UBX_CLASS_MGA, UBX_MGA_DBD, NULL, 0 );
+}
+
+static void gps_aid_dbd_frame( gps_intf_priv_t * priv, const uint8_t * payload, uint16_t len )
+{
+    if( NULL == priv->dbd_buf ) {
+        return;
+    }
+
+    // Kept As Whole Frames, Ready To Write Back. Once Full The Rest Is Dropped,
+    // Part Of The Database Still Beats None
+    priv->dbd_len += ubx_frame_build( &priv->dbd_buf[priv->dbd_len], GPS_AID_DBD_MAX_SZ - priv->dbd_len,
+                                      UBX_CLASS_MGA, UBX_MGA_DBD, payload, len );
+    priv->dbd_us = timebase_now_us();
+}
+
+static void gps_aid_dbd_check( gps_intf_priv_t * priv )
+{
+    if( ( NULL == priv->dbd_buf ) || ( ( timebase_now_us() - priv->dbd_us ) < AID_DBD_QUIET_US ) ) {
+        return;
+    }
+
+    // Receivers Without MGA Never Answer, Keep Whatever An Earlier Dump Left
+    if( ( priv->dbd_len > 0 ) && !( atomic_load_explicit( &priv->aid_pend, memory_order_acquire ) & AID_PEND_DBD ) ) {
+        // Parse Task Frees It Once Written
+        priv->aid_dbd_buf = priv->dbd_buf;
+        priv->aid_dbd_len = priv->dbd_len;
+        gps_aid_defer( priv, AID_PEND_DBD );
+    }
+    else {
+        free( priv->dbd_buf );
+    }
+
+    priv->dbd_buf = NULL;
+}
+
+static void gps_aid_defer( gps_intf_priv_t * priv, unsigned int pend )
+{
+    atomic_fetch_or_explicit( &priv->aid_pend, pend, memory_order_release );
+    xTaskNotifyGive( priv->gps_parse_task );
+}
+
+static void gps_aid_commit( gps_intf_priv_t * priv )
+{
+    unsigned int            pend = atomic_load_explicit( &priv->aid_pend, memory_order_acquire );
+
+    if( 0 == pend ) {
+        return;
+    }
+
+    if( pend & AID_PEND_TTFF ) {
+        gps_aid_ttff( priv->aid_ttff_ms, priv->aided );
+    }
+
+    if( pend & AID_PEND_POS ) {
+        gps_aid_save_pos( &priv->aid_pos );
+    }
+
+    if( pend & AID_PEND_DBD ) {
+        gps_aid_save_dbd( priv->aid_dbd_buf, priv->aid_dbd_len );
+        ESP_LOGI(TAG, "saved %u bytes of navigation database", (unsigned)priv->aid_dbd_len);
+        free( priv->aid_dbd_buf );
+        priv->aid_dbd_buf = NULL;
+    }
+
+    // Only Now May The Deciding Task Refill Them
+    atomic_fetch_and_explicit( &priv->aid_pend, ~pend, memory_order_release );
+}
+
+static void gps_format_deg( char * buf, size_t buf_sz, int32_t deg )
+{
+    uint32_t                mag = ( deg < 0 ) ? -(uint32_t)deg : (uint32_t)deg;
+
+    snprintf( buf, buf_sz, "%s%u.%07u", ( deg < 0 ) ? "-" : "", mag / 10000000u, mag % 10000000u );
+}
+
+static bool gps_topic_has_subs( const char * topic )
+{
+    char                    name[TOPIC_MAX_SZ];
+    char                  * dot;
+
+    strncpy( name, topic, sizeof( name ) - 1 );
+    name[sizeof( name ) - 1] = '\0';
+
+    // Subscribers Of A Parent Topic ("gps") Also Receive Its Children
+    for(;;) {
+        if( ps_num_subs( name ) > 0 ) {
+            return true;
+        }
+
+        dot = strrchr( name, '.' );
+        if( NULL == dot ) {
+            return false;
+        }
+        *dot = '\0';
+    }
+}
@@ -10,15 +10,119 @@
 /*
  * Defines
  */
+#define GPS_SPEED_SCALE             (100)   // "gps.speed" Is km/h * GPS_SPEED_SCALE, As A timebase_sample_t
+
+#define GPS_FIX_FLAG_FIX_OK         (0x01)
+#define GPS_FIX_FLAG_TIME_VALID     (0x02)
+
+#define GPS_DOP_SCALE               (100)   // DOPs In "gps.fix" Are DOP * GPS_DOP_SCALE
+#define GPS_DOP_MAX                 (20 * GPS_DOP_SCALE)    // Worse Than This Is Not A Usable Fix
+#define GPS_FIX_SATS_CNT            (12)
+
+#define GPS_FIX_TYPE_NONE           (1)
+#define GPS_FIX_TYPE_2D             (2)
+#define GPS_FIX_TYPE_3D             (3)
+
+#define GPS_SATS_CNT                (32)    // Slots In "gps.sats", Satellites Past This Are Left Out
 
 /*
  * Types
  */
+typedef enum
+    {
+    GPS_PROTOCOL_NMEA,
+    GPS_PROTOCOL_UBX
+    } gps_protocol_t;
+
+// From The GSV Talker ID, Satellite Numbers Only Mean Something Within One
+typedef enum
+    {
+    GPS_SYSTEM_GPS,
+    GPS_SYSTEM_GLONASS,
+    GPS_SYSTEM_GALILEO,
+    GPS_SYSTEM_BEIDOU,
+    GPS_SYSTEM_QZSS,
+    GPS_SYSTEM_OTHER
+    } gps_system_t;
+
+// Published On "gps.position" For Every Fix With GPS_FIX_FLAG_FIX_OK
+typedef struct __attribute__((packed))
+    {
+    uint32_t                time;       // UTC, Seconds Since Epoch
+    int32_t                 nano;       // Fraction Of Second, ns
+    int32_t                 lat;        // 1e-7 deg
+    int32_t                 lon;        // 1e-7 deg
+    int32_t                 speed;      // Ground Speed, mm/s
+    int32_t                 heading;    // Heading Of Motion, 1e-5 deg
+    int32_t                 alt;        // Height Above MSL, mm, 0 If Not Reported
+    uint8_t                 fix_type;
+    uint8_t                 num_sats;
+    uint8_t                 flags;      // GPS_FIX_FLAG_*
+    uint16_t                pdop;       // PDOP * GPS_DOP_SCALE
+    int64_t                 t_us;       // timebase_now_us() When It Came Off The UART
+    } gps_fix_t;
+
+// Published on "gps.fix" once per epoch, GGA and GSA (or NAV-PVT) merged
+typedef struct
+    {
+    uint8_t                 quality;    // GGA Fix Quality, 0 = Invalid
+    uint8_t                 fix_type;   // GPS_FIX_TYPE_*, 0 = Not Yet Known
+    uint8_t                 sats_tracked;
+    uint8_t                 sats_used;
+    uint16_t                hdop;       // 0 = Not Reported
+    uint16_t                pdop;
+    uint16_t                vdop;
+    uint8_t                 sats[GPS_FIX_SATS_CNT];     // PRNs Used In The Solution
+    int64_t                 t_us;       // timebase_now_us() When The Epoch Closed
+    } gps_fix_status_t;
+
+typedef struct
+    {
+    uint8_t                 system;     // gps_system_t
+    uint8_t                 prn;        // 0 = Empty Slot
+    uint8_t                 elevation;  // deg
+    uint8_t                 snr;        // dB-Hz, 0 = In View But Not Tracked
+    uint16_t                azimuth;    // deg, With elevation 0 Most Likely Not Reported
+    } gps_sat_t;
+
+/*
+ * Published on "gps.sats" every time a GSV group completes. A satellite keeps
+ * its slot for as long as it stays in view, so a slot that reads the same as
+ * last time has not changed.
+ */
+typedef struct
+    {
+    int64_t                 t_us;       // timebase_now_us() Of The Last Sentence
+    uint8_t                 in_view;    // Slots In Use
+    gps_sat_t               sats[GPS_SATS_CNT];
+    } gps_sats_t;
 
 /*
  * Globals Externs
  */
 
+// Days From Civil, Without Going Through The Time Zone Aware libc
+static inline uint32_t gps_utc_to_epoch( uint16_t year, uint8_t month, uint8_t day, uint8_t hour, uint8_t min, uint8_t sec )
+{
+    int32_t     y = year - ( month <= 2 );
+    int32_t     era = y / 400;
+    uint32_t    yoe = (uint32_t)( y - era * 400 );
+    uint32_t    doy = ( 153 * ( month + ( month > 2 ? -3 : 9 ) ) + 2 ) / 5 + day - 1;
+    uint32_t    doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    int32_t     days = era * 146097 + (int32_t)doe - 719468;
+
+    return (uint32_t)days * 86400u + hour * 3600u + min * 60u + sec;
+}
+
+static inline bool gps_fix_status_valid( const gps_fix_status_t * status )
+{
+    uint16_t    dop = status->pdop ? status->pdop : status->hdop;
+
+    return ( status->quality > 0 ) && ( status->fix_type >= GPS_FIX_TYPE_2D ) && ( dop <= GPS_DOP_MAX );
+}
+
 void gps_start( void );
 void gps_stop( void );
+void gps_set_protocol( gps_protocol_t protocol );
+void gps_set_track_log( bool enable );
 #endif //DASH_GPS_H
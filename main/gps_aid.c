@@ -0,0 +1,157 @@
+/*********************
+ *      INCLUDES
+ *********************/
+#include <string.h>
+
+#include <pubsub.h>
+
+#include "esp_system.h"
+#include "esp_log.h"
+#include "nvs.h"
+
+#include "gps_aid.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+#define TAG                     "GPS_AID"
+
+#define NVS_NAMESPACE           "gps"
+#define NVS_KEY_POS             "pos"
+#define NVS_KEY_DBD             "dbd"
+#define NVS_KEY_TTFF            "ttff"
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+// TTFF Counters, Index 0 Is Cold Starts, 1 Is Aided Starts
+typedef struct
+    {
+    uint32_t                boot_cnt;
+    uint32_t                last_ms;
+    uint32_t                fix_cnt[2];
+    uint32_t                sum_ms[2];
+    } gps_aid_ttff_t;
+
+typedef struct
+    {
+    nvs_handle_t            nvs;
+    bool                    nvs_ok;
+    gps_aid_ttff_t          ttff;
+    } gps_aid_priv_t;
+
+/**********************
+ *      MACROS
+ **********************/
+
+/**********************
+ *     GLOBALS
+ **********************/
+static gps_aid_priv_t       g_priv;
+
+/**********************
+ *     CONSTANTS
+ **********************/
+
+/**********************
+ *    PROTOTYPES
+ **********************/
+static bool gps_aid_load( const char * key, void * buf, size_t * len );
+static void gps_aid_save( const char * key, const void * buf, size_t len );
+
+void gps_aid_init( void )
+{
+    size_t                  len = sizeof( g_priv.ttff );
+    esp_err_t               err;
+
+    err = nvs_open( NVS_NAMESPACE, NVS_READWRITE, &g_priv.nvs );
+    if( ESP_OK != err ) {
+        ESP_LOGW(TAG, "nvs open failed (%s), no warm start", esp_err_to_name( err ));
+        return;
+    }
+    g_priv.nvs_ok = true;
+
+    // Count The Boot Now, So Boots That Never Get A Fix Show Up Too
+    if( !gps_aid_load( NVS_KEY_TTFF, &g_priv.ttff, &len ) || ( sizeof( g_priv.ttff ) != len ) ) {
+        memset( &g_priv.ttff, 0, sizeof( g_priv.ttff ) );
+    }
+    g_priv.ttff.boot_cnt++;
+    gps_aid_save( NVS_KEY_TTFF, &g_priv.ttff, sizeof( g_priv.ttff ) );
+}
+
+bool gps_aid_load_pos( gps_aid_pos_t * pos )
+{
+    size_t                  len = sizeof( *pos );
+
+    return gps_aid_load( NVS_KEY_POS, pos, &len ) && ( sizeof( *pos ) == len );
+}
+
+void gps_aid_save_pos( const gps_aid_pos_t * pos )
+{
+    gps_aid_save( NVS_KEY_POS, pos, sizeof( *pos ) );
+}
+
+size_t gps_aid_load_dbd( uint8_t * buf, size_t buf_sz )
+{
+    size_t                  len = buf_sz;
+
+    return gps_aid_load( NVS_KEY_DBD, buf, &len ) ? len : 0;
+}
+
+void gps_aid_save_dbd( const uint8_t * buf, size_t len )
+{
+    gps_aid_save( NVS_KEY_DBD, buf, len );
+}
+
+void gps_aid_ttff( uint32_t ttff_ms, bool aided )
+{
+    gps_aid_ttff_t        * ttff = &g_priv.ttff;
+
+    ttff->last_ms = ttff_ms;
+    ttff->fix_cnt[aided]++;
+    ttff->sum_ms[aided] += ttff_ms;
+
+    ESP_LOGI(TAG, "TTFF %u ms (%s), boots %u, cold avg %u ms / %u, aided avg %u ms / %u",
+             ttff_ms, aided ? "aided" : "cold", ttff->boot_cnt,
+             ttff->fix_cnt[0] ? ttff->sum_ms[0] / ttff->fix_cnt[0] : 0, ttff->fix_cnt[0],
+             ttff->fix_cnt[1] ? ttff->sum_ms[1] / ttff->fix_cnt[1] : 0, ttff->fix_cnt[1]);
+
+    PUB_INT_FL("gps.ttff", ttff_ms, FL_STICKY);
+
+    gps_aid_save( NVS_KEY_TTFF, ttff, sizeof( *ttff ) );
+}
+
+static bool gps_aid_load( const char * key, void * buf, size_t * len )
+{
+    esp_err_t               err;
+
+    if( !g_priv.nvs_ok ) {
+        return false;
+    }
+
+    err = nvs_get_blob( g_priv.nvs, key, buf, len );
+    if( ( ESP_OK != err ) && ( ESP_ERR_NVS_NOT_FOUND != err ) ) {
+        ESP_LOGW(TAG, "load %s failed (%s)", key, esp_err_to_name( err ));
+    }
+
+    return ( ESP_OK == err );
+}
+
+static void gps_aid_save( const char * key, const void * buf, size_t len )
+{
+    esp_err_t               err;
+
+    if( !g_priv.nvs_ok ) {
+        return;
+    }
+
+    err = nvs_set_blob( g_priv.nvs, key, buf, len );
+    if( ESP_OK == err ) {
+        err = nvs_commit( g_priv.nvs );
+    }
+
+    if( ESP_OK != err ) {
+        ESP_LOGW(TAG, "save %s failed (%s)", key, esp_err_to_name( err ));
+    }
+}
@@ -0,0 +1,61 @@
+#ifndef DASH_GPS_AID_H
+#define DASH_GPS_AID_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/*********************
+ *      DEFINES
+ *********************/
+#define GPS_AID_DBD_MAX_SZ      (4096)  // Largest MGA-DBD Dump Kept
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+// Last Known Position, Injected As Aiding On The Next Start
+typedef struct
+    {
+    uint32_t                time;       // UTC Of The Fix, Seconds Since Epoch
+    int32_t                 lat;        // 1e-7 deg
+    int32_t                 lon;        // 1e-7 deg
+    int32_t                 alt;        // Height Above MSL, mm
+    } gps_aid_pos_t;
+
+/**********************
+ *      MACROS
+ **********************/
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/*
+ * Warm start data kept in NVS (namespace "gps"). gps_aid_init() counts the
+ * boot, the rest may be called from either GPS task.
+ */
+void gps_aid_init( void );
+
+bool gps_aid_load_pos( gps_aid_pos_t * pos );
+void gps_aid_save_pos( const gps_aid_pos_t * pos );
+
+// Raw UBX MGA-DBD Frames, Replayed To The Receiver As-Is
+size_t gps_aid_load_dbd( uint8_t * buf, size_t buf_sz );
+void gps_aid_save_dbd( const uint8_t * buf, size_t len );
+
+// Time To First Fix Since gps_start(), Counted Per Boot And Published On "gps.ttff" (ms)
+void gps_aid_ttff( uint32_t ttff_ms, bool aided );
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif //DASH_GPS_AID_H
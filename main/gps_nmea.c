@@ -0,0 +1,350 @@
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/param.h>
+
+#include <minmea/minmea.h>
+#include <pubsub.h>
+
+#include "timebase.h"
+#include "gps.h"
+#include "gps_nmea.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+typedef bool (*gps_nmea_parser_t)( const char * sentence, int64_t t_us, gps_fix_t * fix );
+
+typedef struct
+    {
+    const char            * topic;      // Parsed only while this has subscribers
+    gps_nmea_parser_t       parser;
+    } gps_nmea_handler_t;
+
+/**********************
+ *      MACROS
+ **********************/
+
+/**********************
+ *    PROTOTYPES
+ **********************/
+static bool gps_nmea_parse_rmc( const char * sentence, int64_t t_us, gps_fix_t * fix );
+static bool gps_nmea_parse_vtg( const char * sentence, int64_t t_us, gps_fix_t * fix );
+static bool gps_nmea_parse_gga( const char * sentence, int64_t t_us, gps_fix_t * fix );
+static bool gps_nmea_parse_gsa( const char * sentence, int64_t t_us, gps_fix_t * fix );
+static bool gps_nmea_parse_gsv( const char * sentence, int64_t t_us, gps_fix_t * fix );
+static gps_system_t gps_nmea_system( const char * sentence );
+static gps_sat_t * gps_nmea_sat_slot( gps_system_t system, uint8_t prn );
+static int32_t gps_nmea_coord( const struct minmea_float * coord );
+
+/**********************
+ *     GLOBALS
+ **********************/
+// GSA Lands Here Until The Next GGA Publishes It, Only Touched By The Parse Task
+static gps_fix_status_t g_fix_status;
+
+// GSV Groups Fill This In Place, Also Only Touched By The Parse Task
+static gps_sats_t           g_sats;
+static uint32_t             g_sats_seen;    // Slots Reported By The Group In Progress
+
+/**********************
+ *     CONSTANTS
+ **********************/
+static const gps_nmea_handler_t g_handlers[GPS_NMEA_CNT] =
+    {
+    [GPS_NMEA_RMC]      = { "gps.time",     gps_nmea_parse_rmc },
+    [GPS_NMEA_VTG]      = { "gps.speed",    gps_nmea_parse_vtg },
+    [GPS_NMEA_GGA]      = { "gps.fix",      gps_nmea_parse_gga },
+    [GPS_NMEA_GSA]      = { "gps.fix",      gps_nmea_parse_gsa },
+    [GPS_NMEA_GSV]      = { "gps.sats",     gps_nmea_parse_gsv },
+    };
+
+int gps_nmea_type( const char * sentence, size_t len )
+{
+    // "$ttFFF," Talker ID Is Ignored, Formatter Picks The Parser
+    if( len < 6 ) {
+        return -1;
+    }
+
+    return gps_nmea_type_from_code( NMEA_CODE( sentence[3], sentence[4], sentence[5] ) );
+}
+
+int gps_nmea_type_from_code( uint32_t code )
+{
+    switch( code ) {
+        case NMEA_CODE( 'R', 'M', 'C' ):
+            return GPS_NMEA_RMC;
+
+        case NMEA_CODE( 'V', 'T', 'G' ):
+            return GPS_NMEA_VTG;
+
+        case NMEA_CODE( 'G', 'G', 'A' ):
+            return GPS_NMEA_GGA;
+
+        case NMEA_CODE( 'G', 'S', 'A' ):
+            return GPS_NMEA_GSA;
+
+        case NMEA_CODE( 'G', 'S', 'V' ):
+            return GPS_NMEA_GSV;
+
+        default:
+            return -1;
+    }
+}
+
+const char * gps_nmea_topic( gps_nmea_type_t type )
+{
+    return g_handlers[type].topic;
+}
+
+bool gps_nmea_parse( gps_nmea_type_t type, const char * sentence, int64_t t_us, gps_fix_t * fix )
+{
+    return g_handlers[type].parser( sentence, t_us, fix );
+}
+
+void gps_nmea_publish_fix( const gps_fix_status_t * status )
+{
+    gps_fix_status_t      * buf = malloc( sizeof( *buf ) );
+
+    if( NULL == buf ) {
+        return;
+    }
+
+    *buf = *status;
+    PUB_BUF("gps.fix", buf, sizeof( *buf ), free);
+}
+
+static bool gps_nmea_parse_rmc( const char * sentence, int64_t t_us, gps_fix_t * fix )
+{
+    struct minmea_sentence_rmc frame;
+    bool    time_valid;
+
+    if( !minmea_parse_rmc( &frame, sentence ) ) {
+        return false;
+    }
+
+    // Update Time, minmea_gettime() Goes Through mktime() And Picks Up The Local Zone
+    time_valid = ( frame.date.year >= 0 ) && ( frame.date.month > 0 ) && ( frame.date.day > 0 );
+    fix->time = 0;
+    if( time_valid ) {
+        fix->time = gps_utc_to_epoch( 2000 + frame.date.year, frame.date.month, frame.date.day,
+                                      frame.time.hours, frame.time.minutes, frame.time.seconds );
+        timebase_publish( "gps.time", fix->time, t_us );
+    }
+
+    // Same Units As NAV-PVT, 1 Knot Is 514.444 mm/s
+    fix->nano       = frame.time.microseconds * 1000;
+    fix->lat        = gps_nmea_coord( &frame.latitude );
+    fix->lon        = gps_nmea_coord( &frame.longitude );
+    fix->speed      = ( 0 == frame.speed.scale ) ? 0 : (int32_t)( (int64_t)frame.speed.value * 514444 / ( frame.speed.scale * 1000LL ) );
+    fix->heading    = ( 0 == frame.course.scale ) ? 0 : (int32_t)( (int64_t)frame.course.value * 100000 / frame.course.scale );
+    fix->alt        = 0;
+    fix->fix_type   = frame.valid ? GPS_FIX_TYPE_3D : 0;
+    fix->num_sats   = 0;
+    fix->pdop       = 0;
+    fix->t_us       = t_us;
+
+    fix->flags      = 0;
+    if( time_valid ) {
+        fix->flags |= GPS_FIX_FLAG_TIME_VALID;
+    }
+    if( frame.valid ) {
+        fix->flags |= GPS_FIX_FLAG_FIX_OK;
+    }
+
+    return true;
+}
+
+static bool gps_nmea_parse_vtg( const char * sentence, int64_t t_us, gps_fix_t * fix )
+{
+    struct minmea_sentence_vtg frame;
+
+    if( minmea_parse_vtg( &frame, sentence ) )
+    {
+        // Rescale Fixed Point Field, No Float On The Way Through
+        timebase_publish( "gps.speed", minmea_rescale( &frame.speed_kph, GPS_SPEED_SCALE ), t_us );
+    }
+
+    return false;
+}
+
+static bool gps_nmea_parse_gga( const char * sentence, int64_t t_us, gps_fix_t * fix )
+{
+    struct minmea_sentence_gga frame;
+
+    if( minmea_parse_gga( &frame, sentence ) )
+    {
+        // GGA Closes The Epoch, Publish With Whatever GSA Said Before It
+        g_fix_status.quality        = (uint8_t)frame.fix_quality;
+        g_fix_status.sats_tracked   = (uint8_t)frame.satellites_tracked;
+        g_fix_status.hdop           = (uint16_t)minmea_rescale( &frame.hdop, GPS_DOP_SCALE );
+        g_fix_status.t_us           = t_us;
+
+        gps_nmea_publish_fix( &g_fix_status );
+    }
+
+    return false;
+}
+
+static bool gps_nmea_parse_gsa( const char * sentence, int64_t t_us, gps_fix_t * fix )
+{
+    struct minmea_sentence_gsa frame;
+
+    if( minmea_parse_gsa( &frame, sentence ) )
+    {
+        g_fix_status.fix_type   = (uint8_t)frame.fix_type;
+        g_fix_status.pdop       = (uint16_t)minmea_rescale( &frame.pdop, GPS_DOP_SCALE );
+        g_fix_status.hdop       = (uint16_t)minmea_rescale( &frame.hdop, GPS_DOP_SCALE );
+        g_fix_status.vdop       = (uint16_t)minmea_rescale( &frame.vdop, GPS_DOP_SCALE );
+        g_fix_status.sats_used  = 0;
+
+        for( size_t i = 0; i < GPS_FIX_SATS_CNT; i++ ) {
+            g_fix_status.sats[i] = (uint8_t)frame.sats[i];
+            if( 0 != frame.sats[i] ) {
+                g_fix_status.sats_used++;
+            }
+        }
+    }
+
+    return false;
+}
+
+static bool gps_nmea_parse_gsv( const char * sentence, int64_t t_us, gps_fix_t * fix )
+{
+    struct minmea_sentence_gsv frame;
+    gps_system_t            system;
+    gps_sat_t             * sat;
+    gps_sats_t            * buf;
+    uint32_t                mask;
+
+    if( !minmea_parse_gsv( &frame, sentence ) ) {
+        return false;
+    }
+
+    // Each System Sends Its Own Group, Only Its Slots Start Over
+    system = gps_nmea_system( sentence );
+    mask = 0;
+    for( size_t i = 0; i < GPS_SATS_CNT; i++ ) {
+        if( ( 0 != g_sats.sats[i].prn ) && ( system == g_sats.sats[i].system ) ) {
+            mask |= ( 1u << i );
+        }
+    }
+    if( 1 == frame.msg_nr ) {
+        g_sats_seen &= ~mask;
+    }
+
+    for( size_t i = 0; i < 4; i++ ) {
+        const struct minmea_sat_info  * info = &frame.sats[i];
+
+        if( ( info->nr <= 0 ) || ( info->nr > UINT8_MAX ) ) {
+            continue;
+        }
+
+        sat = gps_nmea_sat_slot( system, (uint8_t)info->nr );
+        if( NULL == sat ) {
+            continue;
+        }
+
+        sat->elevation  = (uint8_t)MIN( MAX( info->elevation, 0 ), 90 );
+        sat->azimuth    = (uint16_t)MIN( MAX( info->azimuth, 0 ), 359 );
+        sat->snr        = (uint8_t)MIN( MAX( info->snr, 0 ), 99 );
+        g_sats_seen    |= ( 1u << ( sat - g_sats.sats ) );
+    }
+
+    g_sats.t_us = t_us;
+    if( frame.msg_nr < frame.total_msgs ) {
+        return false;
+    }
+
+    // Group Complete, Whatever It Did Not Mention Is Out Of View
+    g_sats.in_view = 0;
+    for( size_t i = 0; i < GPS_SATS_CNT; i++ ) {
+        if( ( 0 != g_sats.sats[i].prn ) && ( system == g_sats.sats[i].system ) && !( g_sats_seen & ( 1u << i ) ) ) {
+            memset( &g_sats.sats[i], 0, sizeof( g_sats.sats[i] ) );
+            g_sats_seen &= ~( 1u << i );
+        }
+        if( 0 != g_sats.sats[i].prn ) {
+            g_sats.in_view++;
+        }
+    }
+
+    buf = malloc( sizeof( *buf ) );
+    if( NULL != buf ) {
+        *buf = g_sats;
+        PUB_BUF("gps.sats", buf, sizeof( *buf ), free);
+    }
+
+    return false;
+}
+
+static gps_system_t gps_nmea_system( const char * sentence )
+{
+    // "$GPGSV" / "$BDGSV", Second Talker Character Tells Them Apart
+    switch( sentence[2] ) {
+        case 'P':
+            return GPS_SYSTEM_GPS;
+
+        case 'L':
+            return GPS_SYSTEM_GLONASS;
+
+        case 'A':
+            return GPS_SYSTEM_GALILEO;
+
+        case 'B':
+        case 'D':
+            return GPS_SYSTEM_BEIDOU;
+
+        case 'Q':
+            return GPS_SYSTEM_QZSS;
+
+        default:
+            return GPS_SYSTEM_OTHER;
+    }
+}
+
+static gps_sat_t * gps_nmea_sat_slot( gps_system_t system, uint8_t prn )
+{
+    gps_sat_t             * empty = NULL;
+
+    for( size_t i = 0; i < GPS_SATS_CNT; i++ ) {
+        gps_sat_t         * sat = &g_sats.sats[i];
+
+        if( ( prn == sat->prn ) && ( system == sat->system ) ) {
+            return sat;
+        }
+        if( ( NULL == empty ) && ( 0 == sat->prn ) ) {
+            empty = sat;
+        }
+    }
+
+    // New In View, Takes The First Free Slot And Keeps It
+    if( NULL != empty ) {
+        empty->system   = (uint8_t)system;
+        empty->prn      = prn;
+    }
+
+    return empty;
+}
+
+static int32_t gps_nmea_coord( const struct minmea_float * coord )
+{
+    int64_t     deg;
+    int64_t     min;
+
+    if( 0 == coord->scale ) {
+        return 0;
+    }
+
+    // ddmm.mmmm To 1e-7 deg, Sign Rides Along On Both Parts
+    deg = coord->value / ( coord->scale * 100LL );
+    min = coord->value % ( coord->scale * 100LL );
+
+    return (int32_t)( deg * 10000000 + min * 10000000 / ( 60LL * coord->scale ) );
+}
@@ -0,0 +1,60 @@
+#ifndef DASH_GPS_NMEA_H
+#define DASH_GPS_NMEA_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdint.h>
+#include <stddef.h>
+
+#include "gps.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+
+// Sentence formatter ("RMC" of "$GPRMC") packed into one word
+#define NMEA_CODE( _a, _b, _c )     ( ( (uint32_t)(_a) << 16 ) | ( (uint32_t)(_b) << 8 ) | (uint32_t)(_c) )
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+typedef enum
+    {
+    GPS_NMEA_RMC,
+    GPS_NMEA_VTG,
+    GPS_NMEA_GGA,
+    GPS_NMEA_GSA,
+    GPS_NMEA_GSV,
+
+    GPS_NMEA_CNT
+    } gps_nmea_type_t;
+
+/**********************
+ *      MACROS
+ **********************/
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/*
+ * Sentence parsing and publishing, kept apart from the UART and the tasks so
+ * it only needs minmea and pubsub to link.
+ */
+int gps_nmea_type( const char * sentence, size_t len );
+int gps_nmea_type_from_code( uint32_t code );
+const char * gps_nmea_topic( gps_nmea_type_t type );
+// True When The Sentence Carried A Position Fix, Filled Into fix. t_us Is When It Was Read
+bool gps_nmea_parse( gps_nmea_type_t type, const char * sentence, int64_t t_us, gps_fix_t * fix );
+void gps_nmea_publish_fix( const gps_fix_status_t * status );
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif //DASH_GPS_NMEA_H
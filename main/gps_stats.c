@@ -0,0 +1,161 @@
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <pubsub.h>
+
+#include "esp_timer.h"
+
+#include "console_intf.h"
+#include "timebase.h"
+#include "gps_stats.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+#define GPS_STATS_PERIOD_MS     (10000)
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/**********************
+ *      MACROS
+ **********************/
+
+/**********************
+ *     GLOBALS
+ **********************/
+static esp_timer_handle_t   g_publish_timer;
+
+// Console Task Only, Too Big For Its Stack
+static gps_stats_t          g_cmd_stats;
+static gps_stats_t          g_cmd_last;
+
+static struct {
+    struct arg_lit *hist;
+    struct arg_end *end;
+    } g_gps_args;
+
+/**********************
+ *     COMMANDS
+ **********************/
+static int gps_cmd(int argc, char **argv);
+
+static esp_console_cmd_t  g_commands[] =
+    {
+    /*            command              help                                     hint        function                args */
+    {   "gps",          "GPS Link And Parser Statistics",   NULL,       gps_cmd,                &g_gps_args },
+    };
+
+#define COMMANDS_CNT        ( sizeof(g_commands)/sizeof(g_commands[0]) )
+
+/**********************
+ *     CONSTANTS
+ **********************/
+static const char * const   g_parse_names[GPS_STATS_PARSE_CNT] =
+    {
+    [GPS_NMEA_RMC]          = "RMC",
+    [GPS_NMEA_VTG]          = "VTG",
+    [GPS_NMEA_GGA]          = "GGA",
+    [GPS_NMEA_GSA]          = "GSA",
+    [GPS_NMEA_GSV]          = "GSV",
+    [GPS_STATS_PARSE_PVT]   = "NAV-PVT",
+    };
+
+/**********************
+ *    PROTOTYPES
+ **********************/
+static void gps_stats_publish( void * params );
+static void gps_stats_print_hist( const char * name, const char * unit, const gps_hist_t * hist, bool buckets );
+
+void gps_stats_start( void )
+{
+    g_gps_args.hist = arg_lit0("b", "buckets", "Show Histogram Buckets");
+    g_gps_args.end = arg_end(2);
+
+    console_register_commands( g_commands, COMMANDS_CNT );
+
+    const esp_timer_create_args_t publish_timer_args =
+            {
+            .callback = &gps_stats_publish,
+            .name = "gps_stats_publish_timer"
+            };
+    esp_timer_create(&publish_timer_args, &g_publish_timer);
+    esp_timer_start_periodic( g_publish_timer, GPS_STATS_PERIOD_MS * 1000 );
+}
+
+static void gps_stats_publish( void * params )
+{
+    gps_stats_t           * stats = malloc( sizeof( *stats ) );
+
+    if( NULL == stats ) {
+        return;
+    }
+
+    gps_get_stats( stats );
+    PUB_BUF("gps.stats", stats, sizeof( *stats ), free);
+}
+
+static int gps_cmd(int argc, char **argv)
+{
+    const gps_stats_t     * s = &g_cmd_stats;
+    const gps_stats_t     * last = &g_cmd_last;
+    int64_t                 dt_us;
+    uint32_t                rate;
+
+    int nerrors = arg_parse(argc, argv, (void **) &g_gps_args);
+    if (nerrors != 0) {
+        arg_print_errors(stderr, g_gps_args.end, argv[0]);
+        return 1;
+    }
+
+    gps_get_stats( &g_cmd_stats );
+
+    // Rate Since The Last Time Anyone Asked, Or Since Boot
+    dt_us = s->t_us - last->t_us;
+    rate  = ( dt_us > 0 ) ? (uint32_t)( (uint64_t)( s->uart_bytes - last->uart_bytes ) * 1000000 / dt_us ) : 0;
+
+    // 10 Bits On The Wire Per Byte, Near 100% And The Link Is What Holds Things Up
+    printf("uart:     %u baud, %u B total, %u B/s (%u%% of link), %u overruns, %u pattern overflows\n",
+           s->baud, s->uart_bytes, rate, s->baud ? (unsigned)( (uint64_t)rate * 1000 / s->baud ) : 0,
+           s->uart_ovf_cnt, s->pattern_ovf_cnt);
+    printf("nmea:     %u sentences, %u checksum errors, %u too long, %u resyncs, %u dropped\n",
+           s->sentence_cnt, s->cksum_err_cnt, s->overflow_cnt, s->resync_cnt, s->drop_cnt);
+    printf("ubx:      %u frames, %u checksum errors, %u too long\n",
+           s->ubx_frame_cnt, s->ubx_cksum_err_cnt, s->ubx_oversize_cnt);
+    printf("stack:    read task %u B free, parse task %u B free\n",
+           s->read_stack_free, s->parse_stack_free);
+
+    for( int i = 0; i < GPS_STATS_PARSE_CNT; i++ ) {
+        gps_stats_print_hist( g_parse_names[i], "cycles", &s->parse_cycles[i], g_gps_args.hist->count > 0 );
+    }
+    gps_stats_print_hist( "latency", "us", &s->latency_us, g_gps_args.hist->count > 0 );
+
+    g_cmd_last = g_cmd_stats;
+
+    return 0;
+}
+
+static void gps_stats_print_hist( const char * name, const char * unit, const gps_hist_t * hist, bool buckets )
+{
+    if( 0 == hist->cnt ) {
+        return;
+    }
+
+    printf("%-9s %u, avg %u max %u %s\n", name, hist->cnt, (unsigned)( hist->sum / hist->cnt ), hist->max, unit);
+
+    if( !buckets ) {
+        return;
+    }
+
+    for( int i = 0; i < GPS_HIST_BUCKET_CNT; i++ ) {
+        if( 0 != hist->bucket[i] ) {
+            printf("          %s%u: %u\n", ( i < GPS_HIST_BUCKET_CNT - 1 ) ? "<" : ">=",
+                   ( i < GPS_HIST_BUCKET_CNT - 1 ) ? 1u << ( hist->shift + i ) : 1u << ( hist->shift + i - 1 ),
+                   hist->bucket[i]);
+        }
+    }
+}
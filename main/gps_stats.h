@@ -0,0 +1,112 @@
+#ifndef DASH_GPS_STATS_H
+#define DASH_GPS_STATS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "gps_nmea.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+#define GPS_HIST_BUCKET_CNT     (16)
+
+// Parse Time Per gps_nmea_type_t, Then UBX NAV-PVT
+#define GPS_STATS_PARSE_PVT     (GPS_NMEA_CNT)
+#define GPS_STATS_PARSE_CNT     (GPS_NMEA_CNT + 1)
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/*
+ * Power of two histogram. bucket[0] holds values under 2^shift, bucket[n]
+ * values from 2^(shift + n - 1) up to 2^(shift + n), the last bucket also
+ * takes everything above.
+ */
+typedef struct
+    {
+    uint8_t                 shift;
+    uint32_t                cnt;
+    uint32_t                max;
+    uint64_t                sum;
+    uint32_t                bucket[GPS_HIST_BUCKET_CNT];
+    } gps_hist_t;
+
+/*
+ * Published on "gps.stats" every GPS_STATS_PERIOD_MS. Counters run from
+ * boot, take the difference of two samples for a rate.
+ */
+typedef struct
+    {
+    int64_t                 t_us;               // timebase_now_us() Of The Snapshot
+    uint32_t                baud;
+
+    // UART, Read Task
+    uint32_t                uart_bytes;
+    uint32_t                uart_ovf_cnt;       // FIFO Or Driver Buffer Overran, Bytes Lost
+    uint32_t                pattern_ovf_cnt;    // Line Feed Positions Lost, Buffer Flushed
+
+    // Framing, Read Task
+    uint32_t                sentence_cnt;
+    uint32_t                cksum_err_cnt;
+    uint32_t                overflow_cnt;       // Longer Than A Sentence Slot
+    uint32_t                resync_cnt;
+    uint32_t                ubx_frame_cnt;
+    uint32_t                ubx_cksum_err_cnt;
+    uint32_t                ubx_oversize_cnt;
+    uint32_t                drop_cnt;           // Framed, But The Parse Task Held Every Slot
+
+    // Parse Task (UBX: Read Task)
+    gps_hist_t              parse_cycles[GPS_STATS_PARSE_CNT];
+    gps_hist_t              latency_us;         // Read Off The UART To Published
+
+    // Least Stack Ever Left, Bytes
+    uint32_t                read_stack_free;
+    uint32_t                parse_stack_free;
+    } gps_stats_t;
+
+/**********************
+ *      MACROS
+ **********************/
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+static inline void gps_hist_init( gps_hist_t * hist, uint8_t shift )
+{
+    *hist = (gps_hist_t){ .shift = shift };
+}
+
+static inline void gps_hist_add( gps_hist_t * hist, uint32_t val )
+{
+    uint32_t    scaled = val >> hist->shift;
+    uint32_t    idx = scaled ? 32 - __builtin_clz( scaled ) : 0;
+
+    hist->bucket[( idx < GPS_HIST_BUCKET_CNT ) ? idx : GPS_HIST_BUCKET_CNT - 1]++;
+    hist->cnt++;
+    hist->sum += val;
+    if( val > hist->max ) {
+        hist->max = val;
+    }
+}
+
+// "gps" Console Command And The Periodic "gps.stats", Called From gps_start()
+void gps_stats_start( void );
+
+// Copy Of The Live Counters, Owned And Filled In By gps.c
+void gps_get_stats( gps_stats_t * stats );
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif //DASH_GPS_STATS_H
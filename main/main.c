@@ -13,12 +13,17 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "esp_system.h"
+#include "nvs_flash.h"
 
 #include "console_intf.h"
 #include "display.h"
 #include "gps.h"
+#include "rtc.h"
 #include "stepper_gauge.h"
 #include "speedometer_gauge.h"
+#include "speed_fusion.h"
+#include "odometer.h"
+#include "geo.h"
 #include "can_j1939.h"
 
 
@@ -27,6 +32,14 @@ void app_main()
     // Initialize PubSub
     ps_init();
 
+    // Initialize NVS, Starting Over If The Layout Is Stale
+    esp_err_t err = nvs_flash_init();
+    if( ( ESP_ERR_NVS_NO_FREE_PAGES == err ) || ( ESP_ERR_NVS_NEW_VERSION_FOUND == err ) ) {
+        ESP_ERROR_CHECK( nvs_flash_erase() );
+        err = nvs_flash_init();
+    }
+    ESP_ERROR_CHECK( err );
+
     // Setup Time Zone
     setenv("TZ", "CST6CDT,M3.2.0,M11.1.0", 1);
     tzset();
@@ -38,7 +51,14 @@ void app_main()
     // Start Modules
     console_intf_start();
     display_start();
+    rtc_start();
     gps_start();
+#if CONFIG_DASH_TRACK_LOG
+    gps_set_track_log( true );
+#endif
+    speed_fusion_start();
+    odometer_start();
+    geo_start();
     speedometer_gauge_start();
     stepper_gauge_start();
 
@@ -0,0 +1,255 @@
+/*********************
+ *      INCLUDES
+ *********************/
+#include <string.h>
+
+#include "nmea_framer.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+#define WORD_SZ             ( sizeof(uint32_t) )
+#define WORD_ONES           ( 0x01010101u )
+#define WORD_HIGHS          ( 0x80808080u )
+
+// Room kept behind the body for "*HH" and the null terminator
+#define SENTENCE_TAIL_SZ    ( 4 )
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/**********************
+ *      MACROS
+ **********************/
+// Non-zero if any byte of the word is zero / equal to _b
+#define word_has_zero( _w )         ( ( ( _w ) - WORD_ONES ) & ~( _w ) & WORD_HIGHS )
+#define word_has_byte( _w, _b )     word_has_zero( ( _w ) ^ ( WORD_ONES * (uint8_t)( _b ) ) )
+
+/**********************
+ *     GLOBALS
+ **********************/
+
+/**********************
+ *     CONSTANTS
+ **********************/
+
+/**********************
+ *    PROTOTYPES
+ **********************/
+static const uint8_t * nmea_framer_hunt( nmea_framer_t * framer, const uint8_t * data, const uint8_t * end );
+static const uint8_t * nmea_framer_body( nmea_framer_t * framer, const uint8_t * data, const uint8_t * end );
+static void nmea_framer_start( nmea_framer_t * framer );
+static void nmea_framer_finish( nmea_framer_t * framer, uint8_t cksum_lo );
+static int hex_to_nibble( uint8_t ch );
+
+static inline uint32_t load_word( const uint8_t * data )
+{
+    uint32_t    word;
+
+    // Input chunks have no alignment guarantee
+    memcpy( &word, data, WORD_SZ );
+    return word;
+}
+
+void nmea_framer_init
+    (
+    nmea_framer_t         * framer,
+    char                  * buf,
+    size_t                  buf_sz,
+    nmea_framer_emit_t      emit,
+    void                  * ctx
+    )
+{
+    memset( framer, 0, sizeof( *framer ) );
+
+    framer->buf     = buf;
+    framer->buf_sz  = buf_sz;
+    framer->emit    = emit;
+    framer->ctx     = ctx;
+
+    nmea_framer_reset( framer );
+}
+
+void nmea_framer_reset( nmea_framer_t * framer )
+{
+    framer->state   = NMEA_FRAMER_HUNT;
+    framer->len     = 0;
+    framer->cksum   = 0;
+}
+
+void nmea_framer_feed
+    (
+    nmea_framer_t         * framer,
+    const uint8_t         * data,
+    size_t                  len
+    )
+{
+    const uint8_t         * end = data + len;
+    int                     nibble;
+
+    framer->byte_cnt += len;
+
+    while( data < end ) {
+        switch( framer->state ) {
+            case NMEA_FRAMER_HUNT:
+                data = nmea_framer_hunt( framer, data, end );
+            break;
+
+            case NMEA_FRAMER_BODY:
+                data = nmea_framer_body( framer, data, end );
+            break;
+
+            case NMEA_FRAMER_CKSUM_HI:
+                nibble = hex_to_nibble( *data );
+                if( nibble < 0 ) {
+                    // Leave The Byte, It May Be The '$' Of The Next Sentence
+                    framer->cksum_err_cnt++;
+                    framer->state = NMEA_FRAMER_HUNT;
+                    break;
+                }
+
+                framer->buf[framer->len++] = (char)*data++;
+                framer->cksum_rx = (uint8_t)( nibble << 4 );
+                framer->state = NMEA_FRAMER_CKSUM_LO;
+            break;
+
+            case NMEA_FRAMER_CKSUM_LO:
+                nibble = hex_to_nibble( *data );
+                if( nibble < 0 ) {
+                    framer->cksum_err_cnt++;
+                    framer->state = NMEA_FRAMER_HUNT;
+                    break;
+                }
+
+                framer->buf[framer->len++] = (char)*data++;
+                nmea_framer_finish( framer, (uint8_t)nibble );
+            break;
+        }
+    }
+}
+
+static const uint8_t * nmea_framer_hunt( nmea_framer_t * framer, const uint8_t * data, const uint8_t * end )
+{
+    // Skip Whole Words Without A '$'
+    while( ( (size_t)( end - data ) >= WORD_SZ ) && !word_has_byte( load_word( data ), '$' ) ) {
+        data += WORD_SZ;
+    }
+
+    // Find The '$' Within The Last Word
+    while( ( data < end ) && ( '$' != *data ) ) {
+        data++;
+    }
+
+    if( data < end ) {
+        nmea_framer_start( framer );
+        data++;
+    }
+
+    return data;
+}
+
+static const uint8_t * nmea_framer_body( nmea_framer_t * framer, const uint8_t * data, const uint8_t * end )
+{
+    const size_t            limit = framer->buf_sz - SENTENCE_TAIL_SZ;
+    size_t                  len = framer->len;
+    uint32_t                cksum = framer->cksum;
+
+    // Copy Word At A Time Until A Word Holds A Delimiter
+    while( ( (size_t)( end - data ) >= WORD_SZ ) && ( ( len + WORD_SZ ) <= limit ) ) {
+        uint32_t    word = load_word( data );
+
+        if( word_has_byte( word, '*' ) | word_has_byte( word, '$' ) |
+            word_has_byte( word, '\r' ) | word_has_byte( word, '\n' ) ) {
+            break;
+        }
+
+        memcpy( &framer->buf[len], &word, WORD_SZ );
+        cksum ^= word;
+        len += WORD_SZ;
+        data += WORD_SZ;
+    }
+
+    // Byte At A Time Up To And Including The Delimiter
+    while( data < end ) {
+        uint8_t     ch = *data;
+
+        if( '*' == ch ) {
+            framer->buf[len++] = '*';
+            framer->state = NMEA_FRAMER_CKSUM_HI;
+            data++;
+            break;
+        }
+        else if( '$' == ch ) {
+            // Sentence Cut Short, Start Over On The New One
+            framer->resync_cnt++;
+            nmea_framer_start( framer );
+            data++;
+            return data;
+        }
+        else if( ( '\r' == ch ) || ( '\n' == ch ) ) {
+            // No Checksum, Never Reaches The Parser
+            framer->cksum_err_cnt++;
+            framer->state = NMEA_FRAMER_HUNT;
+            data++;
+            break;
+        }
+        else if( len >= limit ) {
+            framer->overflow_cnt++;
+            framer->state = NMEA_FRAMER_HUNT;
+            break;
+        }
+
+        framer->buf[len++] = (char)ch;
+        cksum ^= ch;
+        data++;
+    }
+
+    framer->len = len;
+    framer->cksum = cksum;
+
+    return data;
+}
+
+static void nmea_framer_start( nmea_framer_t * framer )
+{
+    framer->buf[0]  = '$';
+    framer->len     = 1;
+    framer->cksum   = 0;
+    framer->state   = NMEA_FRAMER_BODY;
+}
+
+static void nmea_framer_finish( nmea_framer_t * framer, uint8_t cksum_lo )
+{
+    uint32_t    cksum;
+
+    // Fold Word Lanes Down To The Byte Checksum
+    cksum = framer->cksum ^ ( framer->cksum >> 16 );
+    cksum ^= cksum >> 8;
+
+    framer->state = NMEA_FRAMER_HUNT;
+    framer->buf[framer->len] = '\0';
+
+    if( (uint8_t)cksum != ( framer->cksum_rx | cksum_lo ) ) {
+        framer->cksum_err_cnt++;
+        return;
+    }
+
+    framer->sentence_cnt++;
+    framer->buf = framer->emit( framer->ctx, framer->buf, framer->len );
+}
+
+static int hex_to_nibble( uint8_t ch )
+{
+    if( ( ch >= '0' ) && ( ch <= '9' ) ) {
+        return ch - '0';
+    }
+    else if( ( ch >= 'A' ) && ( ch <= 'F' ) ) {
+        return ch - 'A' + 10;
+    }
+    else if( ( ch >= 'a' ) && ( ch <= 'f' ) ) {
+        return ch - 'a' + 10;
+    }
+
+    return -1;
+}
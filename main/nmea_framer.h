@@ -0,0 +1,88 @@
+#ifndef DASH_NMEA_FRAMER_H
+#define DASH_NMEA_FRAMER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdint.h>
+#include <stddef.h>
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/*
+ * Called with every checksum-valid sentence. The sentence is null terminated,
+ * runs from '$' up to and including the two checksum digits, and sits in the
+ * buffer the framer was writing into. Return the buffer to frame the next
+ * sentence into (the same one is fine if it has been consumed).
+ */
+typedef char * (*nmea_framer_emit_t)( void * ctx, char * sentence, size_t len );
+
+typedef enum
+    {
+    NMEA_FRAMER_HUNT,               // Waiting for '$'
+    NMEA_FRAMER_BODY,               // Copying body, waiting for '*'
+    NMEA_FRAMER_CKSUM_HI,           // First checksum digit
+    NMEA_FRAMER_CKSUM_LO            // Second checksum digit
+    } nmea_framer_state_t;
+
+typedef struct
+    {
+    // Output
+    char                  * buf;
+    size_t                  buf_sz;
+    size_t                  len;
+    nmea_framer_emit_t      emit;
+    void                  * ctx;
+
+    // State
+    nmea_framer_state_t     state;
+    uint32_t                cksum;      // XOR of body, folded on '*'
+    uint8_t                 cksum_rx;
+
+    // Statistics
+    uint32_t                byte_cnt;
+    uint32_t                sentence_cnt;
+    uint32_t                cksum_err_cnt;
+    uint32_t                overflow_cnt;
+    uint32_t                resync_cnt;
+    } nmea_framer_t;
+
+/**********************
+ *      MACROS
+ **********************/
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+void nmea_framer_init
+    (
+    nmea_framer_t         * framer,
+    char                  * buf,
+    size_t                  buf_sz,
+    nmea_framer_emit_t      emit,
+    void                  * ctx
+    );
+void nmea_framer_reset( nmea_framer_t * framer );
+void nmea_framer_feed
+    (
+    nmea_framer_t         * framer,
+    const uint8_t         * data,
+    size_t                  len
+    );
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif //DASH_NMEA_FRAMER_H
@@ -0,0 +1,342 @@
+/*********************
+ *      INCLUDES
+ *********************/
+#include <string.h>
+#include <stddef.h>
+#include <sys/param.h>
+
+#include <pubsub.h>
+
+#include "esp_system.h"
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "esp32/rom/crc.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+#include "timebase.h"
+#include "odometer.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+#define TAG                     "ODOMETER"
+
+#define PARTITION_LABEL         "odometer"
+#define PARTITION_SUBTYPE       ( (esp_partition_subtype_t)0x40 )
+
+#define USEC_PER_SEC            (1000000LL)
+
+#define SEQ_EMPTY               (0xFFFFFFFFu)   // Erased Flash
+#define RECORDS_PER_SECTOR      ( SPI_FLASH_SEC_SIZE / sizeof( odometer_record_t ) )
+
+// vehicle.speed Is km/h * 100, Times us Over This Is mm
+#define SPEED_US_PER_MM         (360000)
+#define SPEED_GAP_MAX_US        (USEC_PER_SEC)  // Longer Gaps Are Not Integrated
+
+// A Few Writes An Hour While Driving, Plus One Whenever The Vehicle Stops
+#define SAVE_PERIOD_US          ( 10 * 60 * USEC_PER_SEC )
+#define SAVE_STOPPED_US         ( 5 * USEC_PER_SEC )
+#define SAVE_MIN_M              (10)
+
+#define PUBLISH_STEP_M          (100)
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+// One Log Entry, Never Rewritten, Sector Erased Only When The Log Wraps Into It
+typedef struct
+    {
+    uint32_t                seq;            // Increments Every Record
+    uint32_t                distance_m;
+    uint32_t                reserved;
+    uint32_t                crc;            // Over The Fields Above
+    } odometer_record_t;
+
+typedef struct
+    {
+    const esp_partition_t * part;
+    SemaphoreHandle_t       lock;           // Task Against odometer_stop(), Held Over Flash
+    uint32_t                slot_cnt;
+    uint32_t                next_slot;
+    uint32_t                next_seq;
+
+    // Distance
+    uint32_t                distance_m;
+    uint32_t                saved_m;
+    uint32_t                published_m;
+    uint64_t                partial;        // Speed * us, Below SPEED_US_PER_MM * 1000
+
+    // Timing
+    int64_t                 speed_us;
+    int32_t                 speed;
+    int64_t                 saved_us;
+    int64_t                 moving_us;
+
+    // Statistics
+    uint32_t                write_cnt;
+    uint32_t                erase_cnt;
+    } odometer_priv_t;
+
+/**********************
+ *      MACROS
+ **********************/
+#define record_crc( _rec )      crc32_le( 0, (const uint8_t *)( _rec ), offsetof( odometer_record_t, crc ) )
+
+/**********************
+ *     GLOBALS
+ **********************/
+static odometer_priv_t      g_priv;
+
+/**********************
+ *     CONSTANTS
+ **********************/
+
+/**********************
+ *    PROTOTYPES
+ **********************/
+_Noreturn static void odometer_task( void * params );
+static void odometer_integrate( odometer_priv_t * priv, int32_t speed, int64_t t_us );
+static void odometer_recover( odometer_priv_t * priv );
+static void odometer_save( odometer_priv_t * priv, int64_t now_us );
+static uint32_t odometer_slot_seq( odometer_priv_t * priv, uint32_t slot );
+static bool odometer_slot_read( odometer_priv_t * priv, uint32_t slot, odometer_record_t * rec );
+
+void odometer_start( void )
+{
+    ESP_LOGI(TAG, "Start");
+
+    memset( &g_priv, 0, sizeof( g_priv ) );
+
+    g_priv.lock = xSemaphoreCreateMutex();
+    g_priv.part = esp_partition_find_first( ESP_PARTITION_TYPE_DATA, PARTITION_SUBTYPE, PARTITION_LABEL );
+    if( NULL == g_priv.part ) {
+        ESP_LOGE(TAG, "No '%s' Partition", PARTITION_LABEL);
+    }
+    else {
+        g_priv.slot_cnt = ( g_priv.part->size / SPI_FLASH_SEC_SIZE ) * RECORDS_PER_SECTOR;
+        odometer_recover( &g_priv );
+    }
+
+    g_priv.saved_m      = g_priv.distance_m;
+    g_priv.published_m  = g_priv.distance_m;
+    PUB_INT_FL("odometer.distance", g_priv.distance_m, FL_STICKY);
+
+    xTaskCreate( odometer_task, "odometer_task", 3 * 1024, &g_priv, 5, NULL );
+
+    // esp_restart() Writes Out Whatever Was Driven Since The Last Save
+    esp_register_shutdown_handler( odometer_stop );
+}
+
+void odometer_stop( void )
+{
+    if( NULL == g_priv.lock ) {
+        return;
+    }
+
+    xSemaphoreTake( g_priv.lock, portMAX_DELAY );
+    odometer_save( &g_priv, timebase_now_us() );
+    xSemaphoreGive( g_priv.lock );
+}
+
+_Noreturn static void odometer_task( void * params )
+{
+    odometer_priv_t       * priv = (odometer_priv_t *)params;
+    ps_subscriber_t       * s = ps_new_subscriber(10, STRLIST( "vehicle.speed" ));
+    ps_msg_t              * msg = NULL;
+    timebase_sample_t       sample;
+    int64_t                 now_us;
+
+    priv->saved_us = timebase_now_us();
+
+    while(true) {
+        // Wake Up Now And Then Even Without Speed, So A Stop Still Gets Saved
+        msg = ps_get( s, 1000 );
+        now_us = timebase_now_us();
+
+        xSemaphoreTake( priv->lock, portMAX_DELAY );
+
+        if( msg != NULL ) {
+            // Integrate Over When The Speeds Were Estimated, Not When They Got Here
+            if( timebase_sample( msg, &sample ) ) {
+                odometer_integrate( priv, (int32_t)sample.value, sample.t_us );
+            }
+            ps_unref_msg(msg);
+        }
+
+        if( ( priv->distance_m - priv->published_m ) >= PUBLISH_STEP_M ) {
+            priv->published_m = priv->distance_m - ( priv->distance_m % PUBLISH_STEP_M );
+            PUB_INT_FL("odometer.distance", priv->distance_m, FL_STICKY);
+        }
+
+        if( ( priv->distance_m - priv->saved_m ) >= SAVE_MIN_M ) {
+            if( ( ( now_us - priv->saved_us ) >= SAVE_PERIOD_US ) ||
+                ( ( now_us - priv->moving_us ) >= SAVE_STOPPED_US ) ) {
+                odometer_save( priv, now_us );
+            }
+        }
+
+        xSemaphoreGive( priv->lock );
+    }
+}
+
+static void odometer_integrate( odometer_priv_t * priv, int32_t speed, int64_t t_us )
+{
+    int64_t     dt_us = t_us - priv->speed_us;
+
+    // Trapezoid Between Samples, Remainder Carried So Nothing Is Lost To Rounding
+    if( ( 0 != priv->speed_us ) && ( dt_us > 0 ) && ( dt_us <= SPEED_GAP_MAX_US ) ) {
+        priv->partial += (uint64_t)( ( (int64_t)priv->speed + speed ) * dt_us / 2 );
+
+        if( priv->partial >= (uint64_t)SPEED_US_PER_MM * 1000 ) {
+            priv->distance_m += (uint32_t)( priv->partial / ( (uint64_t)SPEED_US_PER_MM * 1000 ) );
+            priv->partial %= (uint64_t)SPEED_US_PER_MM * 1000;
+        }
+    }
+
+    if( speed > 0 ) {
+        priv->moving_us = t_us;
+    }
+
+    priv->speed     = MAX( speed, 0 );
+    priv->speed_us  = t_us;
+}
+
+static void odometer_recover( odometer_priv_t * priv )
+{
+    uint32_t            sector_cnt = priv->slot_cnt / RECORDS_PER_SECTOR;
+    uint32_t            first_seq = odometer_slot_seq( priv, 0 );
+    uint32_t            sector;
+    uint32_t            lo;
+    uint32_t            hi;
+    uint32_t            last;
+    uint32_t            last_seq;
+    odometer_record_t   rec;
+
+    /*
+     * Sector heads run up from the oldest surviving sector and drop back
+     * where the log wrapped, so the newest sector is the last one whose head
+     * is not below sector 0's. Sector 0 only reads blank on a fresh log or
+     * when power went between erasing it and writing it on a wrap.
+     */
+    if( SEQ_EMPTY == first_seq ) {
+        if( SEQ_EMPTY == odometer_slot_seq( priv, ( sector_cnt - 1 ) * RECORDS_PER_SECTOR ) ) {
+            ESP_LOGI(TAG, "Empty Log");
+            priv->next_slot = 0;
+            priv->next_seq  = 1;
+            return;
+        }
+
+        sector = sector_cnt - 1;
+    }
+    else {
+        lo = 0;
+        hi = sector_cnt - 1;
+        while( lo < hi ) {
+            uint32_t    mid = ( lo + hi + 1 ) / 2;
+            uint32_t    seq = odometer_slot_seq( priv, mid * RECORDS_PER_SECTOR );
+
+            if( ( SEQ_EMPTY != seq ) && ( seq >= first_seq ) ) {
+                lo = mid;
+            }
+            else {
+                hi = mid - 1;
+            }
+        }
+        sector = lo;
+    }
+
+    // Records In A Sector Are A Written Prefix Followed By Blanks
+    lo = sector * RECORDS_PER_SECTOR;
+    hi = lo + RECORDS_PER_SECTOR - 1;
+    while( lo < hi ) {
+        uint32_t    mid = ( lo + hi + 1 ) / 2;
+
+        if( SEQ_EMPTY != odometer_slot_seq( priv, mid ) ) {
+            lo = mid;
+        }
+        else {
+            hi = mid - 1;
+        }
+    }
+
+    last            = lo;
+    last_seq        = odometer_slot_seq( priv, last );
+    priv->next_slot = ( last + 1 ) % priv->slot_cnt;
+    priv->next_seq  = last_seq + 1;
+
+    // A Torn Write Leaves A Bad Tail, Walk Back To The Newest Good Record
+    for( uint32_t i = 0; i < RECORDS_PER_SECTOR; i++ ) {
+        if( odometer_slot_read( priv, ( last + priv->slot_cnt - i ) % priv->slot_cnt, &rec ) ) {
+            priv->distance_m = rec.distance_m;
+
+            ESP_LOGI(TAG, "Recovered %u m (Seq %u, Slot %u)", rec.distance_m, rec.seq, last);
+            return;
+        }
+    }
+
+    ESP_LOGW(TAG, "No Good Record Near Slot %u", last);
+}
+
+static void odometer_save( odometer_priv_t * priv, int64_t now_us )
+{
+    odometer_record_t   rec;
+    size_t              offset;
+
+    priv->saved_us = now_us;
+
+    if( ( NULL == priv->part ) || ( priv->distance_m == priv->saved_m ) ) {
+        return;
+    }
+
+    offset = priv->next_slot * sizeof( rec );
+
+    // Entering A Sector, Its Oldest Records Go
+    if( 0 == ( priv->next_slot % RECORDS_PER_SECTOR ) ) {
+        if( ESP_OK != esp_partition_erase_range( priv->part, offset, SPI_FLASH_SEC_SIZE ) ) {
+            ESP_LOGE(TAG, "Erase Failed At 0x%x", (unsigned)offset);
+            return;
+        }
+        priv->erase_cnt++;
+    }
+
+    rec.seq         = priv->next_seq;
+    rec.distance_m  = priv->distance_m;
+    rec.reserved    = SEQ_EMPTY;
+    rec.crc         = record_crc( &rec );
+
+    // Slot Is Used Even If The Write Fails, It Can Not Be Rewritten Without An Erase
+    if( ESP_OK != esp_partition_write( priv->part, offset, &rec, sizeof( rec ) ) ) {
+        ESP_LOGE(TAG, "Write Failed At 0x%x", (unsigned)offset);
+    }
+    else {
+        priv->saved_m = priv->distance_m;
+        priv->write_cnt++;
+    }
+
+    priv->next_slot = ( priv->next_slot + 1 ) % priv->slot_cnt;
+    priv->next_seq++;
+}
+
+static uint32_t odometer_slot_seq( odometer_priv_t * priv, uint32_t slot )
+{
+    uint32_t    seq;
+
+    if( ESP_OK != esp_partition_read( priv->part, slot * sizeof( odometer_record_t ), &seq, sizeof( seq ) ) ) {
+        return SEQ_EMPTY;
+    }
+
+    return seq;
+}
+
+static bool odometer_slot_read( odometer_priv_t * priv, uint32_t slot, odometer_record_t * rec )
+{
+    if( ESP_OK != esp_partition_read( priv->part, slot * sizeof( *rec ), rec, sizeof( *rec ) ) ) {
+        return false;
+    }
+
+    return ( SEQ_EMPTY != rec->seq ) && ( record_crc( rec ) == rec->crc );
+}
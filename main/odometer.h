@@ -0,0 +1,33 @@
+#ifndef DASH_ODOMETER_H
+#define DASH_ODOMETER_H
+
+/*********************
+ *      INCLUDES
+ *********************/
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/**********************
+ *      MACROS
+ **********************/
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/*
+ * Integrates "vehicle.speed" into "odometer.distance" (sticky, metres) and
+ * keeps the total in the "odometer" data partition.
+ */
+void odometer_start( void );
+
+// Saves Now, Also Registered As A Shutdown Handler By odometer_start()
+void odometer_stop( void );
+
+#endif //DASH_ODOMETER_H
@@ -4,17 +4,27 @@
 #include <string.h>
 #include <time.h>
 #include <math.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <sys/time.h>
+#include <sys/param.h>
 
 #include <pubsub.h>
 
 #include "esp_system.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/timers.h"
 #include "freertos/semphr.h"
 
+#include "driver/gpio.h"
+
+#include "timebase.h"
+#include "gps.h"
+#include "rtc_ext.h"
 #include "rtc.h"
 
 /*********************
@@ -22,17 +32,67 @@
  *********************/
 #define TAG                 "RTC"
 
+#define PIN_PPS             GPIO_NUM_34
+
+#define USEC_PER_SEC        (1000000LL)
+
+#define PPS_FRESH_US        (900000)    // gps.time Labels A Pulse Only This Soon After It
+#define PPS_GAP_MAX         (4)         // Seconds Between Pulses Still Used For Frequency
+#define PPS_JITTER_MAX_US   (1000)      // Per Second, Intervals Further Off Are Glitches
+
+#define LOCK_THRESHOLD_US   (100)       // Phase Error Under This Counts As Locked
+#define SLEW_MAX_US         (10000)     // Phase Errors Past This Are Stepped Out, Not Slewed
+#define PPS_LOST_US         (2 * USEC_PER_SEC)
+#define STEP_CONFIRM_CNT    (5)         // gps.time Disagreeing This Many Times In A Row Steps The Clock
+
+#define EXT_WRITE_PERIOD_US ( 10 * 60 * USEC_PER_SEC )  // Chip Drifts A Few ppm, This Keeps It Well Under A Second
+#define EXT_RETRY_US        ( 10 * USEC_PER_SEC )
+
+#define PLL_GAIN_DIV        (4)         // Phase Error Taken Out Per Second
+#define FLL_SHIFT           (3)         // Frequency Estimate Moves 1/8 Of The Way Per Pulse
+#define FREQ_FRAC_BITS      (8)         // Frequency Kept In 1/256 us Per Second
+
 /**********************
  *      TYPEDEFS
  **********************/
+typedef struct
+    {
+    // Written By The PPS Interrupt
+    portMUX_TYPE            pps_lock;
+    int64_t                 pps_edge_us;    // esp_timer Time Of The Latest Rising Edge
+    uint32_t                pps_cnt;
+
+    esp_timer_handle_t      tick_timer;
+
+    // Discipline Loop, Owned By The RTC Task
+    rtc_sync_t              sync;
+    bool                    fix_valid;
+    int64_t                 last_edge_us;
+    int64_t                 last_label;     // UTC Second Of last_edge_us, 0 If None
+    int32_t                 freq;           // esp_timer Gain vs GPS, us/s << FREQ_FRAC_BITS
+    int32_t                 phase_us;       // Latest Clock Error At The Pulse, + Is Ahead
+    uint32_t                mismatch_cnt;
+
+    // External Clock Chip, Written From Its Own Task So A Busy Bus Never Holds Up The Above
+    bool                    ext_ok;
+    TaskHandle_t            ext_task;
+    atomic_bool             ext_stepped;    // Clock Was Stepped, Write Without Waiting For The Period
+    int64_t                 ext_write_us;   // esp_timer Time The Next Write Is Due, External Task Only
+
+    // Statistics
+    uint32_t                step_cnt;
+    uint32_t                glitch_cnt;
+    } rtc_priv_t;
 
 /**********************
  *      MACROS
  **********************/
+#define timeval_to_us( _tv )    ( (int64_t)( _tv ).tv_sec * USEC_PER_SEC + ( _tv ).tv_usec )
 
 /**********************
  *     GLOBALS
  **********************/
+static rtc_priv_t           g_priv;
 
 /**********************
  *     CONSTANTS
@@ -41,13 +101,290 @@
 /**********************
  *    PROTOTYPES
  **********************/
+_Noreturn static void rtc_task( void * params );
+_Noreturn static void rtc_ext_task( void * params );
+static void IRAM_ATTR rtc_pps_isr( void * params );
+static void rtc_tick_timer( void * params );
+static void rtc_tick_arm( rtc_priv_t * priv, int64_t delay_us );
+static void rtc_gps_time( rtc_priv_t * priv, int64_t gps_time, int64_t rx_us );
+static void rtc_discipline( rtc_priv_t * priv, int64_t edge_us, int64_t sys_edge_us );
+static void rtc_step( rtc_priv_t * priv, int64_t utc_us );
+static void rtc_set_sync( rtc_priv_t * priv, rtc_sync_t sync );
+static void rtc_ext_update( rtc_priv_t * priv );
 
 void rtc_start( void )
 {
+    gpio_config_t config;
+    time_t        ext_utc;
+
+    ESP_LOGI(TAG, "Start");
+
+    memset( &g_priv, 0, sizeof( g_priv ) );
+    g_priv.pps_lock = (portMUX_TYPE)portMUX_INITIALIZER_UNLOCKED;
+    g_priv.sync     = RTC_SYNC_NONE;
+    atomic_init( &g_priv.ext_stepped, false );
+
+    // PPS Input, Rising Edge Is The Top Of The Second
+    config.intr_type    = GPIO_INTR_POSEDGE;
+    config.mode         = GPIO_MODE_INPUT;
+    config.pin_bit_mask = ( 1ULL << PIN_PPS );
+    config.pull_down_en = 1;
+    config.pull_up_en   = 0;
+
+    gpio_config(&config);
+
+    // Already Installed Is Fine
+    gpio_install_isr_service( 0 );
+    gpio_isr_handler_add( PIN_PPS, rtc_pps_isr, &g_priv );
+
+    // Second Tick, Re-Armed Against The Wall Clock Each Time
+    const esp_timer_create_args_t tick_timer_args =
+            {
+            .callback = &rtc_tick_timer,
+            .arg = &g_priv,
+            .name = "rtc_tick_timer"
+            };
+    esp_timer_create(&tick_timer_args, &g_priv.tick_timer);
+
+    PUB_INT_FL("rtc.sync", g_priv.sync, FL_STICKY);
+
+    // Battery Backed Clock Gives A Time Right Away, GPS Takes Over Once It Has One
+    g_priv.ext_ok = ( RTC_EXT_NONE != rtc_ext_init() );
+    if( g_priv.ext_ok && rtc_ext_read( &ext_utc ) ) {
+        // Somewhere Within That Second, Split The Difference
+        rtc_step( &g_priv, (int64_t)ext_utc * USEC_PER_SEC + USEC_PER_SEC / 2 );
+        rtc_set_sync( &g_priv, RTC_SYNC_EXT );
+    }
+
+    xTaskCreate( rtc_task, "rtc_task", 3 * 1024, &g_priv, 10, NULL );
 
+    // Well Below The Discipline Loop, Waiting On The Display Bus Costs Nobody Else
+    if( g_priv.ext_ok ) {
+        xTaskCreate( rtc_ext_task, "rtc_ext_task", 3 * 1024, &g_priv, 3, &g_priv.ext_task );
+    }
 }
 
 void rtc_stop( void )
 {
+    gpio_isr_handler_remove( PIN_PPS );
+    esp_timer_stop( g_priv.tick_timer );
+    esp_timer_delete( g_priv.tick_timer );
+}
+
+_Noreturn static void rtc_task( void * params )
+{
+    rtc_priv_t            * priv = (rtc_priv_t *)params;
+    ps_subscriber_t       * s = ps_new_subscriber(10, STRLIST( "gps.time", "gps.fix" ));
+    ps_msg_t              * msg = NULL;
+    timebase_sample_t       sample;
+
+    while(true) {
+        msg = ps_get( s, -1 );
+        if( msg != NULL ) {
+            if( 0 == strcmp( "gps.fix", msg->topic ) ) {
+                priv->fix_valid = ( sizeof( gps_fix_status_t ) == msg->buf_val.sz ) &&
+                                  gps_fix_status_valid( (const gps_fix_status_t *)msg->buf_val.ptr );
+            }
+            else if( ( 0 == strcmp( "gps.time", msg->topic ) ) && timebase_sample( msg, &sample ) ) {
+                // Receiver Time Before A Fix Can Be Its Own Stale RTC
+                if( priv->fix_valid ) {
+                    rtc_gps_time( priv, sample.value, sample.t_us );
+
+                    // External Task Decides Whether A Write Is Due
+                    if( NULL != priv->ext_task ) {
+                        xTaskNotifyGive( priv->ext_task );
+                    }
+                }
+            }
+
+            ps_unref_msg(msg);
+        }
+    }
+}
+
+_Noreturn static void rtc_ext_task( void * params )
+{
+    rtc_priv_t            * priv = (rtc_priv_t *)params;
+
+    while(true) {
+        ulTaskNotifyTake( pdTRUE, portMAX_DELAY );
+        rtc_ext_update( priv );
+    }
+}
+
+static void IRAM_ATTR rtc_pps_isr( void * params )
+{
+    rtc_priv_t            * priv = (rtc_priv_t *)params;
+    int64_t                 now = timebase_now_us();
+
+    // 64 Bit Store Is Two Words On This Core
+    portENTER_CRITICAL_ISR( &priv->pps_lock );
+    priv->pps_edge_us = now;
+    priv->pps_cnt++;
+    portEXIT_CRITICAL_ISR( &priv->pps_lock );
+}
+
+static void rtc_tick_timer( void * params )
+{
+    rtc_priv_t            * priv = (rtc_priv_t *)params;
+    struct timeval          tv;
+    int64_t                 sec;
+
+    gettimeofday( &tv, NULL );
+
+    // Timer May Land A Hair Before The Boundary, Round To The Nearest Second
+    sec = tv.tv_sec + ( tv.tv_usec >= USEC_PER_SEC / 2 );
+
+    if( RTC_SYNC_NONE != priv->sync ) {
+        PUB_INT("rtc.tick", sec);
+    }
+
+    rtc_tick_arm( priv, ( sec + 1 ) * USEC_PER_SEC - timeval_to_us( tv ) );
+}
+
+static void rtc_tick_arm( rtc_priv_t * priv, int64_t delay_us )
+{
+    esp_timer_start_once( priv->tick_timer, (uint64_t)MAX( delay_us, 1 ) );
+}
+
+static void rtc_gps_time( rtc_priv_t * priv, int64_t gps_time, int64_t rx_us )
+{
+    struct timeval          tv;
+    int64_t                 now_us;
+    int64_t                 edge_us;
+    bool                    fresh;
+
+    portENTER_CRITICAL( &priv->pps_lock );
+    edge_us = priv->pps_edge_us;
+    portEXIT_CRITICAL( &priv->pps_lock );
+
+    now_us = timebase_now_us();
+    gettimeofday( &tv, NULL );
+
+    // gps.time Names The Second That Started At The Pulse Before It Came Off The UART, A
+    // Pulse After That Belongs To The Next Message However Long This One Sat In A Queue
+    fresh = ( 0 != edge_us ) && ( edge_us != priv->last_edge_us ) &&
+            ( edge_us <= rx_us ) && ( ( rx_us - edge_us ) < PPS_FRESH_US );
+
+    if( priv->sync < RTC_SYNC_GPS ) {
+        rtc_step( priv, gps_time * USEC_PER_SEC + ( fresh ? now_us - edge_us : 0 ) );
+        rtc_set_sync( priv, RTC_SYNC_GPS );
+        return;
+    }
+
+    // A Message Can Trail Its Second, Only Step Once Several Agree
+    priv->mismatch_cnt = ( tv.tv_sec != gps_time ) ? priv->mismatch_cnt + 1 : 0;
+    if( priv->mismatch_cnt >= STEP_CONFIRM_CNT ) {
+        ESP_LOGW(TAG, "Clock Off By %lld s", (long long)( tv.tv_sec - gps_time ));
+        rtc_step( priv, gps_time * USEC_PER_SEC + ( fresh ? now_us - edge_us : 0 ) );
+        return;
+    }
+
+    if( fresh ) {
+        // Wall Clock Reading At The Edge
+        rtc_discipline( priv, edge_us, timeval_to_us( tv ) - ( now_us - edge_us ) );
+    }
+    else if( ( RTC_SYNC_PPS == priv->sync ) && ( ( now_us - priv->last_edge_us ) > PPS_LOST_US ) ) {
+        // Holdover, Frequency Correction Stops With The Pulses
+        rtc_set_sync( priv, RTC_SYNC_GPS );
+    }
+}
+
+static void rtc_discipline( rtc_priv_t * priv, int64_t edge_us, int64_t sys_edge_us )
+{
+    int64_t                 label = ( sys_edge_us + USEC_PER_SEC / 2 ) / USEC_PER_SEC;
+    int64_t                 gap = label - priv->last_label;
+    int32_t                 phase = (int32_t)( sys_edge_us - label * USEC_PER_SEC );
+    struct timeval          delta;
+    struct timeval          tv;
+
+    // FLL, esp_timer Ticks Between Pulses Against The Seconds They Span
+    if( ( 0 != priv->last_label ) && ( gap > 0 ) && ( gap <= PPS_GAP_MAX ) ) {
+        int64_t     gain = ( edge_us - priv->last_edge_us ) - gap * USEC_PER_SEC;
+
+        if( llabs( gain ) > PPS_JITTER_MAX_US * gap ) {
+            priv->glitch_cnt++;
+            priv->last_edge_us = edge_us;
+            priv->last_label = label;
+            return;
+        }
+
+        priv->freq += (int32_t)( ( gain * ( 1 << FREQ_FRAC_BITS ) / gap - priv->freq ) / ( 1 << FLL_SHIFT ) );
+    }
+
+    priv->last_edge_us  = edge_us;
+    priv->last_label    = label;
+    priv->phase_us      = phase;
+
+    if( abs( phase ) > SLEW_MAX_US ) {
+        gettimeofday( &tv, NULL );
+        rtc_step( priv, timeval_to_us( tv ) - phase );
+        return;
+    }
+
+    // PLL, Take Out Part Of The Phase Error Plus The Drift Expected Over The Next Second
+    delta.tv_sec    = 0;
+    delta.tv_usec   = -( phase / PLL_GAIN_DIV ) - ( priv->freq / ( 1 << FREQ_FRAC_BITS ) );
+    adjtime( &delta, NULL );
+
+    rtc_set_sync( priv, ( abs( phase ) < LOCK_THRESHOLD_US ) ? RTC_SYNC_PPS : RTC_SYNC_GPS );
+}
+
+static void rtc_step( rtc_priv_t * priv, int64_t utc_us )
+{
+    struct timeval          tv;
+
+    tv.tv_sec   = (time_t)( utc_us / USEC_PER_SEC );
+    tv.tv_usec  = (suseconds_t)( utc_us % USEC_PER_SEC );
+    settimeofday( &tv, NULL );
+
+    priv->step_cnt++;
+    priv->mismatch_cnt  = 0;
+    priv->last_label    = 0;
+    atomic_store( &priv->ext_stepped, true );
+
+    // Tick Follows The New Second Boundary
+    esp_timer_stop( priv->tick_timer );
+    rtc_tick_arm( priv, USEC_PER_SEC - tv.tv_usec );
+
+    ESP_LOGI(TAG, "Step To %ld.%06ld", (long)tv.tv_sec, (long)tv.tv_usec);
+}
+
+static void rtc_set_sync( rtc_priv_t * priv, rtc_sync_t sync )
+{
+    if( sync != priv->sync ) {
+        priv->sync = sync;
+        PUB_INT_FL("rtc.sync", sync, FL_STICKY);
+
+        ESP_LOGI(TAG, "Sync: %d (Phase %d us, Freq %d/256 us/s)", sync, priv->phase_us, priv->freq);
+    }
+}
+
+static void rtc_ext_update( rtc_priv_t * priv )
+{
+    struct timeval          tv;
+    int64_t                 sec;
+
+    if( atomic_exchange( &priv->ext_stepped, false ) ) {
+        priv->ext_write_us = 0;
+    }
+
+    if( !priv->ext_ok || ( priv->sync < RTC_SYNC_GPS ) || ( timebase_now_us() < priv->ext_write_us ) ) {
+        return;
+    }
+
+    // Chip Restarts Its Second On The Write, So Write On The Boundary
+    gettimeofday( &tv, NULL );
+    vTaskDelay( pdMS_TO_TICKS( ( USEC_PER_SEC - tv.tv_usec ) / 1000 ) );
+    gettimeofday( &tv, NULL );
+    sec = tv.tv_sec + ( tv.tv_usec >= USEC_PER_SEC / 2 );
 
+    if( rtc_ext_write( (time_t)sec ) ) {
+        priv->ext_write_us = timebase_now_us() + EXT_WRITE_PERIOD_US;
+        ESP_LOGD(TAG, "External Clock Set To %lld", (long long)sec);
+    }
+    else {
+        priv->ext_write_us = timebase_now_us() + EXT_RETRY_US;
+        ESP_LOGW(TAG, "External Clock Write Failed");
+    }
 }
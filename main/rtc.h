@@ -14,6 +14,15 @@
  *      TYPEDEFS
  **********************/
 
+// Published sticky on "rtc.sync"
+typedef enum
+    {
+    RTC_SYNC_NONE,              // Never set, "rtc.tick" is held back
+    RTC_SYNC_EXT,               // Read from the battery backed clock at boot
+    RTC_SYNC_GPS,               // Whole seconds from gps.time, no PPS lock
+    RTC_SYNC_PPS                // Disciplined to the PPS edge
+    } rtc_sync_t;
+
 /**********************
  *      MACROS
  **********************/
@@ -0,0 +1,226 @@
+/*********************
+ *      INCLUDES
+ *********************/
+#include <string.h>
+#include <time.h>
+
+#include "esp_system.h"
+#include "esp_log.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "driver/i2c.h"
+
+#include <lvgl_i2c_conf.h>
+
+#include "display.h"
+#include "gps.h"
+#include "rtc_ext.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+#define TAG                     "RTC_EXT"
+
+// Shares The Bus The Display Driver Set Up
+#if !defined( DISP_I2C_PORT )
+#error "External RTC Needs The Display On I2C (CONFIG_LVGL_TFT_DISPLAY_PROTOCOL_I2C)"
+#endif
+#define I2C_PORT                DISP_I2C_PORT
+#define I2C_TIMEOUT_MS          (10)
+
+// A Flush Of The Whole Screen Is Well Under This
+#define BUS_WAIT_MS             (200)
+
+#define DS3231_ADDR             (0x68)
+#define DS3231_REG_TIME         (0x00)      // Seconds Through Year, Then Alarms And Control
+#define DS3231_REG_STATUS       (0x0F)
+#define DS3231_READ_SZ          (0x10)
+#define DS3231_STATUS_OSF       (0x80)      // Oscillator Stopped, Time Is Not To Be Trusted
+
+#define PCF8563_ADDR            (0x51)
+#define PCF8563_REG_TIME        (0x02)      // Seconds Through Year
+#define PCF8563_VL              (0x80)      // Voltage Low, Time Is Not To Be Trusted
+
+#define YEAR_BASE               (2000)
+#define YEAR_MIN                (2020)      // Anything Earlier Was Never Set
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/**********************
+ *      MACROS
+ **********************/
+#define bcd_to_bin( _b )        ( ( ( ( _b ) >> 4 ) * 10 ) + ( ( _b ) & 0x0F ) )
+#define bin_to_bcd( _v )        (uint8_t)( ( ( ( _v ) / 10 ) << 4 ) | ( ( _v ) % 10 ) )
+
+/**********************
+ *     GLOBALS
+ **********************/
+static rtc_ext_chip_t       g_chip;
+
+/**********************
+ *     CONSTANTS
+ **********************/
+
+/**********************
+ *    PROTOTYPES
+ **********************/
+static esp_err_t rtc_ext_xfer( uint8_t addr, uint8_t reg, uint8_t * buf, size_t len, bool rd );
+static bool rtc_ext_decode( const uint8_t * regs, int wday_idx, time_t * utc );
+static void rtc_ext_encode( uint8_t * regs, int wday_idx, time_t utc );
+
+rtc_ext_chip_t rtc_ext_init( void )
+{
+    uint8_t                 reg;
+
+    // Probe By Address, Whichever Chip Answers
+    if( ESP_OK == rtc_ext_xfer( DS3231_ADDR, DS3231_REG_STATUS, &reg, 1, true ) ) {
+        g_chip = RTC_EXT_DS3231;
+    }
+    else if( ESP_OK == rtc_ext_xfer( PCF8563_ADDR, PCF8563_REG_TIME, &reg, 1, true ) ) {
+        g_chip = RTC_EXT_PCF8563;
+    }
+    else {
+        g_chip = RTC_EXT_NONE;
+    }
+
+    ESP_LOGI(TAG, "chip: %s", ( RTC_EXT_DS3231 == g_chip ) ? "DS3231" : ( RTC_EXT_PCF8563 == g_chip ) ? "PCF8563" : "none");
+
+    return g_chip;
+}
+
+bool rtc_ext_read( time_t * utc )
+{
+    uint8_t                 regs[DS3231_READ_SZ];
+
+    switch( g_chip ) {
+        case RTC_EXT_DS3231:
+            if( ESP_OK != rtc_ext_xfer( DS3231_ADDR, DS3231_REG_TIME, regs, sizeof( regs ), true ) ) {
+                return false;
+            }
+            if( regs[DS3231_REG_STATUS] & DS3231_STATUS_OSF ) {
+                ESP_LOGW(TAG, "oscillator stopped, time lost");
+                return false;
+            }
+            return rtc_ext_decode( regs, 3, utc );
+
+        case RTC_EXT_PCF8563:
+            if( ESP_OK != rtc_ext_xfer( PCF8563_ADDR, PCF8563_REG_TIME, regs, 7, true ) ) {
+                return false;
+            }
+            if( regs[0] & PCF8563_VL ) {
+                ESP_LOGW(TAG, "supply dropped, time lost");
+                return false;
+            }
+            return rtc_ext_decode( regs, 4, utc );
+
+        default:
+            return false;
+    }
+}
+
+bool rtc_ext_write( time_t utc )
+{
+    uint8_t                 regs[7];
+    uint8_t                 status;
+
+    switch( g_chip ) {
+        case RTC_EXT_DS3231:
+            rtc_ext_encode( regs, 3, utc );
+            if( ESP_OK != rtc_ext_xfer( DS3231_ADDR, DS3231_REG_TIME, regs, sizeof( regs ), false ) ) {
+                return false;
+            }
+
+            // Time Is Good Again, Drop The Oscillator Stop Flag
+            if( ( ESP_OK == rtc_ext_xfer( DS3231_ADDR, DS3231_REG_STATUS, &status, 1, true ) ) &&
+                ( status & DS3231_STATUS_OSF ) ) {
+                status &= ~DS3231_STATUS_OSF;
+                rtc_ext_xfer( DS3231_ADDR, DS3231_REG_STATUS, &status, 1, false );
+            }
+            return true;
+
+        case RTC_EXT_PCF8563:
+            // Writing Seconds With VL Clear Also Clears The Flag
+            rtc_ext_encode( regs, 4, utc );
+            return ( ESP_OK == rtc_ext_xfer( PCF8563_ADDR, PCF8563_REG_TIME, regs, sizeof( regs ), false ) );
+
+        default:
+            return false;
+    }
+}
+
+static esp_err_t rtc_ext_xfer( uint8_t addr, uint8_t reg, uint8_t * buf, size_t len, bool rd )
+{
+    const TickType_t        start = xTaskGetTickCount();
+    i2c_cmd_handle_t        cmd;
+    esp_err_t               err;
+
+    // Only Ever Between Flushes, A Busy Display Just Makes Us Wait
+    while( !display_bus_try_lock() ) {
+        if( ( xTaskGetTickCount() - start ) >= pdMS_TO_TICKS( BUS_WAIT_MS ) ) {
+            return ESP_ERR_TIMEOUT;
+        }
+        vTaskDelay( 1 );
+    }
+
+    cmd = i2c_cmd_link_create();
+    i2c_master_start( cmd );
+    i2c_master_write_byte( cmd, ( addr << 1 ) | I2C_MASTER_WRITE, true );
+    i2c_master_write_byte( cmd, reg, true );
+    if( rd ) {
+        i2c_master_start( cmd );
+        i2c_master_write_byte( cmd, ( addr << 1 ) | I2C_MASTER_READ, true );
+        i2c_master_read( cmd, buf, len, I2C_MASTER_LAST_NACK );
+    }
+    else {
+        i2c_master_write( cmd, buf, len, true );
+    }
+    i2c_master_stop( cmd );
+
+    err = i2c_master_cmd_begin( I2C_PORT, cmd, pdMS_TO_TICKS( I2C_TIMEOUT_MS ) );
+    i2c_cmd_link_delete( cmd );
+
+    display_bus_unlock();
+
+    return err;
+}
+
+// Both Chips Keep Seconds, Minutes, Hours, Then Date And Weekday In Either Order, Month, Year
+static bool rtc_ext_decode( const uint8_t * regs, int wday_idx, time_t * utc )
+{
+    const int               day_idx = ( 3 == wday_idx ) ? 4 : 3;
+    unsigned                sec = bcd_to_bin( regs[0] & 0x7F );
+    unsigned                min = bcd_to_bin( regs[1] & 0x7F );
+    unsigned                hour = bcd_to_bin( regs[2] & 0x3F );   // 24 Hour Mode, Always Written That Way
+    unsigned                day = bcd_to_bin( regs[day_idx] & 0x3F );
+    unsigned                month = bcd_to_bin( regs[5] & 0x1F );
+    unsigned                year = YEAR_BASE + bcd_to_bin( regs[6] );
+
+    if( ( sec > 59 ) || ( min > 59 ) || ( hour > 23 ) || ( day < 1 ) || ( day > 31 ) ||
+        ( month < 1 ) || ( month > 12 ) || ( year < YEAR_MIN ) ) {
+        return false;
+    }
+
+    *utc = (time_t)gps_utc_to_epoch( year, month, day, hour, min, sec );
+
+    return true;
+}
+
+static void rtc_ext_encode( uint8_t * regs, int wday_idx, time_t utc )
+{
+    const int               day_idx = ( 3 == wday_idx ) ? 4 : 3;
+    struct tm               tm;
+
+    gmtime_r( &utc, &tm );
+
+    regs[0]         = bin_to_bcd( tm.tm_sec );
+    regs[1]         = bin_to_bcd( tm.tm_min );
+    regs[2]         = bin_to_bcd( tm.tm_hour );
+    regs[wday_idx]  = (uint8_t)( ( 3 == wday_idx ) ? tm.tm_wday + 1 : tm.tm_wday );  // DS3231 1-7, PCF8563 0-6
+    regs[day_idx]   = bin_to_bcd( tm.tm_mday );
+    regs[5]         = bin_to_bcd( tm.tm_mon + 1 );
+    regs[6]         = bin_to_bcd( ( tm.tm_year + 1900 - YEAR_BASE ) % 100 );
+}
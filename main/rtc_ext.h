@@ -0,0 +1,42 @@
+#ifndef DASH_RTC_EXT_H
+#define DASH_RTC_EXT_H
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdbool.h>
+#include <time.h>
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+typedef enum
+    {
+    RTC_EXT_NONE,
+    RTC_EXT_DS3231,
+    RTC_EXT_PCF8563
+    } rtc_ext_chip_t;
+
+/**********************
+ *      MACROS
+ **********************/
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/*
+ * Battery backed clock chip on the display's I2C bus, kept in UTC. The bus is
+ * brought up by display_start(), so call rtc_ext_init() after it. Every
+ * transaction waits for a gap between display flushes (display_bus_try_lock())
+ * rather than holding a flush up, and gives up if none comes along.
+ */
+rtc_ext_chip_t rtc_ext_init( void );
+bool rtc_ext_read( time_t * utc );
+bool rtc_ext_write( time_t utc );
+
+#endif //DASH_RTC_EXT_H
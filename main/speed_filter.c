@@ -0,0 +1,176 @@
+/*********************
+ *      INCLUDES
+ *********************/
+#include <string.h>
+#include <stdlib.h>
+
+#include "speed_filter.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+#define USEC_PER_SEC            (1000000LL)
+#define NEVER_US                (INT64_MIN / 4)     // Far Enough Back To Subtract From
+
+#define Q_BITS                  (8)
+#define GAIN_ONE                (256)               // Gains Are Out Of GAIN_ONE
+
+// Wheel Speed Leads, GPS Mostly Holds It Honest
+#define WHEEL_ALPHA             (128)
+#define WHEEL_BETA              (32)
+#define GPS_ALPHA               (48)
+#define GPS_BETA                (8)
+#define GPS_ALPHA_ALONE         (160)
+#define GPS_BETA_ALONE          (48)
+
+#define PERIOD_MIN_US           (20000)
+#define PERIOD_MAX_US           (2 * USEC_PER_SEC)
+#define PERIOD_DEFAULT_US       (100000)
+#define SOURCE_TIMEOUT_US       (USEC_PER_SEC)      // Wheel Older Than This Is Not Current
+#define STALE_US                (2 * USEC_PER_SEC)  // Nothing Newer Than This, No Estimate
+#define EXTRAPOLATE_MAX_US      (500000)
+
+#define ACCEL_MAX               ( ( 30 * 100 ) << Q_BITS )  // 30 km/h/s At GPS_SPEED_SCALE 100
+
+// Wheel Scale Trim, Only At Steady Speed With Both Sources Close In Time
+#define SCALE_ONE               (65536u)
+#define SCALE_MIN               ( SCALE_ONE * 8 / 10 )
+#define SCALE_MAX               ( SCALE_ONE * 12 / 10 )
+#define SCALE_SHIFT             (6)
+#define SCALE_SPEED_MIN         (20 * 100)
+#define SCALE_ACCEL_MAX         ( ( 2 * 100 ) << Q_BITS )
+#define SCALE_WINDOW_US         (200000)
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/**********************
+ *      MACROS
+ **********************/
+#define clamp( _v, _lo, _hi )   ( ( _v ) < ( _lo ) ? ( _lo ) : ( ( _v ) > ( _hi ) ? ( _hi ) : ( _v ) ) )
+
+/**********************
+ *     GLOBALS
+ **********************/
+
+/**********************
+ *     CONSTANTS
+ **********************/
+
+/**********************
+ *    PROTOTYPES
+ **********************/
+static void speed_filter_update
+    (
+    speed_filter_t        * filter,
+    int32_t                 speed,
+    int64_t                 t_us,
+    int64_t                 period_us,
+    int32_t                 alpha,
+    int32_t                 beta
+    );
+
+void speed_filter_init( speed_filter_t * filter )
+{
+    memset( filter, 0, sizeof( *filter ) );
+
+    filter->wheel_scale = SCALE_ONE;
+    filter->wheel_t_us  = NEVER_US;
+    filter->gps_t_us    = NEVER_US;
+}
+
+void speed_filter_gps( speed_filter_t * filter, int32_t speed, int64_t t_us )
+{
+    bool        wheel_current = llabs( t_us - filter->wheel_t_us ) < SOURCE_TIMEOUT_US;
+    int64_t     period_us = ( NEVER_US == filter->gps_t_us ) ? PERIOD_DEFAULT_US : t_us - filter->gps_t_us;
+
+    // Trim Wheel Scale Toward GPS
+    if( wheel_current && ( speed >= SCALE_SPEED_MIN ) && ( filter->wheel_last > 0 ) &&
+        ( abs( filter->accel ) <= SCALE_ACCEL_MAX ) && ( llabs( t_us - filter->wheel_t_us ) < SCALE_WINDOW_US ) ) {
+        int64_t     ratio = ( (int64_t)speed << 16 ) / filter->wheel_last;
+
+        if( ( ratio >= SCALE_MIN ) && ( ratio <= SCALE_MAX ) ) {
+            filter->wheel_scale = (uint32_t)( filter->wheel_scale + ( ratio - (int64_t)filter->wheel_scale ) / ( 1 << SCALE_SHIFT ) );
+        }
+    }
+
+    filter->gps_t_us = t_us;
+
+    speed_filter_update( filter, speed, t_us, period_us,
+                         wheel_current ? GPS_ALPHA : GPS_ALPHA_ALONE,
+                         wheel_current ? GPS_BETA : GPS_BETA_ALONE );
+}
+
+void speed_filter_wheel( speed_filter_t * filter, int32_t speed, int64_t t_us )
+{
+    int64_t     period_us = ( NEVER_US == filter->wheel_t_us ) ? PERIOD_DEFAULT_US : t_us - filter->wheel_t_us;
+
+    filter->wheel_last  = speed;
+    filter->wheel_t_us  = t_us;
+
+    speed = (int32_t)( ( (int64_t)speed * filter->wheel_scale + SCALE_ONE / 2 ) >> 16 );
+
+    speed_filter_update( filter, speed, t_us, period_us, WHEEL_ALPHA, WHEEL_BETA );
+}
+
+int32_t speed_filter_estimate( const speed_filter_t * filter, int64_t t_us )
+{
+    int64_t     latest_us = ( filter->wheel_t_us > filter->gps_t_us ) ? filter->wheel_t_us : filter->gps_t_us;
+    int64_t     dt_us;
+    int64_t     vel;
+
+    if( !filter->valid || ( ( t_us - latest_us ) > STALE_US ) ) {
+        return -1;
+    }
+
+    // Run Forward On The Acceleration, But Not Far
+    dt_us = clamp( t_us - filter->t_us, 0, EXTRAPOLATE_MAX_US );
+    vel = filter->vel + (int64_t)filter->accel * dt_us / USEC_PER_SEC;
+
+    if( vel <= 0 ) {
+        return 0;
+    }
+
+    return (int32_t)( ( vel + ( 1 << ( Q_BITS - 1 ) ) ) >> Q_BITS );
+}
+
+static void speed_filter_update
+    (
+    speed_filter_t        * filter,
+    int32_t                 speed,
+    int64_t                 t_us,
+    int64_t                 period_us,
+    int32_t                 alpha,
+    int32_t                 beta
+    )
+{
+    int64_t     dt_us = t_us - filter->t_us;
+    int64_t     pred;
+    int64_t     resid;
+    int64_t     accel;
+
+    if( !filter->valid || ( dt_us > STALE_US ) ) {
+        filter->valid   = true;
+        filter->t_us    = t_us;
+        filter->vel     = speed << Q_BITS;
+        filter->accel   = 0;
+        return;
+    }
+
+    // Residual Against The Prediction At The Measurement Time, Which Can Be
+    // Behind The State When A Lagged GPS Sample Follows A Wheel Sample
+    pred = filter->vel + (int64_t)filter->accel * dt_us / USEC_PER_SEC;
+    resid = ( (int64_t)speed << Q_BITS ) - pred;
+
+    if( dt_us > 0 ) {
+        filter->vel     = (int32_t)pred;
+        filter->t_us    = t_us;
+    }
+
+    period_us = clamp( period_us, PERIOD_MIN_US, PERIOD_MAX_US );
+    accel = filter->accel + resid * beta * USEC_PER_SEC / ( GAIN_ONE * period_us );
+
+    filter->vel     = (int32_t)( filter->vel + resid * alpha / GAIN_ONE );
+    filter->accel   = (int32_t)clamp( accel, -ACCEL_MAX, ACCEL_MAX );
+}
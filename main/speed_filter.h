@@ -0,0 +1,62 @@
+#ifndef DASH_SPEED_FILTER_H
+#define DASH_SPEED_FILTER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdint.h>
+#include <stdbool.h>
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/*
+ * Alpha-beta (steady state Kalman) filter over speed and acceleration. All
+ * speeds are km/h * GPS_SPEED_SCALE, all times are microseconds on any
+ * monotonic clock. Nothing here touches the RTOS, so it builds on a host.
+ */
+typedef struct
+    {
+    bool                    valid;
+    int64_t                 t_us;           // Time Of vel / accel
+    int32_t                 vel;            // Q8
+    int32_t                 accel;          // Per Second, Q8
+
+    // Wheel Speed Is Fast But Off By Tyre Size, GPS Trims It
+    uint32_t                wheel_scale;    // Q16, 1.0 Is 65536
+    int32_t                 wheel_last;     // Raw, Before Scaling
+    int64_t                 wheel_t_us;
+    int64_t                 gps_t_us;
+    } speed_filter_t;
+
+/**********************
+ *      MACROS
+ **********************/
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+void speed_filter_init( speed_filter_t * filter );
+
+// t_us is when the measurement was valid, which may be behind the filter
+void speed_filter_gps( speed_filter_t * filter, int32_t speed, int64_t t_us );
+void speed_filter_wheel( speed_filter_t * filter, int32_t speed, int64_t t_us );
+
+// Speed extrapolated to t_us, -1 if no source is current
+int32_t speed_filter_estimate( const speed_filter_t * filter, int64_t t_us );
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif //DASH_SPEED_FILTER_H
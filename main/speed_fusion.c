@@ -0,0 +1,126 @@
+/*********************
+ *      INCLUDES
+ *********************/
+#include <string.h>
+
+#include <pubsub.h>
+
+#include "esp_system.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "timebase.h"
+#include "gps.h"
+#include "speed_filter.h"
+#include "speed_fusion.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+#define TAG                     "SPEED"
+
+#define SPEED_FUSION_PERIOD_MS  (20)
+
+// Age Of A Sample When It Is Stamped, Queueing After That Is Already In t_us
+#define GPS_SPEED_LAG_US        (140000)    // Fix Epoch To The Last Byte Off The UART
+#define WHEEL_SPEED_LAG_US      (10000)     // ECU Sample To The Frame Off The Bus
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/**********************
+ *      MACROS
+ **********************/
+
+/**********************
+ *     GLOBALS
+ **********************/
+static portMUX_TYPE         g_filter_lock = portMUX_INITIALIZER_UNLOCKED;
+static speed_filter_t       g_filter;
+static esp_timer_handle_t   g_publish_timer;
+
+/**********************
+ *     CONSTANTS
+ **********************/
+
+/**********************
+ *    PROTOTYPES
+ **********************/
+_Noreturn static void speed_fusion_task( void * params );
+static void speed_fusion_publish( void * params );
+
+void speed_fusion_start( void )
+{
+    ESP_LOGI(TAG, "Start");
+
+    speed_filter_init( &g_filter );
+
+    // Gauge Gets Its Own Steady Rate, Whatever The Sources Are Doing
+    const esp_timer_create_args_t publish_timer_args =
+            {
+            .callback = &speed_fusion_publish,
+            .name = "speed_fusion_publish_timer"
+            };
+    esp_timer_create(&publish_timer_args, &g_publish_timer);
+    esp_timer_start_periodic( g_publish_timer, SPEED_FUSION_PERIOD_MS * 1000 );
+
+    xTaskCreate( speed_fusion_task, "speed_fusion_task", 3 * 1024, NULL, 11, NULL );
+}
+
+void speed_fusion_stop( void )
+{
+    esp_timer_stop( g_publish_timer );
+    esp_timer_delete( g_publish_timer );
+}
+
+_Noreturn static void speed_fusion_task( void * params )
+{
+    ps_subscriber_t       * s = ps_new_subscriber(10, STRLIST( "gps.speed", "gps.fix", "can.wheel_speed" ));
+    ps_msg_t              * msg = NULL;
+    timebase_sample_t       sample;
+    bool                    fix_valid = false;
+
+    while(true) {
+        msg = ps_get( s, -1 );
+        if( msg != NULL ) {
+            if( 0 == strcmp( "gps.fix", msg->topic ) ) {
+                fix_valid = ( sizeof( gps_fix_status_t ) == msg->buf_val.sz ) &&
+                            gps_fix_status_valid( (const gps_fix_status_t *)msg->buf_val.ptr );
+            }
+            else if( ( 0 == strcmp( "gps.speed", msg->topic ) ) && timebase_sample( msg, &sample ) ) {
+                // Bad Fixes Never Reach The Filter, It Coasts On The Wheel Or Goes Stale
+                if( fix_valid ) {
+                    portENTER_CRITICAL( &g_filter_lock );
+                    speed_filter_gps( &g_filter, (int32_t)sample.value, sample.t_us - GPS_SPEED_LAG_US );
+                    portEXIT_CRITICAL( &g_filter_lock );
+                }
+            }
+            else if( ( 0 == strcmp( "can.wheel_speed", msg->topic ) ) && timebase_sample( msg, &sample ) ) {
+                portENTER_CRITICAL( &g_filter_lock );
+                speed_filter_wheel( &g_filter, (int32_t)sample.value, sample.t_us - WHEEL_SPEED_LAG_US );
+                portEXIT_CRITICAL( &g_filter_lock );
+            }
+
+            ps_unref_msg(msg);
+        }
+    }
+}
+
+static void speed_fusion_publish( void * params )
+{
+    const int64_t   now_us = timebase_now_us();
+    int32_t         speed;
+
+    portENTER_CRITICAL( &g_filter_lock );
+    speed = speed_filter_estimate( &g_filter, now_us );
+    portEXIT_CRITICAL( &g_filter_lock );
+
+    // Nothing Current, Leave The Last Value Standing
+    if( speed >= 0 ) {
+        timebase_publish( "vehicle.speed", speed, now_us );
+    }
+}
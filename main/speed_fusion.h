@@ -0,0 +1,31 @@
+#ifndef DASH_SPEED_FUSION_H
+#define DASH_SPEED_FUSION_H
+
+/*********************
+ *      INCLUDES
+ *********************/
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/**********************
+ *      MACROS
+ **********************/
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/*
+ * Fuses "gps.speed" and "can.wheel_speed" into "vehicle.speed", published
+ * every SPEED_FUSION_PERIOD_MS in the same km/h * GPS_SPEED_SCALE units.
+ */
+void speed_fusion_start( void );
+void speed_fusion_stop( void );
+
+#endif //DASH_SPEED_FUSION_H
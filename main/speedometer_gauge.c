@@ -3,6 +3,7 @@
  *      INCLUDES
  *********************/
 #include <string.h>
+#include <sys/param.h>
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
@@ -15,6 +16,8 @@
 #include "speedometer_gauge.h"
 #include "stepper_gauge.h"
 #include "console_intf.h"
+#include "timebase.h"
+#include "gps.h"
 
 /*********************
  *      DEFINES
@@ -27,6 +30,17 @@
 #define SPEED_DEG_MIN       0
 #define SPEED_DEG_MAX       87
 
+// 1 mph = 1.609344 km/h, kept as a ratio so it folds at compile time
+#define KPH_PER_MPH_NUM     1609344LL
+#define KPH_PER_MPH_DEN     1000000LL
+
+// Gauge centidegrees per vehicle.speed count, Q16
+#define SPEED_TO_CDEG_Q16   (int32_t)( ( SPEED_DEG_MAX * 100LL * 65536 * KPH_PER_MPH_DEN ) / \
+                                       ( SPEED_MPH_MAX * GPS_SPEED_SCALE * KPH_PER_MPH_NUM ) )
+
+// Over The Posted Limit By More Than This Raises "speedometer.overspeed", Back Under Half Of It Clears It
+#define OVERSPEED_MARGIN    ( 3 * GPS_SPEED_SCALE )
+
 /**********************
  *      TYPEDEFS
  **********************/
@@ -40,6 +54,10 @@
  **********************/
 
 static bool             g_stepper_init_finished;
+static int32_t          g_speed_centidegree;
+static int32_t          g_speed;
+static int32_t          g_speed_limit;
+static bool             g_overspeed;
 
 static struct {
     struct arg_int *speed;
@@ -80,18 +98,24 @@ static esp_console_cmd_t  g_commands[] =
 /**********************
  *     MACROS
  **********************/
-#define mph_to_deg( _spd )      (float)( ( ( _spd ) * SPEED_DEG_MAX ) / SPEED_MPH_MAX )
+#define mph_to_centideg( _spd )     (int32_t)( ( ( _spd ) * SPEED_DEG_MAX * 100 ) / SPEED_MPH_MAX )
+#define speed_to_centideg( _spd )   (int32_t)( ( (int64_t)( _spd ) * SPEED_TO_CDEG_Q16 + 32768 ) >> 16 )
 
 /**********************
  *    PROTOTYPES
  **********************/
 _Noreturn static void msg_task( void * params );
+static void overspeed_update( void );
 
 void speedometer_gauge_init( void )
 {
     ESP_LOGI(TAG, "Init");
 
     g_stepper_init_finished = false;
+    g_speed_centidegree = -1;
+    g_speed = 0;
+    g_speed_limit = 0;
+    g_overspeed = false;
 
     // Setup Arguments
     g_speed_args.speed = arg_intn(NULL, NULL, "<int>", SPEED_MPH_MIN, SPEED_MPH_MAX, "mph");
@@ -120,15 +144,16 @@ void speedometer_gauge_stop( void )
 
 _Noreturn static void msg_task( void * params )
 {
-    ps_subscriber_t *s = ps_new_subscriber(10, STRLIST( "stepper" ));
+    ps_subscriber_t *s = ps_new_subscriber(10, STRLIST( "stepper", "vehicle.speed", "geo.speed_limit" ));
 
     ps_msg_t *msg = NULL;
+    timebase_sample_t sample;
 
     while(true) {
         msg = ps_get( s, -1 );
         if( msg != NULL) {
             if( 0 == strcmp( "stepper.started", msg->topic ) ) {
-                ESP_LOGI(TAG, "Speedo Stepper Started");
+                ESP_LOGD(TAG, "Speedo Stepper Started");
             }
             else if( 0 == strcmp( "stepper.finished", msg->topic ) ) {
                 ESP_LOGI(TAG, "Speedo Stepper Finished");
@@ -137,20 +162,60 @@ _Noreturn static void msg_task( void * params )
                     g_stepper_init_finished = true;
 
                     // Return to Gauge Min
-                    stepper_gauge_set_degree( mph_to_deg(SPEED_MPH_MIN) );
+                    stepper_gauge_set_centidegree( mph_to_centideg(SPEED_MPH_MIN) );
                 }
             }
             else if( 0 == strcmp( "stepper.ready", msg->topic ) ) {
                 ESP_LOGI(TAG, "Speedo Stepper Ready");
                 if( false == g_stepper_init_finished ) {
                     // Set to Gauge Max
-                    stepper_gauge_set_degree( mph_to_deg(SPEED_MPH_MAX) );
+                    stepper_gauge_set_centidegree( mph_to_centideg(SPEED_MPH_MAX) );
+                }
+            }
+            else if( ( 0 == strcmp( "vehicle.speed", msg->topic ) ) && timebase_sample( msg, &sample ) ) {
+                // Needle Belongs To The Sweep Until It Has Finished
+                if( g_stepper_init_finished ) {
+                    int32_t centidegree = MIN( speed_to_centideg( sample.value ), SPEED_DEG_MAX * 100 );
+
+                    if( centidegree != g_speed_centidegree ) {
+                        g_speed_centidegree = centidegree;
+                        stepper_gauge_set_centidegree( centidegree );
+                    }
                 }
+
+                g_speed = sample.value;
+                overspeed_update();
             }
+            else if( 0 == strcmp( "geo.speed_limit", msg->topic ) ) {
+                g_speed_limit = msg->int_val;
+                overspeed_update();
+            }
+
+            ps_unref_msg(msg);
         }
     }
 }
 
+static void overspeed_update( void )
+{
+    bool overspeed = g_overspeed;
+
+    // Unknown Limit Never Counts As Overspeed
+    if( 0 == g_speed_limit ) {
+        overspeed = false;
+    }
+    else if( g_speed > g_speed_limit + OVERSPEED_MARGIN ) {
+        overspeed = true;
+    }
+    else if( g_speed < g_speed_limit + OVERSPEED_MARGIN / 2 ) {
+        overspeed = false;
+    }
+
+    if( overspeed != g_overspeed ) {
+        g_overspeed = overspeed;
+        PUB_INT_FL("speedometer.overspeed", overspeed, FL_STICKY);
+    }
+}
 
 static int speed_cmd(int argc, char **argv)
 {
@@ -163,7 +228,7 @@ static int speed_cmd(int argc, char **argv)
     ESP_LOGI(TAG, "Set Speedometer To: %d mph",
              g_speed_args.speed->ival[0]);
 
-    stepper_gauge_set_degree( mph_to_deg( g_speed_args.speed->ival[0] ) );
+    stepper_gauge_set_centidegree( mph_to_centideg( g_speed_args.speed->ival[0] ) );
     return 0;
 }
 
@@ -6,6 +6,8 @@
 /*********************
  *      INCLUDES
  *********************/
+#include <sys/param.h>
+
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/timers.h"
@@ -16,6 +18,7 @@
 
 #include "driver/gpio.h"
 
+#include "timebase.h"
 #include "stepper_gauge.h"
 
 /*********************
@@ -105,7 +108,7 @@ void stepper_gauge_start( void )
             };
     esp_timer_create(&stepper_tick_timer_args, &g_update_timer);
 
-    PUB_NIL("stepper.ready");
+    timebase_publish( "stepper.ready", g_current_step, timebase_now_us() );
 }
 
 void stepper_gauge_stop( void )
@@ -115,14 +118,18 @@ void stepper_gauge_stop( void )
 
 void stepper_gauge_set_degree( float degree )
 {
-    ESP_LOGI( TAG, "In Reset: %d", g_in_reset );
+    stepper_gauge_set_centidegree( (int32_t)( degree * 100 ) );
+}
 
+void stepper_gauge_set_centidegree( int32_t centidegree )
+{
+    ESP_LOGD( TAG, "In Reset: %d", g_in_reset );
 
     if( false == g_in_reset ) {
         // Convert Degrees to Step Position
-        int position = (degree * STEPS_PER_DEGREE_CNT * MICROSTEP_PER_STEP_CNT);
+        int position = ( MAX( centidegree, 0 ) * STEPS_PER_DEGREE_CNT * MICROSTEP_PER_STEP_CNT ) / 100;
 
-        ESP_LOGI( TAG, "Set Degree: %.1f (Pos: %d)", degree, position );
+        ESP_LOGD( TAG, "Set Degree: %d.%02d (Pos: %d)", centidegree / 100, centidegree % 100, position );
 
         // Set Position
         stepper_set_position( position );
@@ -177,7 +184,7 @@ static void stepper_zero( void )
     ESP_LOGI(TAG, "%d to %d", g_current_step, g_target_step );
 
     // Announce Started
-    PUB_NIL("stepper.reset");
+    timebase_publish( "stepper.reset", g_current_step, timebase_now_us() );
 
     // Start Advancing Stepper
     unsigned char i = 0;
@@ -198,10 +205,10 @@ static void stepper_advance( void )
         // Announce Finished
         if( g_in_reset ) {
             g_in_reset = false;
-            PUB_NIL("stepper.ready");
+            timebase_publish( "stepper.ready", g_current_step, timebase_now_us() );
         }
         else {
-            PUB_NIL("stepper.finished");
+            timebase_publish( "stepper.finished", g_current_step, timebase_now_us() );
         }
 
         g_dir = 0;
@@ -262,10 +269,10 @@ static void stepper_set_position( uint32_t position )
     // Set Target
     g_target_step = position;
 
-    ESP_LOGI(TAG, "%d to %d", g_current_step, g_target_step );
+    ESP_LOGD(TAG, "%d to %d", g_current_step, g_target_step );
 
     // Announce Started
-    PUB_NIL("stepper.started");
+    timebase_publish( "stepper.started", g_current_step, timebase_now_us() );
 
     // Start Advancing Stepper
     unsigned char i = 0;
@@ -8,6 +8,7 @@ extern "C" {
 /*********************
  *      INCLUDES
  *********************/
+#include <stdint.h>
 
 /*********************
  *      DEFINES
@@ -30,6 +31,7 @@ extern "C" {
 void stepper_gauge_start( void );
 void stepper_gauge_stop( void );
 void stepper_gauge_set_degree( float degree );
+void stepper_gauge_set_centidegree( int32_t centidegree );
 void stepper_gauge_reset( void );
 
 #ifdef __cplusplus
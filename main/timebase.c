@@ -0,0 +1,57 @@
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdlib.h>
+
+#include <pubsub.h>
+
+#include "timebase.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/**********************
+ *      MACROS
+ **********************/
+
+/**********************
+ *     GLOBALS
+ **********************/
+
+/**********************
+ *     CONSTANTS
+ **********************/
+
+/**********************
+ *    PROTOTYPES
+ **********************/
+
+void timebase_publish( const char * topic, int64_t value, int64_t t_us )
+{
+    timebase_sample_t     * sample;
+
+    sample = malloc( sizeof( *sample ) );
+    if( NULL == sample ) {
+        return;
+    }
+
+    sample->t_us    = t_us;
+    sample->value   = value;
+    PUB_BUF(topic, sample, sizeof( *sample ), free);
+}
+
+bool timebase_sample( const ps_msg_t * msg, timebase_sample_t * sample )
+{
+    if( !IS_BUF(msg) || ( sizeof( *sample ) != msg->buf_val.sz ) ) {
+        return false;
+    }
+
+    *sample = *(const timebase_sample_t *)msg->buf_val.ptr;
+
+    return true;
+}
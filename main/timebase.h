@@ -0,0 +1,79 @@
+#ifndef DASH_TIMEBASE_H
+#define DASH_TIMEBASE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <pubsub.h>
+
+#ifdef ESP_PLATFORM
+#include "esp_timer.h"
+#else
+#include <time.h>
+#endif
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/*
+ * Measurement published with timebase_publish(), t_us is when it was taken
+ * (or received, for anything read off a bus), not when it was delivered.
+ */
+typedef struct
+    {
+    int64_t                 t_us;       // timebase_now_us()
+    int64_t                 value;
+    } timebase_sample_t;
+
+/**********************
+ *      MACROS
+ **********************/
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+/*
+ * Microseconds since boot, never steps or slews when the wall clock is set.
+ * Inline so ISRs in IRAM can read it.
+ */
+static inline int64_t timebase_now_us( void )
+{
+#ifdef ESP_PLATFORM
+    return esp_timer_get_time();
+#else
+    struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#endif
+}
+
+// Wraps After 49 Days, Only Compare By Difference
+static inline uint32_t timebase_now_ms( void )
+{
+    return (uint32_t)( timebase_now_us() / 1000 );
+}
+
+void timebase_publish( const char * topic, int64_t value, int64_t t_us );
+
+// False If msg Did Not Come From timebase_publish()
+bool timebase_sample( const ps_msg_t * msg, timebase_sample_t * sample );
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif //DASH_TIMEBASE_H
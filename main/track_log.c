@@ -0,0 +1,314 @@
+/*********************
+ *      INCLUDES
+ *********************/
+#include <string.h>
+
+#include "esp_system.h"
+#include "esp_log.h"
+#include "esp_partition.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+
+#include "track_log.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+#define TAG                     "TRACK"
+
+#define PARTITION_LABEL         "track"
+#define PARTITION_SUBTYPE       ( (esp_partition_subtype_t)0x41 )
+
+#define PAGE_CNT                (4)         // RAM Staging, Filled By GPS, Drained By The Writer
+#define SECTOR_HDR_SZ           (8)
+#define RECORD_MAX_SZ           ( 1 + 4 * 10 )
+#define LEN_PAD                 (0xFF)
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+typedef struct
+    {
+    uint32_t                offset;     // In The Partition, Page Aligned
+    uint8_t                 data[TRACK_LOG_PAGE_SZ];
+    } track_page_t;
+
+typedef struct
+    {
+    const esp_partition_t * part;
+    SemaphoreHandle_t       lock;       // Between Producers Only, Never Held Over Flash
+    QueueHandle_t           free_q;
+    QueueHandle_t           full_q;
+    track_page_t            pages[PAGE_CNT];
+
+    // Encoder, Under lock
+    track_page_t          * page;
+    uint32_t                fill;
+    uint32_t                next_offset;
+    uint32_t                seq;
+    int64_t                 prev[4];    // Time, Lat, Lon, Speed Of The Last Record
+    int64_t                 step[4];    // And How Far They Moved From The One Before
+    bool                    first;      // Next Record Opens A Sector
+
+    // Statistics
+    uint32_t                record_cnt;
+    uint32_t                drop_cnt;
+    uint32_t                write_err_cnt;
+    } track_priv_t;
+
+/**********************
+ *      MACROS
+ **********************/
+
+/**********************
+ *     GLOBALS
+ **********************/
+static track_priv_t         g_priv;
+
+/**********************
+ *     CONSTANTS
+ **********************/
+
+/**********************
+ *    PROTOTYPES
+ **********************/
+_Noreturn static void track_log_writer_task( void * params );
+static bool track_log_page_open( track_priv_t * priv );
+static void track_log_page_close( track_priv_t * priv );
+static uint32_t track_log_recover( track_priv_t * priv );
+static bool track_log_sector_seq( track_priv_t * priv, uint32_t sector, uint32_t * seq );
+static size_t put_varint( uint8_t * buf, int64_t val );
+
+bool track_log_init( void )
+{
+    uint8_t     idx;
+
+    memset( &g_priv, 0, sizeof( g_priv ) );
+
+    g_priv.part = esp_partition_find_first( ESP_PARTITION_TYPE_DATA, PARTITION_SUBTYPE, PARTITION_LABEL );
+    if( NULL == g_priv.part ) {
+        ESP_LOGE(TAG, "No '%s' Partition", PARTITION_LABEL);
+        return false;
+    }
+
+    g_priv.lock     = xSemaphoreCreateMutex();
+    g_priv.free_q   = xQueueCreate( PAGE_CNT, sizeof( uint8_t ) );
+    g_priv.full_q   = xQueueCreate( PAGE_CNT, sizeof( uint8_t ) );
+
+    for( idx = 0; idx < PAGE_CNT; idx++ ) {
+        xQueueSend( g_priv.free_q, &idx, 0 );
+    }
+
+    // Carry On In A Fresh Sector After The Newest One
+    g_priv.next_offset = track_log_recover( &g_priv );
+
+    xTaskCreate( track_log_writer_task, "track_log_writer_task", 3 * 1024, &g_priv, 4, NULL );
+
+    return true;
+}
+
+void track_log_append( const gps_fix_t * fix )
+{
+    track_priv_t          * priv = &g_priv;
+    int64_t                 val[4];
+    int64_t                 delta[4];
+    uint8_t                 rec[RECORD_MAX_SZ];
+    size_t                  len;
+
+    if( NULL == priv->lock ) {
+        return;
+    }
+
+    val[0] = (int64_t)fix->time * 100 + fix->nano / 10000000;
+    val[1] = fix->lat;
+    val[2] = fix->lon;
+    val[3] = fix->speed / 10;
+
+    xSemaphoreTake( priv->lock, portMAX_DELAY );
+
+    // Second Pass Only When The Record Did Not Fit And Went To A New Page
+    for( int pass = 0; pass < 2; pass++ ) {
+        if( ( NULL == priv->page ) && !track_log_page_open( priv ) ) {
+            priv->drop_cnt++;
+            break;
+        }
+
+        // Steady Motion At A Steady Rate Leaves Almost Nothing Past The Last Step
+        len = 1;
+        for( int i = 0; i < 4; i++ ) {
+            delta[i] = val[i] - priv->prev[i];
+            len += put_varint( &rec[len], delta[i] - priv->step[i] );
+        }
+        rec[0] = (uint8_t)( len - 1 );
+
+        if( ( priv->fill + len ) > TRACK_LOG_PAGE_SZ ) {
+            track_log_page_close( priv );
+            continue;
+        }
+
+        memcpy( &priv->page->data[priv->fill], rec, len );
+        priv->fill += len;
+        memcpy( priv->prev, val, sizeof( priv->prev ) );
+        if( priv->first ) {
+            priv->first = false;
+        }
+        else {
+            memcpy( priv->step, delta, sizeof( priv->step ) );
+        }
+        priv->record_cnt++;
+
+        if( TRACK_LOG_PAGE_SZ == priv->fill ) {
+            track_log_page_close( priv );
+        }
+        break;
+    }
+
+    xSemaphoreGive( priv->lock );
+}
+
+void track_log_flush( void )
+{
+    track_priv_t          * priv = &g_priv;
+
+    if( NULL == priv->lock ) {
+        return;
+    }
+
+    xSemaphoreTake( priv->lock, portMAX_DELAY );
+    if( NULL != priv->page ) {
+        track_log_page_close( priv );
+    }
+    xSemaphoreGive( priv->lock );
+}
+
+_Noreturn static void track_log_writer_task( void * params )
+{
+    track_priv_t          * priv = (track_priv_t *)params;
+    track_page_t          * page;
+    uint8_t                 idx;
+
+    while(true) {
+        xQueueReceive( priv->full_q, &idx, portMAX_DELAY );
+        page = &priv->pages[idx];
+
+        // Sector Is Reclaimed When Its First Page Goes Out
+        if( 0 == ( page->offset % SPI_FLASH_SEC_SIZE ) ) {
+            if( ESP_OK != esp_partition_erase_range( priv->part, page->offset, SPI_FLASH_SEC_SIZE ) ) {
+                priv->write_err_cnt++;
+            }
+        }
+
+        if( ESP_OK != esp_partition_write( priv->part, page->offset, page->data, TRACK_LOG_PAGE_SZ ) ) {
+            priv->write_err_cnt++;
+        }
+
+        xQueueSend( priv->free_q, &idx, 0 );
+    }
+}
+
+static bool track_log_page_open( track_priv_t * priv )
+{
+    uint8_t     idx;
+
+    // Writer Has Fallen Behind, Caller Drops The Fix
+    if( pdTRUE != xQueueReceive( priv->free_q, &idx, 0 ) ) {
+        return false;
+    }
+
+    priv->page          = &priv->pages[idx];
+    priv->page->offset  = priv->next_offset;
+    priv->fill          = 0;
+    memset( priv->page->data, LEN_PAD, sizeof( priv->page->data ) );
+
+    // New Sector, Header And Deltas From Zero
+    if( 0 == ( priv->page->offset % SPI_FLASH_SEC_SIZE ) ) {
+        uint32_t    hdr[2] = { TRACK_LOG_MAGIC, priv->seq++ };
+
+        memcpy( priv->page->data, hdr, sizeof( hdr ) );
+        priv->fill = SECTOR_HDR_SZ;
+        memset( priv->prev, 0, sizeof( priv->prev ) );
+        memset( priv->step, 0, sizeof( priv->step ) );
+        priv->first = true;
+    }
+
+    return true;
+}
+
+static void track_log_page_close( track_priv_t * priv )
+{
+    uint8_t     idx = (uint8_t)( priv->page - priv->pages );
+
+    // Always Room, The Queue Holds Every Page
+    xQueueSend( priv->full_q, &idx, 0 );
+
+    priv->page          = NULL;
+    priv->next_offset   = ( priv->next_offset + TRACK_LOG_PAGE_SZ ) % priv->part->size;
+}
+
+static uint32_t track_log_recover( track_priv_t * priv )
+{
+    uint32_t    sector_cnt = priv->part->size / SPI_FLASH_SEC_SIZE;
+    uint32_t    first_seq;
+    uint32_t    seq;
+    uint32_t    lo = 0;
+    uint32_t    hi = sector_cnt - 1;
+
+    // Same Shape As The Odometer Log, Newest Sector Is The Last Not Below Sector 0
+    if( !track_log_sector_seq( priv, 0, &first_seq ) ) {
+        if( !track_log_sector_seq( priv, sector_cnt - 1, &seq ) ) {
+            priv->seq = 0;
+            return 0;
+        }
+
+        lo = sector_cnt - 1;
+    }
+    else {
+        while( lo < hi ) {
+            uint32_t    mid = ( lo + hi + 1 ) / 2;
+
+            if( track_log_sector_seq( priv, mid, &seq ) && ( seq >= first_seq ) ) {
+                lo = mid;
+            }
+            else {
+                hi = mid - 1;
+            }
+        }
+    }
+
+    track_log_sector_seq( priv, lo, &seq );
+    priv->seq = seq + 1;
+
+    ESP_LOGI(TAG, "Newest Sector %u (Seq %u)", lo, seq);
+
+    return ( ( lo + 1 ) % sector_cnt ) * SPI_FLASH_SEC_SIZE;
+}
+
+static bool track_log_sector_seq( track_priv_t * priv, uint32_t sector, uint32_t * seq )
+{
+    uint32_t    hdr[2];
+
+    if( ESP_OK != esp_partition_read( priv->part, sector * SPI_FLASH_SEC_SIZE, hdr, sizeof( hdr ) ) ) {
+        return false;
+    }
+
+    *seq = hdr[1];
+    return ( TRACK_LOG_MAGIC == hdr[0] );
+}
+
+static size_t put_varint( uint8_t * buf, int64_t val )
+{
+    // Zigzag, Small Magnitudes Of Either Sign Stay Short
+    uint64_t    zz = ( (uint64_t)val << 1 ) ^ (uint64_t)( val >> 63 );
+    size_t      len = 0;
+
+    while( zz >= 0x80 ) {
+        buf[len++] = (uint8_t)( zz | 0x80 );
+        zz >>= 7;
+    }
+    buf[len++] = (uint8_t)zz;
+
+    return len;
+}
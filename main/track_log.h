@@ -0,0 +1,65 @@
+#ifndef DASH_TRACK_LOG_H
+#define DASH_TRACK_LOG_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "gps.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/*
+ * Flash layout, decoded by tools/track2gpx.py:
+ *
+ *  Every 4 KiB sector of the "track" partition stands alone. It starts with
+ *  TRACK_LOG_MAGIC and a sequence number (both little endian u32), followed
+ *  by records. A record is a length byte and then four zigzag varints: time
+ *  (1/100 s since the epoch), latitude and longitude (1e-7 deg) and ground
+ *  speed (cm/s). Each is how much the step from the previous record differs
+ *  from the step before that, so a value is prev + step + varint and step
+ *  becomes value - prev. The first record of a sector starts from zero with
+ *  a zero step, and leaves the step at zero. Records never cross a
+ *  TRACK_LOG_PAGE_SZ page, 0xFF where a length byte would be means skip to
+ *  the next page.
+ *
+ *  At 10 Hz a record is mostly 5 bytes, so the 640 KiB partition holds
+ *  about three and a half hours before the log wraps and the oldest sector
+ *  is erased for new fixes.
+ */
+#define TRACK_LOG_MAGIC         (0x324B5254)    // "TRK2"
+#define TRACK_LOG_PAGE_SZ       (256)
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/**********************
+ *      MACROS
+ **********************/
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+bool track_log_init( void );
+
+// Never blocks, a fix that finds no free page is counted and dropped
+void track_log_append( const gps_fix_t * fix );
+
+// Push out the partly filled page
+void track_log_flush( void );
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif //DASH_TRACK_LOG_H
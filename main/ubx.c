@@ -0,0 +1,301 @@
+/*********************
+ *      INCLUDES
+ *********************/
+#include <string.h>
+
+#include "ubx.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+
+// NAV-PVT 'valid' Bits
+#define PVT_VALID_DATE          (0x01)
+#define PVT_VALID_TIME          (0x02)
+
+// NAV-PVT 'fixType' Values
+#define PVT_FIX_2D              (2)
+#define PVT_FIX_3D              (3)
+#define PVT_FIX_GNSS_DR         (4)
+
+// NAV-PVT 'flags' Bits
+#define PVT_FLAGS_FIX_OK        (0x01)
+
+// MGA-INI Message Types
+#define MGA_INI_POS_LLH         (0x01)
+#define MGA_INI_TIME_UTC        (0x10)
+#define MGA_INI_LEAP_UNKNOWN    (0x80)  // -128, Receiver Uses Its Own Leap Second Count
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/**********************
+ *      MACROS
+ **********************/
+#define get_u1( _p, _off )      ( (uint8_t)( _p )[_off] )
+#define get_u2( _p, _off )      ( (uint16_t)( ( _p )[_off] | ( ( _p )[( _off ) + 1] << 8 ) ) )
+#define get_u4( _p, _off )      ( (uint32_t)( _p )[_off] | ( (uint32_t)( _p )[( _off ) + 1] << 8 ) | \
+                                  ( (uint32_t)( _p )[( _off ) + 2] << 16 ) | ( (uint32_t)( _p )[( _off ) + 3] << 24 ) )
+#define get_i4( _p, _off )      ( (int32_t)get_u4( _p, _off ) )
+
+#define put_u2( _p, _off, _v )  do { ( _p )[_off] = (uint8_t)( _v ); ( _p )[( _off ) + 1] = (uint8_t)( ( _v ) >> 8 ); } while( 0 )
+#define put_u4( _p, _off, _v )  do { put_u2( _p, _off, (uint32_t)( _v ) ); put_u2( _p, ( _off ) + 2, (uint32_t)( _v ) >> 16 ); } while( 0 )
+
+/**********************
+ *     GLOBALS
+ **********************/
+
+/**********************
+ *     CONSTANTS
+ **********************/
+
+/**********************
+ *    PROTOTYPES
+ **********************/
+void ubx_parser_init( ubx_parser_t * parser, ubx_frame_cb_t frame_cb, void * ctx )
+{
+    memset( parser, 0, sizeof( *parser ) );
+
+    parser->frame_cb    = frame_cb;
+    parser->ctx         = ctx;
+
+    ubx_parser_reset( parser );
+}
+
+void ubx_parser_reset( ubx_parser_t * parser )
+{
+    parser->state = UBX_STATE_SYNC_1;
+}
+
+void ubx_parser_feed( ubx_parser_t * parser, const uint8_t * data, size_t len )
+{
+    const uint8_t         * end = data + len;
+
+    while( data < end ) {
+        uint8_t     ch = *data++;
+
+        switch( parser->state ) {
+            case UBX_STATE_SYNC_1:
+                if( UBX_SYNC_1 == ch ) {
+                    parser->state = UBX_STATE_SYNC_2;
+                }
+            break;
+
+            case UBX_STATE_SYNC_2:
+                if( UBX_SYNC_2 == ch ) {
+                    parser->idx     = 0;
+                    parser->ck_a    = 0;
+                    parser->ck_b    = 0;
+                    parser->state   = UBX_STATE_HDR;
+                }
+                else if( UBX_SYNC_1 != ch ) {
+                    parser->state = UBX_STATE_SYNC_1;
+                }
+            break;
+
+            case UBX_STATE_HDR:
+                // Fletcher-8 Runs Over Class, ID, Length And Payload
+                parser->hdr[parser->idx++] = ch;
+                parser->ck_a += ch;
+                parser->ck_b += parser->ck_a;
+
+                if( sizeof( parser->hdr ) == parser->idx ) {
+                    parser->len = get_u2( parser->hdr, 2 );
+                    parser->idx = 0;
+
+                    if( parser->len > UBX_PAYLOAD_MAX_SZ ) {
+                        parser->oversize_cnt++;
+                        parser->state = UBX_STATE_SYNC_1;
+                    }
+                    else {
+                        parser->state = ( 0 == parser->len ) ? UBX_STATE_CKSUM : UBX_STATE_PAYLOAD;
+                    }
+                }
+            break;
+
+            case UBX_STATE_PAYLOAD: {
+                // Take As Much Of The Payload As This Chunk Holds
+                size_t  cnt = parser->len - parser->idx;
+
+                data--;
+                if( cnt > (size_t)( end - data ) ) {
+                    cnt = end - data;
+                }
+
+                for( size_t i = 0; i < cnt; i++ ) {
+                    parser->ck_a += data[i];
+                    parser->ck_b += parser->ck_a;
+                }
+
+                memcpy( &parser->payload[parser->idx], data, cnt );
+                parser->idx += cnt;
+                data += cnt;
+
+                if( parser->idx == parser->len ) {
+                    parser->state = UBX_STATE_CKSUM;
+                }
+            }
+            break;
+
+            case UBX_STATE_CKSUM:
+                parser->payload[parser->idx++] = ch;
+
+                if( ( parser->len + UBX_CKSUM_SZ ) == parser->idx ) {
+                    parser->state = UBX_STATE_SYNC_1;
+
+                    if( ( parser->payload[parser->len] != parser->ck_a ) ||
+                        ( parser->payload[parser->len + 1] != parser->ck_b ) ) {
+                        parser->cksum_err_cnt++;
+                        break;
+                    }
+
+                    parser->frame_cnt++;
+                    parser->frame_cb( parser->ctx, parser->hdr[0], parser->hdr[1], parser->payload, parser->len );
+                }
+            break;
+        }
+    }
+}
+
+size_t ubx_frame_build
+    (
+    uint8_t               * buf,
+    size_t                  buf_sz,
+    uint8_t                 cls,
+    uint8_t                 id,
+    const uint8_t         * payload,
+    uint16_t                len
+    )
+{
+    uint8_t     ck_a = 0;
+    uint8_t     ck_b = 0;
+
+    if( buf_sz < (size_t)( UBX_HDR_SZ + len + UBX_CKSUM_SZ ) ) {
+        return 0;
+    }
+
+    buf[0] = UBX_SYNC_1;
+    buf[1] = UBX_SYNC_2;
+    buf[2] = cls;
+    buf[3] = id;
+    buf[4] = (uint8_t)( len & 0xFF );
+    buf[5] = (uint8_t)( len >> 8 );
+    // Polls Have No Payload And May Pass NULL
+    if( len > 0 ) {
+        memcpy( &buf[UBX_HDR_SZ], payload, len );
+    }
+
+    for( size_t i = 2; i < (size_t)( UBX_HDR_SZ + len ); i++ ) {
+        ck_a += buf[i];
+        ck_b += ck_a;
+    }
+
+    buf[UBX_HDR_SZ + len]       = ck_a;
+    buf[UBX_HDR_SZ + len + 1]   = ck_b;
+
+    return UBX_HDR_SZ + len + UBX_CKSUM_SZ;
+}
+
+bool ubx_nav_pvt_decode( const uint8_t * payload, uint16_t len, gps_fix_t * fix )
+{
+    uint8_t     valid;
+    uint8_t     flags;
+
+    if( len < UBX_NAV_PVT_SZ ) {
+        return false;
+    }
+
+    valid = get_u1( payload, 11 );
+    flags = get_u1( payload, 21 );
+
+    fix->time       = gps_utc_to_epoch( get_u2( payload, 4 ), get_u1( payload, 6 ), get_u1( payload, 7 ),
+                                        get_u1( payload, 8 ), get_u1( payload, 9 ), get_u1( payload, 10 ) );
+    fix->nano       = get_i4( payload, 16 );
+    fix->lon        = get_i4( payload, 24 );
+    fix->lat        = get_i4( payload, 28 );
+    fix->speed      = get_i4( payload, 60 );
+    fix->heading    = get_i4( payload, 64 );
+    fix->alt        = get_i4( payload, 36 );
+    fix->fix_type   = get_u1( payload, 20 );
+    fix->num_sats   = get_u1( payload, 23 );
+    fix->pdop       = get_u2( payload, 76 );    // Already 0.01 Units
+
+    fix->flags      = 0;
+    if( ( valid & ( PVT_VALID_DATE | PVT_VALID_TIME ) ) == ( PVT_VALID_DATE | PVT_VALID_TIME ) ) {
+        fix->flags |= GPS_FIX_FLAG_TIME_VALID;
+    }
+    if( flags & PVT_FLAGS_FIX_OK ) {
+        fix->flags |= GPS_FIX_FLAG_FIX_OK;
+    }
+
+    return true;
+}
+
+void ubx_fix_status( const gps_fix_t * fix, gps_fix_status_t * status )
+{
+    memset( status, 0, sizeof( *status ) );
+
+    // NAV-PVT Has No Per-Satellite List Or HDOP, Those Stay Zero
+    status->quality         = ( fix->flags & GPS_FIX_FLAG_FIX_OK ) ? 1 : 0;
+    status->sats_tracked    = fix->num_sats;
+    status->sats_used       = fix->num_sats;
+    status->pdop            = fix->pdop;
+    status->t_us            = fix->t_us;
+
+    switch( fix->fix_type ) {
+        case PVT_FIX_2D:
+            status->fix_type = GPS_FIX_TYPE_2D;
+        break;
+
+        case PVT_FIX_3D:
+        case PVT_FIX_GNSS_DR:
+            status->fix_type = GPS_FIX_TYPE_3D;
+        break;
+
+        default:
+            // Dead Reckoning Or Time Only Is No Position Fix
+            status->fix_type = GPS_FIX_TYPE_NONE;
+        break;
+    }
+}
+
+void ubx_mga_ini_pos_llh( uint8_t * payload, int32_t lat, int32_t lon, int32_t alt, uint32_t acc_cm )
+{
+    memset( payload, 0, UBX_MGA_INI_POS_LLH_SZ );
+
+    payload[0] = MGA_INI_POS_LLH;
+    put_u4( payload, 4, lat );
+    put_u4( payload, 8, lon );
+    put_u4( payload, 12, alt / 10 );        // cm
+    put_u4( payload, 16, acc_cm );
+}
+
+void ubx_mga_ini_time_utc( uint8_t * payload, uint32_t utc, uint16_t acc_s )
+{
+    uint32_t    days = utc / 86400u;
+    uint32_t    secs = utc % 86400u;
+    uint32_t    z = days + 719468;
+    uint32_t    era = z / 146097;
+    uint32_t    doe = z - era * 146097;
+    uint32_t    yoe = ( doe - doe / 1460 + doe / 36524 - doe / 146096 ) / 365;
+    uint32_t    doy = doe - ( 365 * yoe + yoe / 4 - yoe / 100 );
+    uint32_t    mp = ( 5 * doy + 2 ) / 153;
+    uint32_t    day = doy - ( 153 * mp + 2 ) / 5 + 1;
+    uint32_t    month = ( mp < 10 ) ? mp + 3 : mp - 9;
+    uint32_t    year = yoe + era * 400 + ( month <= 2 );
+
+    memset( payload, 0, UBX_MGA_INI_TIME_UTC_SZ );
+
+    // Civil From Days, The Inverse Of gps_utc_to_epoch()
+    payload[0]  = MGA_INI_TIME_UTC;
+    payload[2]  = 0;                        // No External Time Mark
+    payload[3]  = MGA_INI_LEAP_UNKNOWN;
+    put_u2( payload, 4, year );
+    payload[6]  = (uint8_t)month;
+    payload[7]  = (uint8_t)day;
+    payload[8]  = (uint8_t)( secs / 3600 );
+    payload[9]  = (uint8_t)( secs / 60 % 60 );
+    payload[10] = (uint8_t)( secs % 60 );
+    put_u2( payload, 16, acc_s );
+}
@@ -0,0 +1,113 @@
+#ifndef DASH_UBX_H
+#define DASH_UBX_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "gps.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+#define UBX_SYNC_1              (0xB5)
+#define UBX_SYNC_2              (0x62)
+
+#define UBX_HDR_SZ              (6)     // Sync, Class, ID, Length
+#define UBX_CKSUM_SZ            (2)
+#define UBX_PAYLOAD_MAX_SZ      (256)   // Fits MGA-DBD Entries
+
+#define UBX_CLASS_NAV           (0x01)
+#define UBX_NAV_PVT             (0x07)
+#define UBX_NAV_PVT_SZ          (92)
+
+#define UBX_CLASS_CFG           (0x06)
+#define UBX_CFG_PRT             (0x00)
+#define UBX_CFG_MSG             (0x01)
+#define UBX_CFG_RATE            (0x08)
+
+#define UBX_CLASS_MGA           (0x13)
+#define UBX_MGA_INI             (0x40)
+#define UBX_MGA_INI_POS_LLH_SZ  (20)
+#define UBX_MGA_INI_TIME_UTC_SZ (24)
+#define UBX_MGA_DBD             (0x80)  // Empty Payload Polls The Navigation Database
+
+#define UBX_CLASS_NMEA          (0xF0)  // Standard NMEA Outputs, For CFG-MSG
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+// Called with every checksum-valid frame
+typedef void (*ubx_frame_cb_t)( void * ctx, uint8_t cls, uint8_t id, const uint8_t * payload, uint16_t len );
+
+typedef enum
+    {
+    UBX_STATE_SYNC_1,
+    UBX_STATE_SYNC_2,
+    UBX_STATE_HDR,
+    UBX_STATE_PAYLOAD,
+    UBX_STATE_CKSUM
+    } ubx_state_t;
+
+typedef struct
+    {
+    ubx_frame_cb_t          frame_cb;
+    void                  * ctx;
+
+    // Frame Being Received
+    ubx_state_t             state;
+    uint8_t                 hdr[4];         // Class, ID, Length
+    uint16_t                len;
+    uint16_t                idx;
+    uint8_t                 ck_a;
+    uint8_t                 ck_b;
+    uint8_t                 payload[UBX_PAYLOAD_MAX_SZ + UBX_CKSUM_SZ];
+
+    // Statistics
+    uint32_t                frame_cnt;
+    uint32_t                cksum_err_cnt;
+    uint32_t                oversize_cnt;
+    } ubx_parser_t;
+
+/**********************
+ *      MACROS
+ **********************/
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+void ubx_parser_init( ubx_parser_t * parser, ubx_frame_cb_t frame_cb, void * ctx );
+void ubx_parser_reset( ubx_parser_t * parser );
+void ubx_parser_feed( ubx_parser_t * parser, const uint8_t * data, size_t len );
+
+size_t ubx_frame_build
+    (
+    uint8_t               * buf,
+    size_t                  buf_sz,
+    uint8_t                 cls,
+    uint8_t                 id,
+    const uint8_t         * payload,
+    uint16_t                len
+    );
+
+bool ubx_nav_pvt_decode( const uint8_t * payload, uint16_t len, gps_fix_t * fix );
+void ubx_fix_status( const gps_fix_t * fix, gps_fix_status_t * status );
+
+// MGA-INI Aiding Payloads, Position In 1e-7 deg / mm, Accuracies In cm And s
+void ubx_mga_ini_pos_llh( uint8_t * payload, int32_t lat, int32_t lon, int32_t alt, uint32_t acc_cm );
+void ubx_mga_ini_time_utc( uint8_t * payload, uint32_t utc, uint16_t acc_s );
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif //DASH_UBX_H
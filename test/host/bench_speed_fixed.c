@@ -0,0 +1,163 @@
+/*
+ * VTG speed to speedometer centidegrees, the way it went before gps.speed
+ * turned fixed point and the way it goes now:
+ *
+ *   double  minmea_tofloat(), published with PUB_DBL, divided down to mph
+ *           and degrees, then stepper_gauge_set_degree()
+ *   float   The same in single precision
+ *   fixed   minmea_rescale() to km/h * GPS_SPEED_SCALE, one Q16 multiply
+ *
+ * Checks the fixed path stays within a centidegree of the exact mapping and
+ * prints ns per conversion. The ESP32 FPU is single precision only, double
+ * goes through libgcc soft-float there, so the host gap understates it.
+ *
+ *   bench_speed_fixed [passes]
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include <minmea/minmea.h>
+
+#include "gps.h"
+#include "host_util.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+#define SAMPLE_CNT              (4096)
+#define SPEED_KPH_MAX           (200)
+
+// Same As speedometer_gauge.c
+#define SPEED_MPH_MAX           80
+#define SPEED_DEG_MAX           87
+#define KPH_PER_MPH_NUM         1609344LL
+#define KPH_PER_MPH_DEN         1000000LL
+#define SPEED_TO_CDEG_Q16       (int32_t)( ( SPEED_DEG_MAX * 100LL * 65536 * KPH_PER_MPH_DEN ) / \
+                                           ( SPEED_MPH_MAX * GPS_SPEED_SCALE * KPH_PER_MPH_NUM ) )
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+typedef int32_t (*convert_t)( const struct minmea_float * speed_kph );
+
+/**********************
+ *      MACROS
+ **********************/
+#define speed_to_centideg( _spd )   (int32_t)( ( (int64_t)( _spd ) * SPEED_TO_CDEG_Q16 + 32768 ) >> 16 )
+
+/**********************
+ *    PROTOTYPES
+ **********************/
+static int32_t convert_double( const struct minmea_float * speed_kph );
+static int32_t convert_float( const struct minmea_float * speed_kph );
+static int32_t convert_fixed( const struct minmea_float * speed_kph );
+static int32_t worst_error( convert_t convert );
+static double bench( convert_t convert, uint32_t passes );
+
+/**********************
+ *     GLOBALS
+ **********************/
+static struct minmea_float  g_speeds[SAMPLE_CNT];
+static volatile int32_t     g_sink;
+
+/**********************
+ *     CONSTANTS
+ **********************/
+
+int main( int argc, char * argv[] )
+{
+    const uint32_t          passes = ( argc > 1 ) ? (uint32_t)strtoul( argv[1], NULL, 0 ) : 200;
+    static const int32_t    scales[] = { 1, 10, 100, 1000 };
+    int32_t                 err_double;
+    int32_t                 err_float;
+    int32_t                 err_fixed;
+    double                  ns_double;
+    double                  ns_float;
+    double                  ns_fixed;
+
+    host_rand_seed( 0x5bd );
+
+    // Receivers Print Anything From Whole km/h To Three Decimals
+    for( size_t i = 0; i < SAMPLE_CNT; i++ ) {
+        g_speeds[i].scale = scales[host_rand() % 4];
+        g_speeds[i].value = (int32_t)( host_rand() % ( SPEED_KPH_MAX * g_speeds[i].scale + 1 ) );
+    }
+
+    // Exact Mapping, Rounded, Against What The Needle Is Actually Given
+    err_double  = worst_error( convert_double );
+    err_float   = worst_error( convert_float );
+    err_fixed   = worst_error( convert_fixed );
+    HOST_CHECK( err_fixed <= 1 );
+
+    ns_double   = bench( convert_double, passes );
+    ns_float    = bench( convert_float, passes );
+    ns_fixed    = bench( convert_fixed, passes );
+
+    printf( "0-%d km/h, %d samples, worst error in centidegrees and time per conversion:\n", SPEED_KPH_MAX, SAMPLE_CNT );
+    printf( "  double %d  %6.2f ns\n", err_double, ns_double );
+    printf( "  float  %d  %6.2f ns\n", err_float, ns_float );
+    printf( "  fixed  %d  %6.2f ns\n", err_fixed, ns_fixed );
+
+    return host_check_result( "bench_speed_fixed" );
+}
+
+__attribute__((noinline)) static int32_t convert_double( const struct minmea_float * speed_kph )
+{
+    const double            kph = minmea_tofloat( speed_kph );
+    const double            mph = kph / 1.609344;
+    const float             degree = (float)( ( mph * SPEED_DEG_MAX ) / SPEED_MPH_MAX );
+
+    return (int32_t)( degree * 100 );
+}
+
+__attribute__((noinline)) static int32_t convert_float( const struct minmea_float * speed_kph )
+{
+    const float             kph = minmea_tofloat( speed_kph );
+    const float             mph = kph / 1.609344f;
+    const float             degree = ( mph * SPEED_DEG_MAX ) / SPEED_MPH_MAX;
+
+    return (int32_t)( degree * 100 );
+}
+
+__attribute__((noinline)) static int32_t convert_fixed( const struct minmea_float * speed_kph )
+{
+    return speed_to_centideg( minmea_rescale( speed_kph, GPS_SPEED_SCALE ) );
+}
+
+static int32_t worst_error( convert_t convert )
+{
+    int32_t                 err_max = 0;
+
+    for( size_t i = 0; i < SAMPLE_CNT; i++ ) {
+        const long double   kph = (long double)g_speeds[i].value / g_speeds[i].scale;
+        const int32_t       exact = (int32_t)lroundl( kph * KPH_PER_MPH_DEN / KPH_PER_MPH_NUM * SPEED_DEG_MAX * 100 / SPEED_MPH_MAX );
+        const int32_t       err = abs( convert( &g_speeds[i] ) - exact );
+
+        if( err > err_max ) {
+            err_max = err;
+        }
+    }
+
+    return err_max;
+}
+
+static double bench( convert_t convert, uint32_t passes )
+{
+    int64_t                 start_ns;
+    int32_t                 sum = 0;
+
+    start_ns = host_now_ns();
+    for( uint32_t pass = 0; pass < passes; pass++ ) {
+        for( size_t i = 0; i < SAMPLE_CNT; i++ ) {
+            sum += convert( &g_speeds[i] );
+        }
+    }
+    g_sink = sum;
+
+    return (double)( host_now_ns() - start_ns ) / ( (double)passes * SAMPLE_CNT );
+}
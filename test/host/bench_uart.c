@@ -0,0 +1,256 @@
+/*
+ * Reads a capture out of a fake UART driver both ways gps.c has done it:
+ *
+ *   byte    One uart_read_bytes() per byte, hunting for '$' and collecting
+ *           up to '\n', then copying the line out under a mutex (the
+ *           original gps_read_task).
+ *   bulk    One read per line feed as the pattern interrupt reports them,
+ *           in RX_CHUNK_SZ chunks straight into nmea_framer.
+ *
+ *   bench_uart [-r repeat] capture.nmea
+ *
+ * Every fake driver read takes a mutex and copies out of the RX buffer,
+ * standing in for the driver's ring buffer and its lock. Numbers are host
+ * CPU time, only the ratio carries over to the ESP32.
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "nmea_framer.h"
+#include "host_util.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+#define GPS_SENTENCE_MAX_SZ     (128)   // Same As gps.c
+#define RX_CHUNK_SZ             (128)
+#define LINK_BAUD               (115200)
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+typedef struct
+    {
+    pthread_mutex_t         lock;
+    const uint8_t         * data;
+    size_t                  len;
+    size_t                  pos;
+    uint32_t                read_cnt;
+    } fake_uart_t;
+
+typedef struct
+    {
+    const char            * name;
+    uint32_t                sentence_cnt;
+    uint32_t                read_cnt;
+    int64_t                 elapsed_ns;
+    } bench_result_t;
+
+/**********************
+ *      MACROS
+ **********************/
+
+/**********************
+ *    PROTOTYPES
+ **********************/
+static int fake_uart_read_bytes( fake_uart_t * uart, uint8_t * buf, size_t len );
+static void bench_byte( fake_uart_t * uart, bench_result_t * result );
+static void bench_bulk( fake_uart_t * uart, bench_result_t * result );
+static char * bench_bulk_emit( void * ctx, char * sentence, size_t len );
+static void bench_print( const bench_result_t * result, size_t bytes );
+
+/**********************
+ *     GLOBALS
+ **********************/
+// Where The Original Reader Handed Lines To The Parser
+static pthread_mutex_t      g_sentence_lock = PTHREAD_MUTEX_INITIALIZER;
+static char                 g_sentence[GPS_SENTENCE_MAX_SZ + 1];
+static volatile uint32_t    g_sentence_trigger;
+
+/**********************
+ *     CONSTANTS
+ **********************/
+
+int main( int argc, char * argv[] )
+{
+    fake_uart_t             uart;
+    bench_result_t          byte = { .name = "byte" };
+    bench_result_t          bulk = { .name = "bulk" };
+    uint8_t               * data;
+    size_t                  len;
+    uint32_t                repeat = 1;
+    int                     opt;
+
+    while( -1 != ( opt = getopt( argc, argv, "r:" ) ) ) {
+        if( 'r' == opt ) {
+            repeat = (uint32_t)strtoul( optarg, NULL, 0 );
+        }
+        else {
+            fprintf( stderr, "usage: %s [-r repeat] capture.nmea\n", argv[0] );
+            return EXIT_FAILURE;
+        }
+    }
+
+    if( optind >= argc ) {
+        fprintf( stderr, "usage: %s [-r repeat] capture.nmea\n", argv[0] );
+        return EXIT_FAILURE;
+    }
+
+    data = host_load_file( argv[optind], &len );
+    if( NULL == data ) {
+        fprintf( stderr, "%s: cannot read %s\n", argv[0], argv[optind] );
+        return EXIT_FAILURE;
+    }
+
+    pthread_mutex_init( &uart.lock, NULL );
+    uart.data   = data;
+    uart.len    = len;
+
+    for( uint32_t r = 0; r < repeat; r++ ) {
+        bench_byte( &uart, &byte );
+        bench_bulk( &uart, &bulk );
+    }
+
+    printf( "%zu bytes x %u through a fake UART\n", len, repeat );
+    bench_print( &byte, len * repeat );
+    bench_print( &bulk, len * repeat );
+    printf( "bulk is %.1fx faster per sentence\n",
+            ( (double)byte.elapsed_ns / byte.sentence_cnt ) / ( (double)bulk.elapsed_ns / bulk.sentence_cnt ) );
+
+    pthread_mutex_destroy( &uart.lock );
+    free( data );
+
+    // Byte Reader Passes Lines With Bad Checksums On, The Framer Does Not
+    return ( ( 0 != bulk.sentence_cnt ) && ( bulk.sentence_cnt <= byte.sentence_cnt ) ) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static int fake_uart_read_bytes( fake_uart_t * uart, uint8_t * buf, size_t len )
+{
+    size_t                  rd_len;
+
+    pthread_mutex_lock( &uart->lock );
+
+    rd_len = uart->len - uart->pos;
+    if( rd_len > len ) {
+        rd_len = len;
+    }
+    memcpy( buf, &uart->data[uart->pos], rd_len );
+    uart->pos += rd_len;
+    uart->read_cnt++;
+
+    pthread_mutex_unlock( &uart->lock );
+
+    return (int)rd_len;
+}
+
+static void bench_byte( fake_uart_t * uart, bench_result_t * result )
+{
+    char                    sentence[GPS_SENTENCE_MAX_SZ + 1];
+    int                     idx;
+    char                    ch;
+    int64_t                 start_ns;
+
+    uart->pos       = 0;
+    uart->read_cnt  = 0;
+    start_ns        = host_now_ns();
+
+    for(;;) {
+        idx = 0;
+
+        // Hunt For '$', One Driver Call Per Byte
+        while( 1 == fake_uart_read_bytes( uart, (uint8_t *)&ch, 1 ) ) {
+            if( '$' == ch ) {
+                sentence[idx++] = ch;
+                break;
+            }
+        }
+        if( 0 == idx ) {
+            break;
+        }
+
+        // Collect Up To '\n'
+        while( 1 == fake_uart_read_bytes( uart, (uint8_t *)&ch, 1 ) ) {
+            if( idx < GPS_SENTENCE_MAX_SZ ) {
+                sentence[idx++] = ch;
+            }
+            if( '\n' == ch ) {
+                break;
+            }
+        }
+        sentence[idx] = '\0';
+
+        pthread_mutex_lock( &g_sentence_lock );
+        strncpy( g_sentence, sentence, sizeof( g_sentence ) );
+        pthread_mutex_unlock( &g_sentence_lock );
+        g_sentence_trigger++;
+
+        result->sentence_cnt++;
+    }
+
+    result->elapsed_ns  += host_now_ns() - start_ns;
+    result->read_cnt    += uart->read_cnt;
+}
+
+static void bench_bulk( fake_uart_t * uart, bench_result_t * result )
+{
+    nmea_framer_t           framer;
+    char                    sentence[GPS_SENTENCE_MAX_SZ];
+    uint8_t                 chunk[RX_CHUNK_SZ];
+    const uint8_t         * lf;
+    size_t                  pos = 0;
+    int                     len;
+    int                     rd_len;
+    int64_t                 start_ns;
+
+    uart->pos       = 0;
+    uart->read_cnt  = 0;
+    nmea_framer_init( &framer, sentence, sizeof( sentence ), bench_bulk_emit, NULL );
+    start_ns        = host_now_ns();
+
+    while( pos < uart->len ) {
+        // Pattern Queue Position, Found By The UART Hardware On The Target
+        lf  = memchr( &uart->data[pos], '\n', uart->len - pos );
+        len = ( NULL != lf ) ? (int)( lf - &uart->data[pos] + 1 ) : (int)( uart->len - pos );
+        pos += (size_t)len;
+
+        while( len > 0 ) {
+            rd_len = fake_uart_read_bytes( uart, chunk, ( len < RX_CHUNK_SZ ) ? (size_t)len : RX_CHUNK_SZ );
+            if( rd_len <= 0 ) {
+                break;
+            }
+            nmea_framer_feed( &framer, chunk, (size_t)rd_len );
+            len -= rd_len;
+        }
+    }
+
+    result->elapsed_ns      += host_now_ns() - start_ns;
+    result->read_cnt        += uart->read_cnt;
+    result->sentence_cnt    += framer.sentence_cnt;
+}
+
+static char * bench_bulk_emit( void * ctx, char * sentence, size_t len )
+{
+    g_sentence_trigger++;
+    return sentence;
+}
+
+static void bench_print( const bench_result_t * result, size_t bytes )
+{
+    const double            elapsed_s = (double)result->elapsed_ns / 1e9;
+    const double            ns_per_sentence = (double)result->elapsed_ns / result->sentence_cnt;
+    const double            sentences_per_s = (double)result->sentence_cnt / elapsed_s;
+
+    // Share Of One Core Needed To Keep Up With A Saturated Link
+    const double            link_load = ( (double)LINK_BAUD / 10 ) / ( (double)bytes / elapsed_s );
+
+    printf( "%-5s %8.2f MB/s  %9.0f sentences/s  %6.0f ns/sentence  %5.1f reads/sentence  %.3f%% CPU at %u baud\n",
+            result->name, bytes / elapsed_s / 1e6, sentences_per_s, ns_per_sentence,
+            (double)result->read_cnt / result->sentence_cnt, 100.0 * link_load, LINK_BAUD );
+}
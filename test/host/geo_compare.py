@@ -0,0 +1,123 @@
+#!/usr/bin/env python3
+"""
+Check geo_index_lookup() against the reference lookup in tools/geo_build.py.
+
+    test/host/geo_compare.py build-host/geo_lookup [dataset.json]
+
+Builds the image from the dataset (tools/geo_sample.json by default), then
+asks both for random positions over the whole grid, positions close to
+every road and positions on and around every fence. Fences must agree
+exactly, the ray cast is integer on both sides. The C side measures in
+single precision, so roads may differ only where two candidates (or a
+candidate and match_m) are within TIE_M of each other, and dist_m by 1.
+"""
+import os
+import random
+import struct
+import subprocess
+import sys
+import tempfile
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "..", "tools"))
+import geo_build  # noqa: E402
+
+RANDOM_CNT = 20000
+PER_SEG_CNT = 200
+TIE_M = 0.05
+
+
+def seg_dist(image, seg, lat, lon):
+    """Distance in metres from a position to one segment, as lookup() measures it."""
+    hdr = struct.unpack_from(geo_build.HDR_FMT, image)
+    segs_off = hdr[15]
+    la0, lo0, la1, lo1, _, _ = struct.unpack_from(geo_build.SEG_FMT, image,
+                                                  segs_off + struct.calcsize(geo_build.SEG_FMT) * seg)
+    m_per_lon = geo_build.M_PER_UNIT * geo_build.math.cos(geo_build.math.radians(lat * 1e-7))
+    ax, ay = (lo0 - lon) * m_per_lon, (la0 - lat) * geo_build.M_PER_UNIT
+    dx, dy = (lo1 - lo0) * m_per_lon, (la1 - la0) * geo_build.M_PER_UNIT
+    len2 = dx * dx + dy * dy
+    t = min(max(-(ax * dx + ay * dy) / len2, 0.0), 1.0) if len2 > 0 else 0.0
+    return geo_build.math.hypot(ax + t * dx, ay + t * dy)
+
+
+def positions(image, data, rng):
+    hdr = struct.unpack_from(geo_build.HDR_FMT, image)
+    lat0, lon0, cell_sz, rows, cols, match_m = hdr[5], hdr[6], hdr[7], hdr[8], hdr[9], hdr[10]
+    lat_span, lon_span = rows * cell_sz, cols * cell_sz
+
+    # Whole Grid And A Little Outside It
+    for _ in range(RANDOM_CNT):
+        yield (rng.randint(lat0 - lat_span // 10, lat0 + lat_span + lat_span // 10),
+               rng.randint(lon0 - lon_span // 10, lon0 + lon_span + lon_span // 10))
+
+    # Along Every Road, Out To Twice match_m Either Side
+    margin = int(2 * match_m / geo_build.M_PER_UNIT)
+    for la0, lo0, la1, lo1, _ in geo_build.road_segments(data.get("roads", [])):
+        for _ in range(PER_SEG_CNT):
+            t = rng.random()
+            yield (int(la0 + t * (la1 - la0)) + rng.randint(-margin, margin),
+                   int(lo0 + t * (lo1 - lo0)) + rng.randint(-margin, margin))
+
+    # Fence Corners, Edges And Their Neighbours
+    for _, pts in geo_build.fence_polygons(data.get("fences", [])):
+        for (la0, lo0), (la1, lo1) in zip(pts, pts[1:] + pts[:1]):
+            for k in range(9):
+                lat, lon = la0 + (la1 - la0) * k // 8, lo0 + (lo1 - lo0) * k // 8
+                for dlat in (-1, 0, 1):
+                    for dlon in (-1, 0, 1):
+                        yield lat + dlat, lon + dlon
+
+
+def main():
+    if len(sys.argv) < 2:
+        sys.exit(__doc__)
+    lookup_bin = sys.argv[1]
+    dataset = sys.argv[2] if len(sys.argv) > 2 else os.path.join(os.path.dirname(geo_build.__file__), "geo_sample.json")
+
+    with open(dataset) as f:
+        data = geo_build.json.load(f)
+    image = geo_build.build(data)
+    match_m = struct.unpack_from(geo_build.HDR_FMT, image)[10]
+    queries = list(positions(image, data, random.Random(0x6e0)))
+
+    with tempfile.NamedTemporaryFile(suffix=".bin") as f:
+        f.write(image)
+        f.flush()
+        out = subprocess.run([lookup_bin, f.name], input="".join("%d %d\n" % q for q in queries),
+                             capture_output=True, text=True, check=True)
+    sys.stderr.write(out.stderr)
+
+    answers = [tuple(int(v) for v in line.split()) for line in out.stdout.splitlines()]
+    if len(answers) != len(queries):
+        sys.exit("asked %d positions, got %d answers" % (len(queries), len(answers)))
+
+    fail = 0
+    tie = 0
+    hit = 0
+    for (lat, lon), got in zip(queries, answers):
+        want = geo_build.lookup(image, lat, lon)
+        hit += want[1] >= 0 or want[3] != 0
+        if got == want:
+            continue
+
+        ok = got[3] == want[3]
+        if ok and got[1] != want[1]:
+            # Different Road, Or Only One Side Found One, Must Be A Near Tie
+            d_got = seg_dist(image, got[1], lat, lon) if got[1] >= 0 else match_m
+            d_want = seg_dist(image, want[1], lat, lon) if want[1] >= 0 else match_m
+            ok = abs(d_got - d_want) < TIE_M
+            tie += ok
+        elif ok:
+            ok = got[0] == want[0] and abs(got[2] - want[2]) <= 1
+
+        if not ok:
+            fail += 1
+            if fail <= 10:
+                print("%d %d: C %s, python %s" % (lat, lon, got, want))
+
+    print("%d positions, %d on a road or in a fence, %d near ties, %d mismatches" % (len(queries), hit, tie, fail))
+    sys.exit(1 if fail else 0)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,83 @@
+/*
+ * Runs geo_index_lookup() over positions read from stdin, one "lat lon" in
+ * 1e-7 deg per line, and prints "speed_limit seg dist_m fence_id" for each.
+ * geo_compare.py feeds it and checks the answers against tools/geo_build.py.
+ *
+ *   geo_lookup geo.bin < positions.txt
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+
+#include "geo_index.h"
+#include "host_util.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/**********************
+ *      MACROS
+ **********************/
+
+/**********************
+ *    PROTOTYPES
+ **********************/
+
+/**********************
+ *     GLOBALS
+ **********************/
+
+/**********************
+ *     CONSTANTS
+ **********************/
+
+int main( int argc, char * argv[] )
+{
+    geo_index_t             idx;
+    geo_result_t            result;
+    uint8_t               * image;
+    size_t                  image_sz;
+    int32_t                 lat;
+    int32_t                 lon;
+    uint32_t                lookup_cnt = 0;
+    int64_t                 lookup_ns = 0;
+    int64_t                 start_ns;
+
+    if( argc < 2 ) {
+        fprintf( stderr, "usage: %s geo.bin < positions.txt\n", argv[0] );
+        return EXIT_FAILURE;
+    }
+
+    image = host_load_file( argv[1], &image_sz );
+    if( ( NULL == image ) || !geo_index_open( &idx, image, image_sz ) ) {
+        fprintf( stderr, "%s: %s is not a usable geo image\n", argv[0], argv[1] );
+        free( image );
+        return EXIT_FAILURE;
+    }
+
+    while( 2 == scanf( "%" SCNd32 " %" SCNd32, &lat, &lon ) ) {
+        start_ns = host_now_ns();
+        geo_index_lookup( &idx, lat, lon, &result );
+        lookup_ns += host_now_ns() - start_ns;
+        lookup_cnt++;
+
+        printf( "%u %" PRId32 " %u %u\n", result.speed_limit, result.seg, result.dist_m, result.fence_id );
+    }
+
+    if( 0 != lookup_cnt ) {
+        fprintf( stderr, "%u lookups, %.0f ns each\n", lookup_cnt, (double)lookup_ns / lookup_cnt );
+    }
+
+    free( image );
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,171 @@
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+
+#include "host_util.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/**********************
+ *      MACROS
+ **********************/
+
+/**********************
+ *    PROTOTYPES
+ **********************/
+static int host_samples_cmp( const void * a, const void * b );
+
+/**********************
+ *     GLOBALS
+ **********************/
+static uint32_t             g_rand_state = 1;
+static uint32_t             g_check_fail_cnt;
+
+/**********************
+ *     CONSTANTS
+ **********************/
+
+int64_t host_now_ns( void )
+{
+    struct timespec         ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+void host_sleep_until_ns( int64_t t_ns )
+{
+    struct timespec         ts;
+
+    ts.tv_sec   = (time_t)( t_ns / 1000000000 );
+    ts.tv_nsec  = (long)( t_ns % 1000000000 );
+    while( EINTR == clock_nanosleep( CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL ) ) {
+    }
+}
+
+uint8_t * host_load_file( const char * path, size_t * len )
+{
+    FILE                  * file;
+    uint8_t               * buf;
+    long                    sz;
+
+    file = fopen( path, "rb" );
+    if( NULL == file ) {
+        return NULL;
+    }
+
+    fseek( file, 0, SEEK_END );
+    sz = ftell( file );
+    fseek( file, 0, SEEK_SET );
+
+    buf = ( sz > 0 ) ? malloc( (size_t)sz ) : NULL;
+    if( ( NULL != buf ) && ( 1 != fread( buf, (size_t)sz, 1, file ) ) ) {
+        free( buf );
+        buf = NULL;
+    }
+    fclose( file );
+
+    *len = ( NULL != buf ) ? (size_t)sz : 0;
+    return buf;
+}
+
+void host_samples_init( host_samples_t * samples, size_t cap )
+{
+    samples->val    = malloc( cap * sizeof( samples->val[0] ) );
+    samples->cnt    = 0;
+    samples->cap    = ( NULL != samples->val ) ? cap : 0;
+}
+
+void host_samples_add( host_samples_t * samples, uint32_t val )
+{
+    // Past The Cap Overwrite A Random Sample, Percentiles Stay Representative
+    if( samples->cnt < samples->cap ) {
+        samples->val[samples->cnt++] = val;
+    }
+    else if( samples->cap > 0 ) {
+        samples->val[host_rand() % samples->cap] = val;
+    }
+}
+
+uint32_t host_samples_pct( host_samples_t * samples, uint32_t p )
+{
+    size_t                  idx;
+
+    if( 0 == samples->cnt ) {
+        return 0;
+    }
+
+    qsort( samples->val, samples->cnt, sizeof( samples->val[0] ), host_samples_cmp );
+
+    idx = (size_t)( ( (uint64_t)samples->cnt * p ) / 1000 );
+    if( idx >= samples->cnt ) {
+        idx = samples->cnt - 1;
+    }
+
+    return samples->val[idx];
+}
+
+void host_samples_print( host_samples_t * samples, const char * name, const char * units )
+{
+    printf( "%-22s p50 %7u  p90 %7u  p99 %7u  p99.9 %7u  max %7u %s (%zu samples)\n", name,
+            host_samples_pct( samples, 500 ), host_samples_pct( samples, 900 ),
+            host_samples_pct( samples, 990 ), host_samples_pct( samples, 999 ),
+            host_samples_pct( samples, 1000 ), units, samples->cnt );
+}
+
+void host_samples_free( host_samples_t * samples )
+{
+    free( samples->val );
+    memset( samples, 0, sizeof( *samples ) );
+}
+
+void host_rand_seed( uint32_t seed )
+{
+    g_rand_state = ( 0 != seed ) ? seed : 1;
+}
+
+uint32_t host_rand( void )
+{
+    // xorshift32
+    g_rand_state ^= g_rand_state << 13;
+    g_rand_state ^= g_rand_state >> 17;
+    g_rand_state ^= g_rand_state << 5;
+
+    return g_rand_state;
+}
+
+void host_check_fail( const char * file, int line, const char * cond )
+{
+    fprintf( stderr, "%s:%d: check failed: %s\n", file, line, cond );
+    g_check_fail_cnt++;
+}
+
+int host_check_result( const char * name )
+{
+    if( 0 != g_check_fail_cnt ) {
+        printf( "%s: %u check(s) failed\n", name, g_check_fail_cnt );
+        return EXIT_FAILURE;
+    }
+
+    printf( "%s: ok\n", name );
+    return EXIT_SUCCESS;
+}
+
+static int host_samples_cmp( const void * a, const void * b )
+{
+    const uint32_t          va = *(const uint32_t *)a;
+    const uint32_t          vb = *(const uint32_t *)b;
+
+    return ( va > vb ) - ( va < vb );
+}
@@ -0,0 +1,68 @@
+#ifndef DASH_HOST_UTIL_H
+#define DASH_HOST_UTIL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+// Samples Kept For Percentiles, Sorted In Place When Reported
+typedef struct
+    {
+    uint32_t              * val;
+    size_t                  cnt;
+    size_t                  cap;
+    } host_samples_t;
+
+/**********************
+ *      MACROS
+ **********************/
+#define HOST_CHECK( _cond )                                                         \
+    do {                                                                            \
+        if( !( _cond ) ) {                                                          \
+            host_check_fail( __FILE__, __LINE__, #_cond );                          \
+        }                                                                           \
+    } while( 0 )
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+int64_t host_now_ns( void );
+void host_sleep_until_ns( int64_t t_ns );
+
+// Whole File In One malloc() Buffer, NULL On Failure
+uint8_t * host_load_file( const char * path, size_t * len );
+
+void host_samples_init( host_samples_t * samples, size_t cap );
+void host_samples_add( host_samples_t * samples, uint32_t val );
+// p In Per Mille, 500 Is The Median
+uint32_t host_samples_pct( host_samples_t * samples, uint32_t p );
+void host_samples_print( host_samples_t * samples, const char * name, const char * units );
+void host_samples_free( host_samples_t * samples );
+
+// Deterministic Across Runs, Tests Print The Seed They Used
+void host_rand_seed( uint32_t seed );
+uint32_t host_rand( void );
+
+void host_check_fail( const char * file, int line, const char * cond );
+int host_check_result( const char * name );
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif //DASH_HOST_UTIL_H
@@ -0,0 +1,206 @@
+/*
+ * Replays an NMEA capture through the same path gps.c takes: line feed
+ * delimited reads into nmea_framer, then gps_nmea_type() and gps_nmea_parse()
+ * on every sentence, publishing into the counting pubsub stub.
+ *
+ *   nmea_replay [-b baud] [-r repeat] capture.nmea
+ *
+ * Without -b the capture goes through as fast as the host allows. With -b
+ * each line is held back until it would have finished arriving at that baud
+ * (10 bits a byte), so latency is measured against wire time.
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <pubsub.h>
+
+#include "nmea_framer.h"
+#include "gps_nmea.h"
+#include "timebase.h"
+#include "host_util.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+#define GPS_SENTENCE_MAX_SZ     (128)   // Same As gps.c
+#define RX_CHUNK_SZ             (128)
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+typedef struct
+    {
+    nmea_framer_t           framer;
+    char                    sentence[GPS_SENTENCE_MAX_SZ];
+    gps_fix_t               fix;
+
+    int64_t                 rx_ns;      // When The Current Line Was Read
+    int64_t                 rx_us;
+    uint32_t                type_cnt[GPS_NMEA_CNT];
+    uint32_t                unknown_cnt;
+    uint32_t                fix_cnt;
+    host_samples_t          latency_ns;
+    } replay_t;
+
+/**********************
+ *      MACROS
+ **********************/
+
+/**********************
+ *    PROTOTYPES
+ **********************/
+static char * replay_emit( void * ctx, char * sentence, size_t len );
+static void replay_feed( replay_t * replay, const uint8_t * data, size_t len );
+
+/**********************
+ *     GLOBALS
+ **********************/
+
+/**********************
+ *     CONSTANTS
+ **********************/
+static const char * const g_type_names[GPS_NMEA_CNT] =
+    {
+    [GPS_NMEA_RMC]      = "RMC",
+    [GPS_NMEA_VTG]      = "VTG",
+    [GPS_NMEA_GGA]      = "GGA",
+    [GPS_NMEA_GSA]      = "GSA",
+    [GPS_NMEA_GSV]      = "GSV",
+    };
+
+int main( int argc, char * argv[] )
+{
+    static replay_t         replay;
+    const uint8_t         * line;
+    const uint8_t         * end;
+    uint8_t               * data;
+    size_t                  len;
+    uint32_t                baud = 0;
+    uint32_t                repeat = 1;
+    int64_t                 start_ns;
+    int64_t                 wire_ns = 0;
+    double                  elapsed_s;
+    int                     opt;
+
+    while( -1 != ( opt = getopt( argc, argv, "b:r:" ) ) ) {
+        switch( opt ) {
+            case 'b':
+                baud = (uint32_t)strtoul( optarg, NULL, 0 );
+            break;
+
+            case 'r':
+                repeat = (uint32_t)strtoul( optarg, NULL, 0 );
+            break;
+
+            default:
+                fprintf( stderr, "usage: %s [-b baud] [-r repeat] capture.nmea\n", argv[0] );
+                return EXIT_FAILURE;
+        }
+    }
+
+    if( optind >= argc ) {
+        fprintf( stderr, "usage: %s [-b baud] [-r repeat] capture.nmea\n", argv[0] );
+        return EXIT_FAILURE;
+    }
+
+    data = host_load_file( argv[optind], &len );
+    if( NULL == data ) {
+        fprintf( stderr, "%s: cannot read %s\n", argv[0], argv[optind] );
+        return EXIT_FAILURE;
+    }
+
+    nmea_framer_init( &replay.framer, replay.sentence, sizeof( replay.sentence ), replay_emit, &replay );
+    host_samples_init( &replay.latency_ns, 1u << 20 );
+
+    start_ns = host_now_ns();
+    for( uint32_t r = 0; r < repeat; r++ ) {
+        // One Read Per Line Feed, Like The UART Pattern Interrupt Hands Them Out
+        for( line = data, end = data + len; line < end; ) {
+            const uint8_t     * lf = memchr( line, '\n', (size_t)( end - line ) );
+            const size_t        line_len = ( NULL != lf ) ? (size_t)( lf - line + 1 ) : (size_t)( end - line );
+
+            if( 0 != baud ) {
+                wire_ns += (int64_t)line_len * 10 * 1000000000 / baud;
+                host_sleep_until_ns( start_ns + wire_ns );
+            }
+
+            replay_feed( &replay, line, line_len );
+            line += line_len;
+        }
+    }
+    elapsed_s = (double)( host_now_ns() - start_ns ) / 1e9;
+
+    printf( "replayed %zu bytes x %u in %.3f s%s\n", len, repeat, elapsed_s, ( 0 != baud ) ? " (wire speed)" : "" );
+    printf( "sentences %u (%.0f/s), %.2f MB/s, checksum errors %u, overflows %u, resyncs %u\n",
+            replay.framer.sentence_cnt, replay.framer.sentence_cnt / elapsed_s,
+            replay.framer.byte_cnt / elapsed_s / 1e6, replay.framer.cksum_err_cnt,
+            replay.framer.overflow_cnt, replay.framer.resync_cnt );
+
+    printf( "parsed:" );
+    for( int i = 0; i < GPS_NMEA_CNT; i++ ) {
+        printf( " %s %u", g_type_names[i], replay.type_cnt[i] );
+    }
+    printf( ", other %u, fixes %u\n", replay.unknown_cnt, replay.fix_cnt );
+
+    // Read To Published, Framing Included
+    host_samples_print( &replay.latency_ns, "latency", "ns" );
+
+    printf( "published:\n" );
+    for( size_t i = 0; i < ps_stub_topic_cnt(); i++ ) {
+        const ps_stub_topic_t * topic = ps_stub_topic_at( i );
+
+        printf( "  %-16s %u\n", topic->topic, topic->cnt );
+    }
+
+    host_samples_free( &replay.latency_ns );
+    free( data );
+
+    // A Capture That Yields No Fix Means The Path Is Broken, Not The Capture
+    return ( ( 0 == replay.framer.sentence_cnt ) || ( 0 == replay.fix_cnt ) ) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+static void replay_feed( replay_t * replay, const uint8_t * data, size_t len )
+{
+    size_t                  rd_len;
+
+    // Chunked Like gps_read_chunk()
+    while( len > 0 ) {
+        rd_len = ( len < RX_CHUNK_SZ ) ? len : RX_CHUNK_SZ;
+
+        replay->rx_ns = host_now_ns();
+        replay->rx_us = timebase_now_us();
+        nmea_framer_feed( &replay->framer, data, rd_len );
+
+        data += rd_len;
+        len -= rd_len;
+    }
+}
+
+static char * replay_emit( void * ctx, char * sentence, size_t len )
+{
+    replay_t              * replay = (replay_t *)ctx;
+    int                     type;
+
+    // Every Type Is Wanted, gps.c Skips The Ones Nobody Subscribes To
+    type = gps_nmea_type( sentence, len );
+    if( type < 0 ) {
+        replay->unknown_cnt++;
+        return sentence;
+    }
+
+    replay->type_cnt[type]++;
+    if( gps_nmea_parse( type, sentence, replay->rx_us, &replay->fix ) ) {
+        replay->fix_cnt++;
+    }
+
+    host_samples_add( &replay->latency_ns, (uint32_t)( host_now_ns() - replay->rx_ns ) );
+
+    // Parsed In Place, Same Buffer Takes The Next Sentence
+    return sentence;
+}
@@ -0,0 +1,322 @@
+/*
+ * Drives speed_filter with synthetic GPS and CAN wheel speed traces and
+ * scores vehicle.speed against the true speed. The drive pulls away, runs
+ * up to 100 km/h, brakes hard, crawls and pulls away again. Each scenario
+ * changes the sources:
+ *
+ *   GPS     Fix rate, noise, the time from fix epoch to the speed being
+ *           stamped off the UART, and jitter on that
+ *   Wheel   CCVS rate, tyre scale error, bus lag
+ *   Either  A window where it drops out
+ *
+ * Timing offsets are undone the way speed_fusion.c does it, with the fixed
+ * lag constants, so jitter and any mismatch show up as error. The estimate
+ * is sampled every SPEED_FUSION_PERIOD_MS like the publish timer.
+ *
+ *   sim_speed_filter [seed]
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "gps.h"
+#include "speed_filter.h"
+#include "host_util.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+#define USEC_PER_SEC            (1000000LL)
+#define DRIVE_US                ( 70 * USEC_PER_SEC )
+#define STEP_US                 (1000)
+
+// Same As speed_fusion.c
+#define SPEED_FUSION_PERIOD_US  (20000)
+#define GPS_SPEED_LAG_US        (140000)
+#define WHEEL_SPEED_LAG_US      (10000)
+
+#define PENDING_CNT             (16)    // Must be a power of 2
+
+#define LAG_SEARCH_MIN_US       (-500000)
+#define LAG_SEARCH_MAX_US       (1000000)
+#define LAG_SEARCH_STEP_US      (10000)
+
+#define KPH( _v )               ( (int32_t)( (_v) * GPS_SPEED_SCALE ) )
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+typedef struct
+    {
+    int64_t                 period_us;      // 0 Means Not Fitted
+    int32_t                 noise;          // Standard Deviation, km/h * GPS_SPEED_SCALE
+    int64_t                 lag_us;         // Measurement To Stamped Time
+    int64_t                 jitter_us;      // +/- On lag_us
+    uint32_t                scale_q16;      // Reported / True, Wheel Only
+    int64_t                 drop_start_us;
+    int64_t                 drop_end_us;
+    } source_t;
+
+typedef struct
+    {
+    const char            * name;
+    source_t                gps;
+    source_t                wheel;
+
+    // Pass Limits, Outside Dropouts, km/h * GPS_SPEED_SCALE
+    int32_t                 p99_max;
+    int64_t                 lag_max_us;
+    } scenario_t;
+
+// Samples Measured But Not Yet Stamped, The Lag Can Span Several Periods
+typedef struct
+    {
+    int64_t                 next_us;
+    int64_t                 pending_us[PENDING_CNT];
+    int32_t                 pending_speed[PENDING_CNT];
+    uint32_t                head;
+    uint32_t                tail;
+    } source_state_t;
+
+/**********************
+ *      MACROS
+ **********************/
+
+/**********************
+ *    PROTOTYPES
+ **********************/
+static int32_t truth( int64_t t_us );
+static int32_t noise( int32_t sd );
+static bool source_dropped( const source_t * source, int64_t t_us );
+static void source_step( const source_t * source, source_state_t * state, int64_t t_us, int64_t * stamp_us, int32_t * speed, bool * ready );
+static bool run( const scenario_t * scenario );
+
+/**********************
+ *     GLOBALS
+ **********************/
+static int32_t              g_estimates[DRIVE_US / SPEED_FUSION_PERIOD_US];
+
+/**********************
+ *     CONSTANTS
+ **********************/
+// Limits Are Regression Guards, Roughly Today's Figures With Some Margin
+static const scenario_t     g_scenarios[] =
+    {
+    /*  name                        period      noise       lag         jitter  scale   drop                    p99         lag */
+    {   "gps 10 Hz",
+                                {   100000,     KPH(0.3),   140000,     20000,  0,      0,          0 },
+                                {   0 },                                                                        KPH(4),     250000 },
+    {   "gps 1 Hz",
+                                {   1000000,    KPH(0.3),   140000,     20000,  0,      0,          0 },
+                                {   0 },                                                                        KPH(25),    1000000 },
+    {   "gps 10 Hz + wheel",
+                                {   100000,     KPH(0.3),   140000,     20000,  0,      0,          0 },
+                                {   100000,     KPH(0.1),   10000,      2000,   65536,  0,          0 },        KPH(2),     120000 },
+    {   "gps 1 Hz + wheel +4%",
+                                {   1000000,    KPH(0.3),   140000,     20000,  0,      0,          0 },
+                                {   100000,     KPH(0.1),   10000,      2000,   68157,  0,          0 },        KPH(6),     120000 },
+    {   "wheel drops 20-30 s",
+                                {   100000,     KPH(0.3),   140000,     20000,  0,      0,          0 },
+                                {   100000,     KPH(0.1),   10000,      2000,   65536,  20000000,   30000000 }, KPH(4),     250000 },
+    {   "gps drops 20-30 s",
+                                {   100000,     KPH(0.3),   140000,     20000,  0,      20000000,   30000000 },
+                                {   100000,     KPH(0.1),   10000,      2000,   65536,  0,          0 },        KPH(2),     120000 },
+    {   "gps lag off by 100 ms",
+                                {   100000,     KPH(0.3),   240000,     20000,  0,      0,          0 },
+                                {   100000,     KPH(0.1),   10000,      2000,   65536,  0,          0 },        KPH(3),     150000 },
+    };
+
+#define SCENARIOS_CNT           ( sizeof(g_scenarios)/sizeof(g_scenarios[0]) )
+
+int main( int argc, char * argv[] )
+{
+    const uint32_t          seed = ( argc > 1 ) ? (uint32_t)strtoul( argv[1], NULL, 0 ) : 0x5fd;
+
+    printf( "seed 0x%x, errors in km/h * %d\n", seed, GPS_SPEED_SCALE );
+    printf( "%-22s %6s %6s %6s %6s %8s %6s %s\n", "scenario", "mean", "p90", "p99", "max", "lag ms", "stale", "scale" );
+
+    for( size_t i = 0; i < SCENARIOS_CNT; i++ ) {
+        host_rand_seed( seed + (uint32_t)i );
+        HOST_CHECK( run( &g_scenarios[i] ) );
+    }
+
+    return host_check_result( "sim_speed_filter" );
+}
+
+static bool run( const scenario_t * scenario )
+{
+    speed_filter_t          filter;
+    source_state_t          gps = { 0 };
+    source_state_t          wheel = { 0 };
+    host_samples_t          err;
+    int64_t                 stamp_us;
+    int32_t                 speed;
+    bool                    ready;
+    size_t                  est_cnt = 0;
+    uint32_t                stale_cnt = 0;
+    uint64_t                err_sum = 0;
+    int64_t                 lag_us = LAG_SEARCH_MIN_US;
+    uint64_t                lag_err_min = UINT64_MAX;
+    int64_t                 start_us = 5 * USEC_PER_SEC;
+    bool                    pass;
+
+    speed_filter_init( &filter );
+    host_samples_init( &err, DRIVE_US / SPEED_FUSION_PERIOD_US );
+
+    for( int64_t t_us = 0; t_us < DRIVE_US; t_us += STEP_US ) {
+        // Samples Reach The Filter When They Would Have Been Stamped
+        source_step( &scenario->gps, &gps, t_us, &stamp_us, &speed, &ready );
+        if( ready ) {
+            speed_filter_gps( &filter, speed, stamp_us - GPS_SPEED_LAG_US );
+        }
+
+        source_step( &scenario->wheel, &wheel, t_us, &stamp_us, &speed, &ready );
+        if( ready ) {
+            speed_filter_wheel( &filter, speed, stamp_us - WHEEL_SPEED_LAG_US );
+        }
+
+        if( 0 != ( t_us % SPEED_FUSION_PERIOD_US ) ) {
+            continue;
+        }
+
+        speed = speed_filter_estimate( &filter, t_us );
+        g_estimates[est_cnt++] = speed;
+
+        // Score Once The First Samples Are In, Skip Both Dropout Windows
+        if( ( t_us < start_us ) || source_dropped( &scenario->gps, t_us ) || source_dropped( &scenario->wheel, t_us ) ) {
+            continue;
+        }
+        if( speed < 0 ) {
+            stale_cnt++;
+            continue;
+        }
+
+        err_sum += (uint32_t)abs( speed - truth( t_us ) );
+        host_samples_add( &err, (uint32_t)abs( speed - truth( t_us ) ) );
+    }
+
+    // Effective Lag, The Shift Of The Truth That Best Matches The Output
+    for( int64_t shift_us = LAG_SEARCH_MIN_US; shift_us <= LAG_SEARCH_MAX_US; shift_us += LAG_SEARCH_STEP_US ) {
+        uint64_t    sum = 0;
+
+        for( size_t i = 0; i < est_cnt; i++ ) {
+            const int64_t   t_us = (int64_t)i * SPEED_FUSION_PERIOD_US;
+
+            if( ( t_us >= start_us ) && ( g_estimates[i] >= 0 ) ) {
+                sum += (uint32_t)abs( g_estimates[i] - truth( t_us - shift_us ) );
+            }
+        }
+        if( sum < lag_err_min ) {
+            lag_err_min = sum;
+            lag_us = shift_us;
+        }
+    }
+
+    printf( "%-22s %6u %6u %6u %6u %8d %6u %.3f\n", scenario->name,
+            ( 0 != err.cnt ) ? (unsigned)( err_sum / err.cnt ) : 0,
+            host_samples_pct( &err, 900 ), host_samples_pct( &err, 990 ), host_samples_pct( &err, 1000 ),
+            (int)( lag_us / 1000 ), stale_cnt, filter.wheel_scale / 65536.0 );
+
+    pass = ( 0 == stale_cnt ) && ( (int32_t)host_samples_pct( &err, 990 ) <= scenario->p99_max ) &&
+           ( lag_us <= scenario->lag_max_us );
+    host_samples_free( &err );
+
+    return pass;
+}
+
+static int32_t truth( int64_t t_us )
+{
+    // Segment Ends In ms, Speeds In km/h, Linear Between
+    static const struct
+        {
+        int32_t             t_ms;
+        int32_t             kph;
+        } profile[] =
+        {
+        {  0,       0 },
+        {  3000,    0 },        // Waiting
+        {  12300,   100 },      // 3 m/s^2
+        {  35000,   100 },
+        {  39600,   20 },       // Braking, ~4.8 m/s^2
+        {  48000,   20 },
+        {  52000,   60 },
+        {  60000,   60 },
+        {  66000,   0 },
+        {  70000,   0 },
+        };
+    const int32_t           t_ms = (int32_t)( t_us / 1000 );
+
+    if( t_ms <= 0 ) {
+        return 0;
+    }
+
+    for( size_t i = 1; i < sizeof( profile ) / sizeof( profile[0] ); i++ ) {
+        if( t_ms <= profile[i].t_ms ) {
+            const int32_t   span = profile[i].t_ms - profile[i - 1].t_ms;
+            const int32_t   pos = t_ms - profile[i - 1].t_ms;
+
+            return KPH( profile[i - 1].kph ) + (int32_t)( (int64_t)( KPH( profile[i].kph ) - KPH( profile[i - 1].kph ) ) * pos / span );
+        }
+    }
+
+    return 0;
+}
+
+static int32_t noise( int32_t sd )
+{
+    int32_t                 sum = 0;
+
+    // Sum Of Four Uniforms, Near Enough To Normal, Variance 4/12
+    for( int i = 0; i < 4; i++ ) {
+        sum += (int32_t)( host_rand() % 2001 ) - 1000;
+    }
+
+    return (int32_t)( (int64_t)sum * sd * 1732 / ( 1000 * 1000 * 2 ) );
+}
+
+static bool source_dropped( const source_t * source, int64_t t_us )
+{
+    return ( t_us >= source->drop_start_us ) && ( t_us < source->drop_end_us );
+}
+
+static void source_step( const source_t * source, source_state_t * state, int64_t t_us, int64_t * stamp_us, int32_t * speed, bool * ready )
+{
+    *ready = false;
+
+    if( 0 == source->period_us ) {
+        return;
+    }
+
+    // Measure At The Epoch, Deliver Once The Lag Has Passed
+    if( t_us >= state->next_us ) {
+        state->next_us += source->period_us;
+
+        if( !source_dropped( source, t_us ) ) {
+            int64_t     lag_us = source->lag_us;
+            int32_t     measured = truth( t_us ) + noise( source->noise );
+
+            if( 0 != source->jitter_us ) {
+                lag_us += (int64_t)( host_rand() % ( 2 * source->jitter_us + 1 ) ) - source->jitter_us;
+            }
+            if( 0 != source->scale_q16 ) {
+                measured = (int32_t)( ( (int64_t)measured * source->scale_q16 ) >> 16 );
+            }
+
+            // Stamps Stay In Order, A Late One Holds Up The Next
+            state->pending_us[state->head % PENDING_CNT]    = t_us + ( ( lag_us > 0 ) ? lag_us : STEP_US );
+            state->pending_speed[state->head % PENDING_CNT] = ( measured > 0 ) ? measured : 0;
+            state->head++;
+        }
+    }
+
+    if( ( state->tail != state->head ) && ( t_us >= state->pending_us[state->tail % PENDING_CNT] ) ) {
+        *stamp_us   = t_us;
+        *speed      = state->pending_speed[state->tail % PENDING_CNT];
+        *ready      = true;
+        state->tail++;
+    }
+}
@@ -0,0 +1,89 @@
+#ifndef DASH_HOST_PUBSUB_H
+#define DASH_HOST_PUBSUB_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/*
+ * Just enough of pubsub-c for the modules the host target links. Nothing is
+ * delivered, every publish is counted against its topic and released.
+ */
+#define PS_STUB_TOPICS_MAX      (32)
+
+#define FL_STICKY               (0x01)
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+typedef enum
+    {
+    PS_STUB_INT,
+    PS_STUB_BUF
+    } ps_stub_type_t;
+
+typedef struct
+    {
+    void                  * ptr;
+    size_t                  sz;
+    void                 (* dtor)( void * );
+    } ps_buf_t;
+
+typedef struct
+    {
+    const char            * topic;
+    ps_stub_type_t          type;
+    union
+        {
+        int64_t             int_val;
+        ps_buf_t            buf_val;
+        };
+    } ps_msg_t;
+
+typedef struct
+    {
+    const char            * topic;
+    uint32_t                cnt;
+    } ps_stub_topic_t;
+
+/**********************
+ *      MACROS
+ **********************/
+#define IS_INT( _m )                    ( PS_STUB_INT == (_m)->type )
+#define IS_BUF( _m )                    ( PS_STUB_BUF == (_m)->type )
+
+#define PUB_INT( _t, _v )               ps_stub_pub_int( (_t), (_v), 0 )
+#define PUB_INT_FL( _t, _v, _fl )       ps_stub_pub_int( (_t), (_v), (_fl) )
+#define PUB_BUF( _t, _p, _sz, _dtor )   ps_stub_pub_buf( (_t), (_p), (_sz), (_dtor) )
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+void ps_stub_pub_int( const char * topic, int64_t value, uint32_t flags );
+void ps_stub_pub_buf( const char * topic, void * ptr, size_t sz, void (* dtor)( void * ) );
+
+// Optional Tap, Sees Every Message Before It Is Released
+void ps_stub_set_tap( void (* tap)( const ps_msg_t * msg, void * ctx ), void * ctx );
+
+// Topics In First-Published Order
+size_t ps_stub_topic_cnt( void );
+const ps_stub_topic_t * ps_stub_topic_at( size_t idx );
+uint32_t ps_stub_pub_cnt( const char * topic );
+void ps_stub_reset( void );
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif //DASH_HOST_PUBSUB_H
@@ -0,0 +1,116 @@
+/*********************
+ *      INCLUDES
+ *********************/
+#include <string.h>
+
+#include "pubsub.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/**********************
+ *      MACROS
+ **********************/
+
+/**********************
+ *    PROTOTYPES
+ **********************/
+static void ps_stub_count( const ps_msg_t * msg );
+
+/**********************
+ *     GLOBALS
+ **********************/
+static ps_stub_topic_t      g_topics[PS_STUB_TOPICS_MAX];
+static size_t               g_topics_cnt;
+static void              (* g_tap)( const ps_msg_t * msg, void * ctx );
+static void               * g_tap_ctx;
+
+/**********************
+ *     CONSTANTS
+ **********************/
+
+void ps_stub_pub_int( const char * topic, int64_t value, uint32_t flags )
+{
+    ps_msg_t                msg = { .topic = topic, .type = PS_STUB_INT, .int_val = value };
+
+    ps_stub_count( &msg );
+}
+
+void ps_stub_pub_buf( const char * topic, void * ptr, size_t sz, void (* dtor)( void * ) )
+{
+    ps_msg_t                msg = { .topic = topic, .type = PS_STUB_BUF };
+
+    msg.buf_val.ptr     = ptr;
+    msg.buf_val.sz      = sz;
+    msg.buf_val.dtor    = dtor;
+    ps_stub_count( &msg );
+
+    // Nobody Holds A Reference, Release Like The Last Unref Would
+    if( NULL != dtor ) {
+        dtor( ptr );
+    }
+}
+
+void ps_stub_set_tap( void (* tap)( const ps_msg_t * msg, void * ctx ), void * ctx )
+{
+    g_tap       = tap;
+    g_tap_ctx   = ctx;
+}
+
+size_t ps_stub_topic_cnt( void )
+{
+    return g_topics_cnt;
+}
+
+const ps_stub_topic_t * ps_stub_topic_at( size_t idx )
+{
+    return ( idx < g_topics_cnt ) ? &g_topics[idx] : NULL;
+}
+
+uint32_t ps_stub_pub_cnt( const char * topic )
+{
+    for( size_t i = 0; i < g_topics_cnt; i++ ) {
+        if( 0 == strcmp( g_topics[i].topic, topic ) ) {
+            return g_topics[i].cnt;
+        }
+    }
+
+    return 0;
+}
+
+void ps_stub_reset( void )
+{
+    memset( g_topics, 0, sizeof( g_topics ) );
+    g_topics_cnt = 0;
+}
+
+static void ps_stub_count( const ps_msg_t * msg )
+{
+    size_t                  i;
+
+    if( NULL != g_tap ) {
+        g_tap( msg, g_tap_ctx );
+    }
+
+    // Topics Are String Literals At Every Call Site, Compare By Content Anyway
+    for( i = 0; i < g_topics_cnt; i++ ) {
+        if( 0 == strcmp( g_topics[i].topic, msg->topic ) ) {
+            break;
+        }
+    }
+
+    if( i == g_topics_cnt ) {
+        if( PS_STUB_TOPICS_MAX == g_topics_cnt ) {
+            return;
+        }
+        g_topics[i].topic = msg->topic;
+        g_topics_cnt++;
+    }
+
+    g_topics[i].cnt++;
+}
@@ -0,0 +1,204 @@
+/*
+ * clock_fmt_update() against strftime("%I:%M:%S %p") on localtime_r(),
+ * second by second across DST transitions, plus how often the TZ rules
+ * get walked in zones with and without DST.
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "clock_fmt.h"
+#include "host_util.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+#define SEC_PER_DAY             (86400)
+#define SEC_PER_YEAR            ( 365 * SEC_PER_DAY )
+#define WINDOW_S                (2 * 3600)  // Checked Every Second Either Side Of A Transition
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+
+/**********************
+ *      MACROS
+ **********************/
+
+/**********************
+ *    PROTOTYPES
+ **********************/
+static void zone_set( const char * tz );
+static bool text_matches( const clock_fmt_t * fmt, int64_t utc );
+static void check_transition( int64_t utc, const char * before, const char * after );
+static void test_cst6cdt( void );
+static void test_no_dst( const char * tz );
+static void test_southern( void );
+static void test_step_back( void );
+
+/**********************
+ *     GLOBALS
+ **********************/
+
+/**********************
+ *     CONSTANTS
+ **********************/
+
+// 2026, Second Sunday In March At 02:00 CST And First Sunday In November At 02:00 CDT
+#define CST_SPRING_2026         (1772956800LL)  // 2026-03-08 08:00:00 UTC
+#define CST_FALL_2026           (1793516400LL)  // 2026-11-01 07:00:00 UTC
+
+int main( int argc, char * argv[] )
+{
+    test_cst6cdt();
+    test_no_dst( "UTC0" );
+    test_no_dst( "JST-9" );
+    test_southern();
+    test_step_back();
+
+    return host_check_result( "test_clock_fmt" );
+}
+
+static void test_cst6cdt( void )
+{
+    clock_fmt_t             fmt;
+    uint32_t                rule_cnt;
+
+    zone_set( "CST6CDT,M3.2.0,M11.1.0" );
+
+    // The Hour Skipped And The Hour Repeated
+    check_transition( CST_SPRING_2026, "01:59:59 AM", "03:00:00 AM" );
+    check_transition( CST_FALL_2026, "01:59:59 AM", "01:00:00 AM" );
+
+    // A Year A Second At A Time Walks The Rules Once, Then Once Per Transition
+    clock_fmt_init( &fmt );
+    for( int64_t utc = CST_SPRING_2026 - SEC_PER_DAY; utc < CST_SPRING_2026 - SEC_PER_DAY + SEC_PER_YEAR; utc++ ) {
+        clock_fmt_update( &fmt, utc );
+
+        // Spot Checks, strftime() Every Second Would Dominate The Run
+        if( 0 == ( utc % 997 ) ) {
+            HOST_CHECK( text_matches( &fmt, utc ) );
+        }
+    }
+    rule_cnt = fmt.rule_cnt;
+    HOST_CHECK( 3 == rule_cnt );
+    printf( "CST6CDT: %u rule walks over a year\n", rule_cnt );
+}
+
+static void test_no_dst( const char * tz )
+{
+    clock_fmt_t             fmt;
+    const int64_t           start = CST_SPRING_2026 - 12345;
+
+    zone_set( tz );
+    clock_fmt_init( &fmt );
+
+    // No Transition To Find, The Whole Search Window Is Good
+    clock_fmt_update( &fmt, start );
+    HOST_CHECK( 1 == fmt.rule_cnt );
+    HOST_CHECK( fmt.valid_until >= ( start + SEC_PER_YEAR ) );
+
+    // Not Searched Again Day To Day
+    for( int64_t utc = start; utc < start + 3 * SEC_PER_DAY; utc++ ) {
+        clock_fmt_update( &fmt, utc );
+        if( 0 == ( utc % 311 ) ) {
+            HOST_CHECK( text_matches( &fmt, utc ) );
+        }
+    }
+    HOST_CHECK( 1 == fmt.rule_cnt );
+
+    // Only Once The Window Runs Out
+    clock_fmt_update( &fmt, fmt.valid_until );
+    HOST_CHECK( 2 == fmt.rule_cnt );
+    HOST_CHECK( text_matches( &fmt, fmt.valid_from ) );
+
+    printf( "%s: valid for %lld days per rule walk\n", tz, (long long)( ( fmt.valid_until - fmt.valid_from ) / SEC_PER_DAY ) );
+}
+
+static void test_southern( void )
+{
+    // DST Over The Year End, Ends 03:00 AEDT First Sunday Of April, Starts 02:00 AEST First Sunday Of October
+    zone_set( "AEST-10AEDT,M10.1.0,M4.1.0/3" );
+
+    check_transition( 1775318400LL, "02:59:59 AM", "02:00:00 AM" );    // 2026-04-04 16:00:00 UTC
+    check_transition( 1791043200LL, "01:59:59 AM", "03:00:00 AM" );    // 2026-10-03 16:00:00 UTC
+}
+
+static void test_step_back( void )
+{
+    clock_fmt_t             fmt;
+
+    zone_set( "CST6CDT,M3.2.0,M11.1.0" );
+    clock_fmt_init( &fmt );
+
+    // Clock Set Back Over A Transition, Offset Must Be Worked Out Again
+    clock_fmt_update( &fmt, CST_FALL_2026 + 600 );
+    HOST_CHECK( text_matches( &fmt, CST_FALL_2026 + 600 ) );
+    clock_fmt_update( &fmt, CST_FALL_2026 - 600 );
+    HOST_CHECK( text_matches( &fmt, CST_FALL_2026 - 600 ) );
+    HOST_CHECK( 2 == fmt.rule_cnt );
+
+    // Random Jumps Across Years, Every One Still Right
+    host_rand_seed( 0xc10c );
+    for( int i = 0; i < 20000; i++ ) {
+        const int64_t   utc = 946684800LL + host_rand() % ( 37u * SEC_PER_YEAR );  // 2000 To 2037
+
+        clock_fmt_update( &fmt, utc );
+        HOST_CHECK( text_matches( &fmt, utc ) );
+    }
+}
+
+static void zone_set( const char * tz )
+{
+    setenv( "TZ", tz, 1 );
+    tzset();
+}
+
+static bool text_matches( const clock_fmt_t * fmt, int64_t utc )
+{
+    const time_t            t = (time_t)utc;
+    struct tm               tm;
+    char                    want[CLOCK_FMT_TEXT_SZ];
+
+    localtime_r( &t, &tm );
+    strftime( want, sizeof( want ), "%I:%M:%S %p", &tm );
+
+    if( 0 != strcmp( want, fmt->text ) ) {
+        fprintf( stderr, "%lld (TZ %s): got \"%s\", want \"%s\"\n", (long long)utc, getenv( "TZ" ), fmt->text, want );
+        return false;
+    }
+
+    return true;
+}
+
+static void check_transition( int64_t utc, const char * before, const char * after )
+{
+    clock_fmt_t             fmt;
+    uint32_t                mismatch_cnt = 0;
+
+    clock_fmt_init( &fmt );
+
+    // Every Second Through The Transition Goes Through The Patch Path
+    for( int64_t t = utc - WINDOW_S; t < utc + WINDOW_S; t++ ) {
+        clock_fmt_update( &fmt, t );
+
+        if( !text_matches( &fmt, t ) ) {
+            mismatch_cnt++;
+        }
+        if( ( utc - 1 ) == t ) {
+            HOST_CHECK( 0 == strcmp( before, fmt.text ) );
+            HOST_CHECK( utc == fmt.valid_until );
+        }
+        else if( utc == t ) {
+            HOST_CHECK( 0 == strcmp( after, fmt.text ) );
+        }
+    }
+
+    HOST_CHECK( 0 == mismatch_cnt );
+    HOST_CHECK( 2 == fmt.rule_cnt );
+}
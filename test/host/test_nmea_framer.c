@@ -0,0 +1,392 @@
+/*
+ * nmea_framer_feed() against generated streams: random chunk boundaries,
+ * bad and missing checksums, sentences cut short by the next '$', bodies
+ * past the buffer and line noise. Ends with a sentences/s figure.
+ *
+ *   test_nmea_framer [seed]
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "nmea_framer.h"
+#include "host_util.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+#define SENTENCE_BUF_SZ         (128)   // Same As gps.c
+#define SENTENCE_CNT            (2000)
+#define STREAM_MAX_SZ           ( SENTENCE_CNT * 2 * SENTENCE_BUF_SZ )
+#define BENCH_PASSES            (200)
+#define BENCH_CHUNK_SZ          (128)
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+typedef struct
+    {
+    char                    text[SENTENCE_BUF_SZ];
+    size_t                  len;
+    } expect_t;
+
+// What The Emit Callback Saw, Checked Against What Went In
+typedef struct
+    {
+    char                    slots[2][SENTENCE_BUF_SZ];
+    unsigned                slot;
+    const expect_t        * expect;
+    size_t                  expect_cnt;
+    size_t                  seen_cnt;
+    uint32_t                mismatch_cnt;
+    } sink_t;
+
+typedef struct
+    {
+    uint8_t               * data;
+    size_t                  len;
+    } stream_t;
+
+/**********************
+ *      MACROS
+ **********************/
+
+/**********************
+ *    PROTOTYPES
+ **********************/
+static char * sink_emit( void * ctx, char * sentence, size_t len );
+static void sink_init( sink_t * sink, nmea_framer_t * framer, const expect_t * expect, size_t expect_cnt );
+static size_t sentence_make( char * buf, size_t body_len );
+static void stream_add( stream_t * stream, const void * data, size_t len );
+static void feed_random( nmea_framer_t * framer, const stream_t * stream, size_t max_chunk );
+static void test_clean_stream( void );
+static void test_bad_checksums( void );
+static void test_resync( void );
+static void test_overflow( void );
+static void test_noise( void );
+static void bench( void );
+
+/**********************
+ *     GLOBALS
+ **********************/
+static expect_t             g_expect[SENTENCE_CNT];
+static uint8_t              g_stream_buf[STREAM_MAX_SZ];
+
+/**********************
+ *     CONSTANTS
+ **********************/
+
+int main( int argc, char * argv[] )
+{
+    const uint32_t          seed = ( argc > 1 ) ? (uint32_t)strtoul( argv[1], NULL, 0 ) : 0x5eed;
+
+    printf( "seed 0x%x\n", seed );
+    host_rand_seed( seed );
+
+    test_clean_stream();
+    test_bad_checksums();
+    test_resync();
+    test_overflow();
+    test_noise();
+    bench();
+
+    return host_check_result( "test_nmea_framer" );
+}
+
+static void test_clean_stream( void )
+{
+    nmea_framer_t           framer;
+    sink_t                  sink;
+    stream_t                stream = { g_stream_buf, 0 };
+
+    for( size_t i = 0; i < SENTENCE_CNT; i++ ) {
+        g_expect[i].len = sentence_make( g_expect[i].text, 6 + host_rand() % 70 );
+        stream_add( &stream, g_expect[i].text, g_expect[i].len );
+        stream_add( &stream, "\r\n", 2 );
+    }
+
+    // Any Split Of The Same Bytes Frames The Same Sentences
+    for( size_t max_chunk = 1; max_chunk <= 257; max_chunk += 16 ) {
+        sink_init( &sink, &framer, g_expect, SENTENCE_CNT );
+        feed_random( &framer, &stream, max_chunk );
+
+        HOST_CHECK( SENTENCE_CNT == sink.seen_cnt );
+        HOST_CHECK( 0 == sink.mismatch_cnt );
+        HOST_CHECK( SENTENCE_CNT == framer.sentence_cnt );
+        HOST_CHECK( 0 == framer.cksum_err_cnt );
+        HOST_CHECK( 0 == framer.resync_cnt );
+        HOST_CHECK( 0 == framer.overflow_cnt );
+        HOST_CHECK( stream.len == framer.byte_cnt );
+    }
+}
+
+static void test_bad_checksums( void )
+{
+    nmea_framer_t           framer;
+    sink_t                  sink;
+    stream_t                stream = { g_stream_buf, 0 };
+    size_t                  good_cnt = 0;
+    uint32_t                bad_cnt = 0;
+    char                    text[SENTENCE_BUF_SZ];
+    size_t                  len;
+
+    for( size_t i = 0; i < SENTENCE_CNT; i++ ) {
+        len = sentence_make( text, 6 + host_rand() % 70 );
+
+        switch( host_rand() % 8 ) {
+            case 0:
+                // Wrong Value, Still Hex
+                text[len - 1] = ( '0' == text[len - 1] ) ? '1' : '0';
+                bad_cnt++;
+            break;
+
+            case 1:
+                // Not Hex At All
+                text[len - 2] = 'G';
+                bad_cnt++;
+            break;
+
+            case 2:
+                // Line Ends Before Any Checksum
+                len -= 3;
+                bad_cnt++;
+            break;
+
+            case 3:
+                // Lower Case Digits Are Still Valid
+                for( size_t j = len - 2; j < len; j++ ) {
+                    if( ( text[j] >= 'A' ) && ( text[j] <= 'F' ) ) {
+                        text[j] = (char)( text[j] - 'A' + 'a' );
+                    }
+                }
+                // Fall Through
+
+            default:
+                memcpy( &g_expect[good_cnt], text, len );
+                g_expect[good_cnt].text[len] = '\0';
+                g_expect[good_cnt].len = len;
+                good_cnt++;
+            break;
+        }
+
+        stream_add( &stream, text, len );
+        stream_add( &stream, "\r\n", 2 );
+    }
+
+    sink_init( &sink, &framer, g_expect, good_cnt );
+    feed_random( &framer, &stream, 64 );
+
+    HOST_CHECK( good_cnt == sink.seen_cnt );
+    HOST_CHECK( 0 == sink.mismatch_cnt );
+    HOST_CHECK( bad_cnt == framer.cksum_err_cnt );
+}
+
+static void test_resync( void )
+{
+    nmea_framer_t           framer;
+    sink_t                  sink;
+    stream_t                stream = { g_stream_buf, 0 };
+    size_t                  good_cnt = 0;
+    uint32_t                cut_cnt = 0;
+    char                    text[SENTENCE_BUF_SZ];
+    size_t                  len;
+
+    for( size_t i = 0; i < SENTENCE_CNT; i++ ) {
+        len = sentence_make( text, 6 + host_rand() % 70 );
+
+        if( 0 == ( host_rand() % 4 ) ) {
+            // Receiver Restarted Mid-Sentence, No Line End Before The Next '$'
+            stream_add( &stream, text, 1 + host_rand() % ( len - 4 ) );
+            cut_cnt++;
+            continue;
+        }
+
+        g_expect[good_cnt].len = len;
+        memcpy( g_expect[good_cnt].text, text, len + 1 );
+        good_cnt++;
+
+        stream_add( &stream, text, len );
+        stream_add( &stream, "\r\n", 2 );
+    }
+
+    sink_init( &sink, &framer, g_expect, good_cnt );
+    feed_random( &framer, &stream, 33 );
+
+    // A Cut On The Last Sentence Has Nothing After It To Resync On
+    HOST_CHECK( good_cnt == sink.seen_cnt );
+    HOST_CHECK( 0 == sink.mismatch_cnt );
+    HOST_CHECK( ( cut_cnt == framer.resync_cnt ) || ( ( cut_cnt - 1 ) == framer.resync_cnt ) );
+    HOST_CHECK( 0 == framer.cksum_err_cnt );
+}
+
+static void test_overflow( void )
+{
+    nmea_framer_t           framer;
+    sink_t                  sink;
+    stream_t                stream = { g_stream_buf, 0 };
+    char                    text[4 * SENTENCE_BUF_SZ];
+    size_t                  len;
+
+    // Longest Body That Still Fits, Then One Past It
+    for( int i = 0; i < 2; i++ ) {
+        g_expect[i].len = sentence_make( g_expect[i].text, SENTENCE_BUF_SZ - 4 - 1 );
+    }
+    stream_add( &stream, g_expect[0].text, g_expect[0].len );
+    stream_add( &stream, "\r\n", 2 );
+
+    memset( text, 'X', sizeof( text ) );
+    text[0] = '$';
+    len = 3 * SENTENCE_BUF_SZ;
+    stream_add( &stream, text, len );
+    stream_add( &stream, "*00\r\n", 5 );
+
+    stream_add( &stream, g_expect[1].text, g_expect[1].len );
+    stream_add( &stream, "\r\n", 2 );
+
+    sink_init( &sink, &framer, g_expect, 2 );
+    feed_random( &framer, &stream, 40 );
+
+    HOST_CHECK( 2 == sink.seen_cnt );
+    HOST_CHECK( 0 == sink.mismatch_cnt );
+    HOST_CHECK( 1 == framer.overflow_cnt );
+}
+
+static void test_noise( void )
+{
+    nmea_framer_t           framer;
+    sink_t                  sink;
+    stream_t                stream = { g_stream_buf, 0 };
+    uint8_t                 noise[64];
+
+    for( size_t i = 0; i < SENTENCE_CNT / 4; i++ ) {
+        // Wrong Baud Garbage, Minus Anything That Would Start A Sentence
+        for( size_t j = 0; j < sizeof( noise ); j++ ) {
+            noise[j] = (uint8_t)host_rand();
+            if( '$' == noise[j] ) {
+                noise[j] = 0;
+            }
+        }
+        stream_add( &stream, noise, host_rand() % sizeof( noise ) );
+
+        g_expect[i].len = sentence_make( g_expect[i].text, 6 + host_rand() % 70 );
+        stream_add( &stream, g_expect[i].text, g_expect[i].len );
+        stream_add( &stream, "\r\n", 2 );
+    }
+
+    sink_init( &sink, &framer, g_expect, SENTENCE_CNT / 4 );
+    feed_random( &framer, &stream, 100 );
+
+    HOST_CHECK( ( SENTENCE_CNT / 4 ) == sink.seen_cnt );
+    HOST_CHECK( 0 == sink.mismatch_cnt );
+}
+
+static void bench( void )
+{
+    nmea_framer_t           framer;
+    sink_t                  sink;
+    stream_t                stream = { g_stream_buf, 0 };
+    int64_t                 start_ns;
+    double                  elapsed_s;
+
+    // Sizes Close To A Real RMC/GGA Mix
+    for( size_t i = 0; i < SENTENCE_CNT; i++ ) {
+        g_expect[i].len = sentence_make( g_expect[i].text, 40 + host_rand() % 40 );
+        stream_add( &stream, g_expect[i].text, g_expect[i].len );
+        stream_add( &stream, "\r\n", 2 );
+    }
+
+    sink_init( &sink, &framer, NULL, 0 );
+    start_ns = host_now_ns();
+    for( int pass = 0; pass < BENCH_PASSES; pass++ ) {
+        for( size_t pos = 0; pos < stream.len; pos += BENCH_CHUNK_SZ ) {
+            const size_t    len = ( ( stream.len - pos ) < BENCH_CHUNK_SZ ) ? ( stream.len - pos ) : BENCH_CHUNK_SZ;
+
+            nmea_framer_feed( &framer, &stream.data[pos], len );
+        }
+    }
+    elapsed_s = (double)( host_now_ns() - start_ns ) / 1e9;
+
+    HOST_CHECK( ( SENTENCE_CNT * BENCH_PASSES ) == framer.sentence_cnt );
+    printf( "framer: %.0f sentences/s, %.1f MB/s, %.0f ns/sentence\n",
+            framer.sentence_cnt / elapsed_s, framer.byte_cnt / elapsed_s / 1e6,
+            elapsed_s * 1e9 / framer.sentence_cnt );
+}
+
+static char * sink_emit( void * ctx, char * sentence, size_t len )
+{
+    sink_t                * sink = (sink_t *)ctx;
+
+    if( NULL != sink->expect ) {
+        if( ( sink->seen_cnt >= sink->expect_cnt ) ||
+            ( len != sink->expect[sink->seen_cnt].len ) ||
+            ( 0 != strcmp( sentence, sink->expect[sink->seen_cnt].text ) ) ) {
+            sink->mismatch_cnt++;
+        }
+    }
+    sink->seen_cnt++;
+
+    // Alternate Buffers Like The Slot Ring Does
+    sink->slot ^= 1;
+    return sink->slots[sink->slot];
+}
+
+static void sink_init( sink_t * sink, nmea_framer_t * framer, const expect_t * expect, size_t expect_cnt )
+{
+    memset( sink, 0, sizeof( *sink ) );
+    sink->expect        = expect;
+    sink->expect_cnt    = expect_cnt;
+
+    nmea_framer_init( framer, sink->slots[0], sizeof( sink->slots[0] ), sink_emit, sink );
+}
+
+static size_t sentence_make( char * buf, size_t body_len )
+{
+    static const char       alphabet[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ.,-";
+    uint8_t                 cksum = 0;
+    size_t                  len = 0;
+
+    buf[len++] = '$';
+    memcpy( &buf[len], "GP", 2 );
+    len += 2;
+    while( len < ( body_len + 1 ) ) {
+        buf[len++] = alphabet[host_rand() % ( sizeof( alphabet ) - 1 )];
+    }
+    for( size_t i = 1; i < len; i++ ) {
+        cksum ^= (uint8_t)buf[i];
+    }
+
+    len += (size_t)sprintf( &buf[len], "*%02X", cksum );
+
+    return len;
+}
+
+static void stream_add( stream_t * stream, const void * data, size_t len )
+{
+    if( ( stream->len + len ) > STREAM_MAX_SZ ) {
+        HOST_CHECK( !"stream buffer too small" );
+        return;
+    }
+
+    memcpy( &stream->data[stream->len], data, len );
+    stream->len += len;
+}
+
+static void feed_random( nmea_framer_t * framer, const stream_t * stream, size_t max_chunk )
+{
+    size_t                  pos = 0;
+    size_t                  len;
+
+    while( pos < stream->len ) {
+        len = 1 + host_rand() % max_chunk;
+        if( len > ( stream->len - pos ) ) {
+            len = stream->len - pos;
+        }
+
+        nmea_framer_feed( framer, &stream->data[pos], len );
+        pos += len;
+    }
+}
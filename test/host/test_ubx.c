@@ -0,0 +1,383 @@
+/*
+ * ubx_parser_feed() and ubx_nav_pvt_decode() against hand-built frames:
+ * random class, ID and length mixed with NMEA text, fed in random chunks,
+ * plus bad checksums, lengths past UBX_PAYLOAD_MAX_SZ and the NAV-PVT and
+ * MGA-INI field layouts.
+ *
+ *   test_ubx [seed]
+ */
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "ubx.h"
+#include "host_util.h"
+
+/*********************
+ *      DEFINES
+ *********************/
+#define FRAME_CNT               (1000)
+#define FRAME_MAX_SZ            ( UBX_HDR_SZ + UBX_PAYLOAD_MAX_SZ + UBX_CKSUM_SZ )
+#define STREAM_MAX_SZ           ( FRAME_CNT * ( FRAME_MAX_SZ + 80 ) )
+
+/**********************
+ *      TYPEDEFS
+ **********************/
+typedef struct
+    {
+    uint8_t                 cls;
+    uint8_t                 id;
+    uint16_t                len;
+    uint8_t                 payload[UBX_PAYLOAD_MAX_SZ];
+    } expect_t;
+
+typedef struct
+    {
+    const expect_t        * expect;
+    size_t                  expect_cnt;
+    size_t                  seen_cnt;
+    uint32_t                mismatch_cnt;
+    } sink_t;
+
+/**********************
+ *      MACROS
+ **********************/
+#define put_u2( _p, _off, _v )  do { ( _p )[_off] = (uint8_t)( _v ); ( _p )[( _off ) + 1] = (uint8_t)( ( _v ) >> 8 ); } while( 0 )
+#define put_u4( _p, _off, _v )  do { put_u2( _p, _off, (uint32_t)( _v ) ); put_u2( _p, ( _off ) + 2, (uint32_t)( _v ) >> 16 ); } while( 0 )
+
+/**********************
+ *    PROTOTYPES
+ **********************/
+static void sink_frame( void * ctx, uint8_t cls, uint8_t id, const uint8_t * payload, uint16_t len );
+static void expect_random( expect_t * expect );
+static size_t stream_frame( uint8_t * stream, size_t pos, const expect_t * expect );
+static void feed_random( ubx_parser_t * parser, const uint8_t * stream, size_t len, size_t max_chunk );
+static void test_stream( void );
+static void test_bad_checksums( void );
+static void test_oversize( void );
+static void test_nav_pvt( void );
+static void test_fix_status( void );
+static void test_mga_ini( void );
+
+/**********************
+ *     GLOBALS
+ **********************/
+static expect_t             g_expect[FRAME_CNT];
+static uint8_t              g_stream[STREAM_MAX_SZ];
+
+/**********************
+ *     CONSTANTS
+ **********************/
+static const char           g_nmea[] = "$GPGGA,174205.00,4458.6680,N,09315.9000,W,1,10,0.92,256.4,M,-31.2,M,,*6B\r\n";
+
+int main( int argc, char * argv[] )
+{
+    const uint32_t          seed = ( argc > 1 ) ? (uint32_t)strtoul( argv[1], NULL, 0 ) : 0x0b10;
+
+    printf( "seed 0x%x\n", seed );
+    host_rand_seed( seed );
+
+    test_stream();
+    test_bad_checksums();
+    test_oversize();
+    test_nav_pvt();
+    test_fix_status();
+    test_mga_ini();
+
+    return host_check_result( "test_ubx" );
+}
+
+static void test_stream( void )
+{
+    ubx_parser_t            parser;
+    sink_t                  sink = { .expect = g_expect, .expect_cnt = FRAME_CNT };
+    size_t                  len = 0;
+
+    // Receiver Set To UBX + NMEA Out, Text Lands Between Frames
+    for( size_t i = 0; i < FRAME_CNT; i++ ) {
+        expect_random( &g_expect[i] );
+        len = stream_frame( g_stream, len, &g_expect[i] );
+
+        if( 0 == ( host_rand() % 3 ) ) {
+            memcpy( &g_stream[len], g_nmea, sizeof( g_nmea ) - 1 );
+            len += sizeof( g_nmea ) - 1;
+        }
+    }
+
+    for( size_t max_chunk = 1; max_chunk <= 513; max_chunk += 64 ) {
+        ubx_parser_init( &parser, sink_frame, &sink );
+        sink.seen_cnt       = 0;
+        sink.mismatch_cnt   = 0;
+
+        feed_random( &parser, g_stream, len, max_chunk );
+
+        HOST_CHECK( FRAME_CNT == sink.seen_cnt );
+        HOST_CHECK( 0 == sink.mismatch_cnt );
+        HOST_CHECK( FRAME_CNT == parser.frame_cnt );
+        HOST_CHECK( 0 == parser.cksum_err_cnt );
+        HOST_CHECK( 0 == parser.oversize_cnt );
+    }
+}
+
+static void test_bad_checksums( void )
+{
+    ubx_parser_t            parser;
+    sink_t                  sink = { .expect = g_expect };
+    expect_t                frame;
+    size_t                  len = 0;
+    size_t                  start;
+    uint32_t                bad_cnt = 0;
+
+    for( size_t i = 0; i < FRAME_CNT; i++ ) {
+        expect_random( &frame );
+        start = len;
+        len = stream_frame( g_stream, len, &frame );
+
+        // Flip A Bit In Either Checksum Byte Or Anything They Cover, Except
+        // The Length, Which Would Move Where The Frame Ends
+        if( 0 == ( host_rand() % 4 ) ) {
+            size_t          covered = start + 2 + (size_t)( host_rand() % ( len - start - 2 ) );
+
+            if( ( ( start + 4 ) == covered ) || ( ( start + 5 ) == covered ) ) {
+                covered = len - 1;
+            }
+            g_stream[covered] ^= (uint8_t)( 1u << ( host_rand() % 8 ) );
+            bad_cnt++;
+            continue;
+        }
+
+        g_expect[sink.expect_cnt++] = frame;
+    }
+
+    ubx_parser_init( &parser, sink_frame, &sink );
+    feed_random( &parser, g_stream, len, 200 );
+
+    HOST_CHECK( sink.expect_cnt == sink.seen_cnt );
+    HOST_CHECK( 0 == sink.mismatch_cnt );
+    HOST_CHECK( bad_cnt == parser.cksum_err_cnt );
+}
+
+static void test_oversize( void )
+{
+    ubx_parser_t            parser;
+    sink_t                  sink = { .expect = g_expect };
+    expect_t                frame;
+    size_t                  len = 0;
+    uint16_t                bad_len;
+    uint32_t                oversize_cnt = 0;
+
+    for( size_t i = 0; i < FRAME_CNT / 4; i++ ) {
+        expect_random( &frame );
+        g_expect[sink.expect_cnt++] = frame;
+        len = stream_frame( g_stream, len, &frame );
+
+        // Length Past The Payload Buffer, Then That Many Bytes Of Body
+        bad_len = (uint16_t)( UBX_PAYLOAD_MAX_SZ + 1 + host_rand() % 512 );
+        g_stream[len++] = UBX_SYNC_1;
+        g_stream[len++] = UBX_SYNC_2;
+        g_stream[len++] = UBX_CLASS_MGA;
+        g_stream[len++] = UBX_MGA_DBD;
+        put_u2( g_stream, len, bad_len );
+        len += 2;
+        for( uint16_t j = 0; j < bad_len + UBX_CKSUM_SZ; j++ ) {
+            // Body Never Holds A Sync, So Nothing In It Can Frame
+            g_stream[len++] = (uint8_t)( host_rand() % UBX_SYNC_1 );
+        }
+        oversize_cnt++;
+    }
+
+    ubx_parser_init( &parser, sink_frame, &sink );
+    feed_random( &parser, g_stream, len, 300 );
+
+    HOST_CHECK( sink.expect_cnt == sink.seen_cnt );
+    HOST_CHECK( 0 == sink.mismatch_cnt );
+    HOST_CHECK( oversize_cnt == parser.oversize_cnt );
+    HOST_CHECK( 0 == parser.cksum_err_cnt );
+}
+
+static void test_nav_pvt( void )
+{
+    uint8_t                 payload[UBX_NAV_PVT_SZ] = { 0 };
+    gps_fix_t               fix;
+    struct tm               tm = { .tm_year = 2026 - 1900, .tm_mon = 3 - 1, .tm_mday = 18,
+                                   .tm_hour = 17, .tm_min = 42, .tm_sec = 5 };
+
+    put_u2( payload, 4, 2026 );
+    payload[6]  = 3;
+    payload[7]  = 18;
+    payload[8]  = 17;
+    payload[9]  = 42;
+    payload[10] = 5;
+    payload[11] = 0x07;                     // Date, Time, Fully Resolved
+    put_u4( payload, 16, -12345678 );       // nano
+    payload[20] = 3;                        // 3D
+    payload[21] = 0x01;                     // gnssFixOK
+    payload[23] = 14;
+    put_u4( payload, 24, -932650000 );      // lon
+    put_u4( payload, 28, 449778000 );       // lat
+    put_u4( payload, 32, 225200 );          // height, Not Used
+    put_u4( payload, 36, 256400 );          // hMSL
+    put_u4( payload, 60, 27000 );           // gSpeed mm/s
+    put_u4( payload, 64, 8700000 );         // headMot 1e-5 deg
+    put_u2( payload, 76, 161 );             // pDOP
+
+    memset( &fix, 0xAA, sizeof( fix ) );
+    HOST_CHECK( ubx_nav_pvt_decode( payload, sizeof( payload ), &fix ) );
+    HOST_CHECK( (uint32_t)timegm( &tm ) == fix.time );
+    HOST_CHECK( -12345678 == fix.nano );
+    HOST_CHECK( 449778000 == fix.lat );
+    HOST_CHECK( -932650000 == fix.lon );
+    HOST_CHECK( 256400 == fix.alt );
+    HOST_CHECK( 27000 == fix.speed );
+    HOST_CHECK( 8700000 == fix.heading );
+    HOST_CHECK( 3 == fix.fix_type );
+    HOST_CHECK( 14 == fix.num_sats );
+    HOST_CHECK( 161 == fix.pdop );
+    HOST_CHECK( ( GPS_FIX_FLAG_FIX_OK | GPS_FIX_FLAG_TIME_VALID ) == fix.flags );
+
+    // Date Without Time Is Not A Usable Time
+    payload[11] = 0x01;
+    payload[21] = 0x00;
+    HOST_CHECK( ubx_nav_pvt_decode( payload, sizeof( payload ), &fix ) );
+    HOST_CHECK( 0 == fix.flags );
+
+    // Short Payloads Are Refused, Longer Ones (Later Protocol Versions) Are Not
+    HOST_CHECK( !ubx_nav_pvt_decode( payload, UBX_NAV_PVT_SZ - 1, &fix ) );
+    HOST_CHECK( !ubx_nav_pvt_decode( payload, 0, &fix ) );
+}
+
+static void test_fix_status( void )
+{
+    static const struct
+        {
+        uint8_t             pvt_fix;
+        uint8_t             fix_type;
+        } cases[] =
+        {
+        { 0, GPS_FIX_TYPE_NONE },
+        { 1, GPS_FIX_TYPE_NONE },           // Dead Reckoning Only
+        { 2, GPS_FIX_TYPE_2D },
+        { 3, GPS_FIX_TYPE_3D },
+        { 4, GPS_FIX_TYPE_3D },             // GNSS + Dead Reckoning
+        { 5, GPS_FIX_TYPE_NONE },           // Time Only
+        };
+    gps_fix_t               fix = { 0 };
+    gps_fix_status_t        status;
+
+    fix.num_sats    = 9;
+    fix.pdop        = 250;
+    fix.t_us        = 1234;
+    fix.flags       = GPS_FIX_FLAG_FIX_OK;
+
+    for( size_t i = 0; i < sizeof( cases ) / sizeof( cases[0] ); i++ ) {
+        fix.fix_type = cases[i].pvt_fix;
+        ubx_fix_status( &fix, &status );
+
+        HOST_CHECK( cases[i].fix_type == status.fix_type );
+        HOST_CHECK( 1 == status.quality );
+        HOST_CHECK( 9 == status.sats_used );
+        HOST_CHECK( 250 == status.pdop );
+        HOST_CHECK( 0 == status.hdop );
+        HOST_CHECK( 1234 == status.t_us );
+    }
+}
+
+static void test_mga_ini( void )
+{
+    uint8_t                 payload[UBX_MGA_INI_TIME_UTC_SZ];
+    uint8_t                 frame[UBX_HDR_SZ + UBX_MGA_INI_TIME_UTC_SZ + UBX_CKSUM_SZ];
+    struct tm               tm;
+    time_t                  utc;
+
+    // Civil Date Round Trip Across Leap Days And Centuries
+    for( int i = 0; i < 2000; i++ ) {
+        utc = (time_t)( host_rand() % 4102444800u );    // Up To 2100
+        gmtime_r( &utc, &tm );
+
+        ubx_mga_ini_time_utc( payload, (uint32_t)utc, 2 );
+        HOST_CHECK( ( tm.tm_year + 1900 ) == ( payload[4] | ( payload[5] << 8 ) ) );
+        HOST_CHECK( ( tm.tm_mon + 1 ) == payload[6] );
+        HOST_CHECK( tm.tm_mday == payload[7] );
+        HOST_CHECK( tm.tm_hour == payload[8] );
+        HOST_CHECK( tm.tm_min == payload[9] );
+        HOST_CHECK( tm.tm_sec == payload[10] );
+        HOST_CHECK( (uint32_t)utc == gps_utc_to_epoch( tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday,
+                                                       tm.tm_hour, tm.tm_min, tm.tm_sec ) );
+    }
+
+    ubx_mga_ini_pos_llh( payload, 449778000, -932650000, 256400, 1000000 );
+    HOST_CHECK( 0x01 == payload[0] );
+    HOST_CHECK( 25640 == (int32_t)( payload[12] | ( payload[13] << 8 ) | ( payload[14] << 16 ) | ( (uint32_t)payload[15] << 24 ) ) );
+
+    // Frame Must Fit Whole Or Not At All
+    HOST_CHECK( 0 == ubx_frame_build( frame, sizeof( frame ) - 1, UBX_CLASS_MGA, UBX_MGA_INI, payload, UBX_MGA_INI_TIME_UTC_SZ ) );
+    HOST_CHECK( sizeof( frame ) == ubx_frame_build( frame, sizeof( frame ), UBX_CLASS_MGA, UBX_MGA_INI, payload, UBX_MGA_INI_TIME_UTC_SZ ) );
+
+    // MGA-DBD Poll, No Payload At All
+    static const uint8_t    poll[] = { 0xB5, 0x62, 0x13, 0x80, 0x00, 0x00, 0x93, 0xCC };
+    HOST_CHECK( sizeof( poll ) == ubx_frame_build( frame, sizeof( frame ), UBX_CLASS_MGA, UBX_MGA_DBD, NULL, 0 ) );
+    HOST_CHECK( 0 == memcmp( frame, poll, sizeof( poll ) ) );
+}
+
+static void sink_frame( void * ctx, uint8_t cls, uint8_t id, const uint8_t * payload, uint16_t len )
+{
+    sink_t                * sink = (sink_t *)ctx;
+    const expect_t        * expect = &sink->expect[sink->seen_cnt];
+
+    if( ( sink->seen_cnt >= sink->expect_cnt ) || ( cls != expect->cls ) || ( id != expect->id ) ||
+        ( len != expect->len ) || ( 0 != memcmp( payload, expect->payload, len ) ) ) {
+        sink->mismatch_cnt++;
+    }
+    sink->seen_cnt++;
+}
+
+static void expect_random( expect_t * expect )
+{
+    expect->cls = (uint8_t)host_rand();
+    expect->id  = (uint8_t)host_rand();
+
+    // Zero Length Polls, Full Size MGA-DBD Entries And Everything Between
+    switch( host_rand() % 4 ) {
+        case 0:
+            expect->len = 0;
+        break;
+
+        case 1:
+            expect->len = UBX_PAYLOAD_MAX_SZ;
+        break;
+
+        default:
+            expect->len = (uint16_t)( host_rand() % ( UBX_PAYLOAD_MAX_SZ + 1 ) );
+        break;
+    }
+
+    for( uint16_t i = 0; i < expect->len; i++ ) {
+        expect->payload[i] = (uint8_t)host_rand();
+    }
+}
+
+static size_t stream_frame( uint8_t * stream, size_t pos, const expect_t * expect )
+{
+    return pos + ubx_frame_build( &stream[pos], STREAM_MAX_SZ - pos, expect->cls, expect->id, expect->payload, expect->len );
+}
+
+static void feed_random( ubx_parser_t * parser, const uint8_t * stream, size_t len, size_t max_chunk )
+{
+    size_t                  pos = 0;
+    size_t                  cnt;
+
+    while( pos < len ) {
+        cnt = 1 + host_rand() % max_chunk;
+        if( cnt > ( len - pos ) ) {
+            cnt = len - pos;
+        }
+
+        ubx_parser_feed( parser, &stream[pos], cnt );
+        pos += cnt;
+    }
+}
@@ -0,0 +1,144 @@
+#!/usr/bin/env python3
+"""
+Build the J1939 signal table (main/can_signals_table.h) from a CSV file.
+
+    tools/can_signals_build.py main/can_signals.csv can_signals_table.h
+
+Run by the build whenever the CSV changes. Columns are described at the top
+of main/can_signals.csv, the table layout in main/can_signals.h.
+"""
+import argparse
+import csv
+import os
+import sys
+from fractions import Fraction
+
+PER_PGN_MAX = 32                # CAN_SIGNALS_PER_PGN_MAX
+PGN_MAX = 0x3FFFF
+PDU2_PF = 240
+INT32_MAX = 0x7FFFFFFF
+
+
+def raw_max(bits):
+    """Highest valid raw value, J1939-71 reserves the rest for error / not available."""
+    if bits < 8:
+        return (1 << bits) - 3 if bits > 1 else 1
+    return (0xFA << (bits - 8)) | ((1 << (bits - 8)) - 1)
+
+
+def parse(lines):
+    rows = csv.DictReader(line for line in lines if line.strip() and not line.lstrip().startswith("#"))
+    sigs = []
+    for row in rows:
+        where = "line %d (%s)" % (rows.line_num, row.get("topic", "?"))
+        try:
+            pgn = int(row["pgn"], 0)
+            spn = int(row["spn"], 0)
+            start_bit = int(row["start_bit"])
+            bits = int(row["bits"])
+            scale = Fraction(row["scale"].strip())
+            offset = Fraction(row["offset"].strip())
+            pub_scale = int(row["pub_scale"])
+            # Optional, Blank Or Missing Is 0
+            deadband = Fraction((row.get("deadband") or "0").strip())
+            stale_ms = int((row.get("stale_ms") or "0").strip())
+        except (KeyError, ValueError, TypeError) as err:
+            raise ValueError("%s: %s" % (where, err))
+
+        topic = row["topic"].strip()
+        units = row["units"].strip()
+
+        if not 0 <= pgn <= PGN_MAX or (((pgn >> 8) & 0xFF) < PDU2_PF and pgn & 0xFF):
+            raise ValueError("%s: bad PGN %d" % (where, pgn))
+        if not 1 <= bits <= 32 or start_bit < 0 or start_bit + bits > 64:
+            raise ValueError("%s: bits %d..%d outside the 8 data bytes" % (where, start_bit, start_bit + bits - 1))
+        if scale <= 0 or pub_scale <= 0:
+            raise ValueError("%s: scale and pub_scale must be positive" % where)
+        if deadband < 0 or not 0 <= stale_ms <= 0xFFFF:
+            raise ValueError("%s: deadband must be positive, stale_ms 0..65535" % where)
+
+        # Published Value Is raw * num / den + off, All Exact Integers
+        ratio = scale * pub_scale
+        off = offset * pub_scale
+        band = deadband * pub_scale
+        if off.denominator != 1 or band.denominator != 1:
+            raise ValueError("%s: offset %s or deadband %s is not whole at pub_scale %d"
+                             % (where, offset, deadband, pub_scale))
+        if max(ratio.numerator, ratio.denominator, abs(off.numerator), band.numerator) > INT32_MAX:
+            raise ValueError("%s: scale does not fit 32 bits at pub_scale %d" % (where, pub_scale))
+
+        sigs.append(dict(pgn=pgn, spn=spn, topic=topic, units=units, start_bit=start_bit, bits=bits,
+                         raw_max=raw_max(bits), num=ratio.numerator, den=ratio.denominator,
+                         offset=off.numerator, pub_scale=pub_scale, deadband=band.numerator, stale_ms=stale_ms))
+
+    sigs.sort(key=lambda s: (s["pgn"], s["start_bit"]))
+
+    pgns = []
+    for i, sig in enumerate(sigs):
+        if pgns and pgns[-1][0] == sig["pgn"]:
+            pgns[-1][2] += 1
+        else:
+            pgns.append([sig["pgn"], i, 1])
+    for pgn, _, cnt in pgns:
+        if cnt > PER_PGN_MAX:
+            raise ValueError("PGN %d has %d signals, at most %d" % (pgn, cnt, PER_PGN_MAX))
+
+    if not sigs:
+        raise ValueError("no signals")
+    return sigs, pgns
+
+
+def c_str(text):
+    return '"%s"' % text.replace("\\", "\\\\").replace('"', '\\"')
+
+
+def render(sigs, pgns, source):
+    out = []
+    out.append("// Generated by tools/can_signals_build.py from %s, do not edit" % source)
+    out.append("#ifndef DASH_CAN_SIGNALS_TABLE_H")
+    out.append("#define DASH_CAN_SIGNALS_TABLE_H")
+    out.append("")
+    out.append("#define CAN_SIGNALS_CNT         (%d)" % len(sigs))
+    out.append("#define CAN_SIGNAL_PGNS_CNT     (%d)" % len(pgns))
+    out.append("")
+    out.append("static const can_signal_t g_can_signals[CAN_SIGNALS_CNT] =")
+    out.append("    {")
+    out.append("    /*  pgn     spn     topic / units                   start   bits    raw_max         num     den     offset    pub_scale   deadband    stale_ms */")
+    for s in sigs:
+        cols = ["%d," % s["pgn"], "%d," % s["spn"], c_str(s["topic"]) + ", " + c_str(s["units"]) + ",",
+                "%d," % s["start_bit"], "%d," % s["bits"], "0x%08X," % s["raw_max"],
+                "%d," % s["num"], "%d," % s["den"], "%d," % s["offset"], "%d," % s["pub_scale"], "%d," % s["deadband"]]
+        widths = [8, 8, 32, 8, 8, 16, 8, 8, 10, 12, 12]
+        out.append("    {   %s%d }," % ("".join((c + " ").ljust(w) for c, w in zip(cols, widths)), s["stale_ms"]))
+    out.append("    };")
+    out.append("")
+    out.append("// Sorted By PGN, Looked Up With bsearch()")
+    out.append("static const can_signal_pgn_t g_can_signal_pgns[CAN_SIGNAL_PGNS_CNT] =")
+    out.append("    {")
+    out.append("    /*  pgn     first   cnt */")
+    for pgn, first, cnt in pgns:
+        out.append("    {   %s%s%d }," % (("%d," % pgn).ljust(8), ("%d," % first).ljust(8), cnt))
+    out.append("    };")
+    out.append("")
+    out.append("#endif //DASH_CAN_SIGNALS_TABLE_H")
+    return "\n".join(out) + "\n"
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("input", help="signal definitions, CSV")
+    parser.add_argument("output", help="header to write")
+    args = parser.parse_args()
+
+    try:
+        with open(args.input, newline="") as f:
+            sigs, pgns = parse(f)
+    except ValueError as err:
+        sys.exit("%s: %s" % (args.input, err))
+
+    with open(args.output, "w") as f:
+        f.write(render(sigs, pgns, os.path.basename(args.input)))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,242 @@
+#!/usr/bin/env python3
+"""
+Build the "geo" partition image (speed limits and geofences) from JSON.
+
+    tools/geo_build.py tools/geo_sample.json geo.bin
+    parttool.py --port /dev/ttyUSB0 write_partition --partition-name geo --input geo.bin
+
+Check what the dash would see at a position, with the same lookup the
+firmware runs:
+
+    tools/geo_build.py tools/geo_sample.json geo.bin --query 30.2700 -97.7420
+
+Input is {"cell_m": .., "match_m": .., "roads": [..], "fences": [..]}. A road
+has "points" ([lat, lon] pairs) and "speed_limit_mph" or "speed_limit_kph",
+a fence has an "id" (non-zero) and "points". Layout is described in
+main/geo_index.h.
+"""
+import argparse
+import json
+import math
+import struct
+import sys
+import zlib
+
+GEO_INDEX_MAGIC = 0x314F4547
+GEO_INDEX_VERSION = 1
+GEO_REF_FENCE = 0x80000000
+
+HDR_FMT = "<IHHII iiiHHHH IIIIIIIII".replace(" ", "")
+SEG_FMT = "<iiiiHH"
+FENCE_FMT = "<IIHHiiii"
+VERT_FMT = "<ii"
+
+M_PER_UNIT = 0.011131949        # Metres Per 1e-7 deg Of Latitude
+SPEED_SCALE = 100               # GPS_SPEED_SCALE
+KPH_PER_MPH = 1.609344
+
+
+def to_units(deg):
+    return int(round(deg * 1e7))
+
+
+def road_segments(roads):
+    """Flatten roads into (lat0, lon0, lat1, lon1, speed_limit) tuples."""
+    segs = []
+    for road in roads:
+        if "speed_limit_kph" in road:
+            limit = road["speed_limit_kph"] * SPEED_SCALE
+        else:
+            limit = road.get("speed_limit_mph", 0) * KPH_PER_MPH * SPEED_SCALE
+        limit = int(round(limit))
+        if not 0 <= limit <= 0xFFFF:
+            raise ValueError("speed limit out of range on %s" % road.get("name", "road"))
+
+        pts = [(to_units(lat), to_units(lon)) for lat, lon in road["points"]]
+        for (lat0, lon0), (lat1, lon1) in zip(pts, pts[1:]):
+            segs.append((lat0, lon0, lat1, lon1, limit))
+    return segs
+
+
+def fence_polygons(fences):
+    """Return (id, [(lat, lon), ..]) sorted smallest area first."""
+    polys = []
+    for fence in fences:
+        if not fence["id"]:
+            raise ValueError("fence id 0 means no fence")
+        pts = [(to_units(lat), to_units(lon)) for lat, lon in fence["points"]]
+        if len(pts) > 1 and pts[0] == pts[-1]:
+            pts.pop()
+        if len(pts) < 3:
+            raise ValueError("fence %d needs 3 points" % fence["id"])
+        area = abs(sum(a[1] * b[0] - b[1] * a[0] for a, b in zip(pts, pts[1:] + pts[:1])))
+        polys.append((area, fence["id"], pts))
+    polys.sort(key=lambda p: p[0])
+    return [(fid, pts) for _, fid, pts in polys]
+
+
+def build(data):
+    cell_m = data.get("cell_m", 500)
+    match_m = data.get("match_m", 30)
+    segs = road_segments(data.get("roads", []))
+    fences = fence_polygons(data.get("fences", []))
+
+    lats = [s[0] for s in segs] + [s[2] for s in segs] + [p[0] for _, pts in fences for p in pts]
+    lons = [s[1] for s in segs] + [s[3] for s in segs] + [p[1] for _, pts in fences for p in pts]
+    if not lats:
+        raise ValueError("no roads or fences")
+
+    # Road Cells Cover Everything Within match_m, Widest Where The Meridians Are Furthest Apart
+    cos_min = math.cos(math.radians(max(abs(min(lats)), abs(max(lats))) * 1e-7))
+    lat_margin = int(math.ceil(match_m / M_PER_UNIT))
+    lon_margin = int(math.ceil(match_m / (M_PER_UNIT * cos_min)))
+    cell_sz = int(round(cell_m / M_PER_UNIT))
+
+    lat0 = min(lats) - lat_margin
+    lon0 = min(lons) - lon_margin
+    rows = (max(lats) + lat_margin - lat0) // cell_sz + 1
+    cols = (max(lons) + lon_margin - lon0) // cell_sz + 1
+    if rows > 0xFFFF or cols > 0xFFFF:
+        raise ValueError("grid too large, raise cell_m")
+
+    def cells_in(lat_lo, lat_hi, lon_lo, lon_hi):
+        r0 = max((lat_lo - lat0) // cell_sz, 0)
+        r1 = min((lat_hi - lat0) // cell_sz, rows - 1)
+        c0 = max((lon_lo - lon0) // cell_sz, 0)
+        c1 = min((lon_hi - lon0) // cell_sz, cols - 1)
+        for r in range(r0, r1 + 1):
+            for c in range(c0, c1 + 1):
+                yield r * cols + c
+
+    cell_refs = [[] for _ in range(rows * cols)]
+    for i, (la0, lo0, la1, lo1, _) in enumerate(segs):
+        for cell in cells_in(min(la0, la1) - lat_margin, max(la0, la1) + lat_margin,
+                             min(lo0, lo1) - lon_margin, max(lo0, lo1) + lon_margin):
+            cell_refs[cell].append(i)
+    for i, (_, pts) in enumerate(fences):
+        for cell in cells_in(min(p[0] for p in pts), max(p[0] for p in pts),
+                             min(p[1] for p in pts), max(p[1] for p in pts)):
+            cell_refs[cell].append(i | GEO_REF_FENCE)
+
+    cells = []
+    refs = []
+    for lst in cell_refs:
+        cells.append(len(refs))
+        refs.extend(lst)
+    cells.append(len(refs))
+
+    verts = []
+    fence_recs = []
+    for fid, pts in fences:
+        fence_recs.append(struct.pack(FENCE_FMT, fid, len(verts), len(pts), 0,
+                                      min(p[0] for p in pts), max(p[0] for p in pts),
+                                      min(p[1] for p in pts), max(p[1] for p in pts)))
+        verts.extend(pts)
+
+    blobs = [
+        struct.pack("<%dI" % len(cells), *cells),
+        struct.pack("<%dI" % len(refs), *refs),
+        b"".join(struct.pack(SEG_FMT, *s, 0) for s in segs),
+        b"".join(fence_recs),
+        b"".join(struct.pack(VERT_FMT, *v) for v in verts),
+    ]
+
+    offs = []
+    pos = struct.calcsize(HDR_FMT)
+    for blob in blobs:
+        offs.append(pos)
+        pos += (len(blob) + 3) & ~3
+    size = pos
+
+    def header(crc):
+        return struct.pack(HDR_FMT, GEO_INDEX_MAGIC, GEO_INDEX_VERSION, struct.calcsize(HDR_FMT), size, crc,
+                           lat0, lon0, cell_sz, rows, cols, match_m, 0,
+                           offs[0], offs[1], len(refs), offs[2], len(segs),
+                           offs[3], len(fences), offs[4], len(verts))
+
+    body = b"".join(blob + b"\0" * (-len(blob) % 4) for blob in blobs)
+    crc = zlib.crc32(header(0) + body) & 0xFFFFFFFF
+    return header(crc) + body
+
+
+def lookup(image, lat, lon):
+    """Mirror of geo_index_lookup(), returns (speed_limit, seg, dist_m, fence_id)."""
+    hdr = struct.unpack_from(HDR_FMT, image)
+    (_, _, _, _, _, lat0, lon0, cell_sz, rows, cols, match_m, _,
+     cells_off, refs_off, _, segs_off, _, fences_off, _, verts_off, _) = hdr
+
+    row = (lat - lat0) // cell_sz
+    col = (lon - lon0) // cell_sz
+    if lat < lat0 or lon < lon0 or row >= rows or col >= cols:
+        return 0, -1, 0, 0
+
+    cell = row * cols + col
+    start, end = struct.unpack_from("<II", image, cells_off + 4 * cell)
+    m_per_lon = M_PER_UNIT * math.cos(math.radians(lat * 1e-7))
+    best = float(match_m * match_m)
+    seg = -1
+    fence_id = 0
+
+    for i in range(start, end):
+        ref, = struct.unpack_from("<I", image, refs_off + 4 * i)
+        if ref & GEO_REF_FENCE:
+            ref &= ~GEO_REF_FENCE
+            fid, vidx, vcnt, _, la_lo, la_hi, lo_lo, lo_hi = struct.unpack_from(
+                FENCE_FMT, image, fences_off + struct.calcsize(FENCE_FMT) * ref)
+            if fence_id or not (la_lo <= lat <= la_hi and lo_lo <= lon <= lo_hi):
+                continue
+            pts = [struct.unpack_from(VERT_FMT, image, verts_off + 8 * (vidx + k)) for k in range(vcnt)]
+            inside = False
+            for k in range(vcnt):
+                vi, vj = pts[k], pts[k - 1]
+                if (vi[0] > lat) != (vj[0] > lat):
+                    lhs = (lon - vj[1]) * (vi[0] - vj[0])
+                    rhs = (lat - vj[0]) * (vi[1] - vj[1])
+                    if (lhs < rhs) if vi[0] > vj[0] else (lhs > rhs):
+                        inside = not inside
+            if inside:
+                fence_id = fid
+        else:
+            la0, lo0, la1, lo1, _, _ = struct.unpack_from(SEG_FMT, image, segs_off + struct.calcsize(SEG_FMT) * ref)
+            ax, ay = (lo0 - lon) * m_per_lon, (la0 - lat) * M_PER_UNIT
+            dx, dy = (lo1 - lo0) * m_per_lon, (la1 - la0) * M_PER_UNIT
+            len2 = dx * dx + dy * dy
+            t = min(max(-(ax * dx + ay * dy) / len2, 0.0), 1.0) if len2 > 0 else 0.0
+            px, py = ax + t * dx, ay + t * dy
+            if px * px + py * py < best:
+                best = px * px + py * py
+                seg = ref
+
+    if seg < 0:
+        return 0, -1, 0, fence_id
+    limit = struct.unpack_from(SEG_FMT, image, segs_off + struct.calcsize(SEG_FMT) * seg)[4]
+    return limit, seg, int(math.sqrt(best)), fence_id
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("input", help="JSON dataset")
+    parser.add_argument("output", help="partition image to write")
+    parser.add_argument("--partition-size", type=lambda v: int(v, 0), default=0x40000,
+                        help="fail if the image does not fit (default 0x40000)")
+    parser.add_argument("--query", nargs=2, type=float, action="append", metavar=("LAT", "LON"),
+                        help="look a position up in the new image, may be repeated")
+    args = parser.parse_args()
+
+    with open(args.input) as f:
+        image = build(json.load(f))
+    if len(image) > args.partition_size:
+        sys.exit("image is %d bytes, partition holds %d" % (len(image), args.partition_size))
+
+    with open(args.output, "wb") as f:
+        f.write(image)
+    print("%s: %d bytes" % (args.output, len(image)), file=sys.stderr)
+
+    for lat, lon in args.query or []:
+        limit, seg, dist_m, fence_id = lookup(image, to_units(lat), to_units(lon))
+        print("%.7f,%.7f limit %.2f km/h (%.1f mph) seg %d at %d m fence %d" %
+              (lat, lon, limit / SPEED_SCALE, limit / SPEED_SCALE / KPH_PER_MPH, seg, dist_m, fence_id))
+
+
+if __name__ == "__main__":
+    main()
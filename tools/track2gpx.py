@@ -0,0 +1,123 @@
+#!/usr/bin/env python3
+"""
+Decode a dump of the "track" partition into GPX.
+
+    parttool.py --port /dev/ttyUSB0 read_partition --partition-name track --output track.bin
+    tools/track2gpx.py track.bin > track.gpx
+
+Layout is described in main/track_log.h.
+"""
+import argparse
+import datetime
+import struct
+import sys
+
+TRACK_LOG_MAGIC = 0x324B5254
+SECTOR_SZ = 4096
+PAGE_SZ = 256
+SECTOR_HDR_SZ = 8
+LEN_PAD = 0xFF
+
+
+def read_varint(buf, pos):
+    val = 0
+    shift = 0
+    while True:
+        byte = buf[pos]
+        pos += 1
+        val |= (byte & 0x7F) << shift
+        shift += 7
+        if byte < 0x80:
+            break
+    # Zigzag
+    return (val >> 1) ^ -(val & 1), pos
+
+
+def decode_sector(sector):
+    """Yield (time_cs, lat, lon, speed_cms) for each record in one sector."""
+    prev = [0, 0, 0, 0]
+    step = [0, 0, 0, 0]
+    first = True
+    pos = SECTOR_HDR_SZ
+
+    while pos < SECTOR_SZ:
+        length = sector[pos]
+        if length == LEN_PAD:
+            # Rest Of The Page Is Padding, Or Never Written
+            pos = (pos // PAGE_SZ + 1) * PAGE_SZ
+            continue
+
+        end = pos + 1 + length
+        pos += 1
+        vals = []
+        while pos < end:
+            val, pos = read_varint(sector, pos)
+            vals.append(val)
+        if len(vals) != 4:
+            raise ValueError("bad record length")
+
+        # Values Are Corrections To The Last Step, Which Stays Zero After The First Record
+        delta = [s + v for s, v in zip(step, vals)]
+        prev = [p + d for p, d in zip(prev, delta)]
+        if not first:
+            step = delta
+        first = False
+        yield tuple(prev)
+
+
+def decode(image):
+    sectors = []
+    for off in range(0, len(image) - SECTOR_SZ + 1, SECTOR_SZ):
+        magic, seq = struct.unpack_from("<II", image, off)
+        if magic == TRACK_LOG_MAGIC:
+            sectors.append((seq, image[off:off + SECTOR_SZ]))
+
+    # Ring Order Is Sequence Order
+    for seq, sector in sorted(sectors):
+        try:
+            yield from decode_sector(sector)
+        except (IndexError, ValueError):
+            print("sector %u: truncated record, skipped rest" % seq, file=sys.stderr)
+
+
+def write_gpx(points, out, gap_s):
+    out.write('<?xml version="1.0" encoding="UTF-8"?>\n')
+    out.write('<gpx version="1.1" creator="Dash track2gpx" xmlns="http://www.topografix.com/GPX/1/1">\n')
+    out.write("<trk><name>Dash</name>\n")
+
+    last_cs = None
+    open_seg = False
+    for time_cs, lat, lon, speed_cms in points:
+        # Long Gaps Start A New Segment
+        if last_cs is None or (time_cs - last_cs) > gap_s * 100:
+            if open_seg:
+                out.write("</trkseg>\n")
+            out.write("<trkseg>\n")
+            open_seg = True
+        last_cs = time_cs
+
+        stamp = datetime.datetime.fromtimestamp(time_cs / 100.0, tz=datetime.timezone.utc)
+        out.write('<trkpt lat="%.7f" lon="%.7f"><time>%s</time><extensions><speed>%.2f</speed></extensions></trkpt>\n' % (
+            lat / 1e7, lon / 1e7, stamp.strftime("%Y-%m-%dT%H:%M:%S.%fZ"), speed_cms / 100.0))
+
+    if open_seg:
+        out.write("</trkseg>\n")
+    out.write("</trk>\n</gpx>\n")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("image", help="raw dump of the track partition")
+    parser.add_argument("-o", "--output", help="GPX file, default stdout")
+    parser.add_argument("--gap", type=float, default=10.0, help="seconds without fixes that split segments")
+    args = parser.parse_args()
+
+    with open(args.image, "rb") as f:
+        image = f.read()
+
+    out = open(args.output, "w") if args.output else sys.stdout
+    write_gpx(decode(image), out, args.gap)
+
+
+if __name__ == "__main__":
+    main()